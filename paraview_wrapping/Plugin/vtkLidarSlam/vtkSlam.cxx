@@ -1639,6 +1639,33 @@ void vtkSlam::SetOverlapSamplingRatio(double ratio)
   }
 }
 
+//-----------------------------------------------------------------------------
+int vtkSlam::GetOverlapEstimator()
+{
+  int overlapMode = static_cast<int>(this->SlamAlgo->GetOverlapEstimator());
+  vtkDebugMacro(<< "Returning OverlapEstimator of " << overlapMode);
+  return overlapMode;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlam::SetOverlapEstimator(int mode)
+{
+  LidarSlam::OverlapMode overlapMode = static_cast<LidarSlam::OverlapMode>(mode);
+  if (overlapMode != LidarSlam::OverlapMode::LCP &&
+      overlapMode != LidarSlam::OverlapMode::MATCHING &&
+      overlapMode != LidarSlam::OverlapMode::VOXEL_OCCUPANCY)
+  {
+    vtkErrorMacro(<< "Invalid overlap estimator mode (" << mode << "), ignoring setting.");
+    return;
+  }
+  vtkDebugMacro(<< "Setting OverlapEstimator to " << mode);
+  if (this->SlamAlgo->GetOverlapEstimator() != overlapMode)
+  {
+    this->SlamAlgo->SetOverlapEstimator(overlapMode);
+    this->ParametersModificationTime.Modified();
+  }
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlam::SetAccelerationLimits(float linearAcc, float angularAcc)
 {
@@ -168,6 +168,9 @@ public:
   vtkCustomGetMacro(NbThreads, int)
   vtkCustomSetMacro(NbThreads, int)
 
+  vtkCustomGetMacro(InputDownsamplingLeafSize, double)
+  vtkCustomSetMacro(InputDownsamplingLeafSize, double)
+
   virtual int GetEgoMotion();
   virtual void SetEgoMotion(int mode);
 
@@ -215,6 +218,12 @@ public:
   vtkCustomGetMacro(NbGraphIterations, int)
   vtkCustomSetMacro(NbGraphIterations, int)
 
+  vtkCustomGetMacro(IncrementalGraph, bool)
+  vtkCustomSetMacro(IncrementalGraph, bool)
+
+  vtkCustomGetMacro(GraphKeyframesOnly, bool)
+  vtkCustomSetMacro(GraphKeyframesOnly, bool)
+
   vtkCustomGetMacro(PGOConstraintLOOP_CLOSURE, bool)
   vtkCustomSetMacro(PGOConstraintLOOP_CLOSURE, bool)
 
@@ -249,6 +258,13 @@ public:
   vtkCustomGetMacro(LCRevisitedWindowEndRange, int)
   vtkCustomSetMacro(LCRevisitedWindowEndRange, int)
 
+  // Get/Set automatic loop closure detection parameters
+  vtkCustomGetMacro(LoopDetectionMinIndexGap, unsigned int)
+  vtkCustomSetMacro(LoopDetectionMinIndexGap, unsigned int)
+
+  vtkCustomGetMacro(LoopDetectionMaxDistance, double)
+  vtkCustomSetMacro(LoopDetectionMaxDistance, double)
+
   // Get/Set Loop closure registration parameters
   vtkCustomGetMacro(EnableLoopClosureOffset, bool)
   vtkCustomSetMacro(EnableLoopClosureOffset, bool)
@@ -478,6 +494,9 @@ public:
   vtkCustomGetMacro(OverlapSamplingRatio, double)
   virtual void SetOverlapSamplingRatio (double ratio);
 
+  virtual int GetOverlapEstimator();
+  virtual void SetOverlapEstimator(int mode);
+
   // Motion constraints
   virtual void SetAccelerationLimits(float linearAcc, float angularAcc);
   virtual void SetVelocityLimits(float linearVel, float angularVel);
@@ -0,0 +1,55 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "VelodyneToLidarNode.h"
+#include "OusterToLidarNode.h"
+#include "RobosenseToLidarNode.h"
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace lidar_conversions
+{
+
+/**
+ * @class ConversionNodelet wraps a conversion node to run it inside a nodelet
+ * manager.
+ */
+template<typename ConversionNode>
+class ConversionNodelet : public nodelet::Nodelet
+{
+private:
+  void onInit() override
+  {
+    // The node stores references to the node handles, which are owned by the nodelet.
+    this->Node.reset(new ConversionNode(this->getNodeHandle(), this->getPrivateNodeHandle()));
+  }
+
+  std::unique_ptr<ConversionNode> Node;
+};
+
+using VelodyneToLidarNodelet = ConversionNodelet<VelodyneToLidarNode>;
+using OusterToLidarNodelet = ConversionNodelet<OusterToLidarNode>;
+using RobosenseToLidarNodelet = ConversionNodelet<RobosenseToLidarNode>;
+
+}  // end of namespace lidar_conversions
+
+PLUGINLIB_EXPORT_CLASS(lidar_conversions::VelodyneToLidarNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(lidar_conversions::OusterToLidarNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(lidar_conversions::RobosenseToLidarNodelet, nodelet::Nodelet)
@@ -31,6 +31,7 @@ OusterToLidarNode::OusterToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& priv_
 {
   // Get laser ID mapping
   this->PrivNh.param("laser_id_mapping", this->LaserIdMapping, this->LaserIdMapping);
+  this->LaserIdLut = Utils::BuildLaserIdLut(this->LaserIdMapping);
 
   //  Get LiDAR id
   this->PrivNh.param("device_id", this->DeviceId, this->DeviceId);
@@ -39,6 +40,9 @@ OusterToLidarNode::OusterToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& priv_
   this->PrivNh.param("rpm", this->Rpm, this->Rpm);
   this->PrivNh.param("timestamp_first_packet", this->TimestampFirstPacket, this->TimestampFirstPacket);
 
+  // Get number of threads used to convert large clouds
+  this->PrivNh.param("nb_threads", this->NbThreads, this->NbThreads);
+
   // Init ROS publisher
   this->Talker = nh.advertise<CloudS>("lidar_points", 1);
 
@@ -49,73 +53,71 @@ OusterToLidarNode::OusterToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& priv_
 }
 
 //------------------------------------------------------------------------------
-void OusterToLidarNode::Callback(const CloudV& cloudO)
+void OusterToLidarNode::Callback(const sensor_msgs::PointCloud2& cloudO)
 {
   // If input cloud is empty, ignore it
-  if (cloudO.empty())
+  if (cloudO.width * cloudO.height == 0)
+  {
+    ROS_ERROR_STREAM("Input Ouster pointcloud is empty : frame ignored.");
+    return;
+  }
+
+  // Check that all points can be read from the message data
+  if (!Utils::IsDataLayoutValid(cloudO))
   {
-    ROS_ERROR_STREAM("Input Velodyne pointcloud is empty : frame ignored.");
+    ROS_ERROR_STREAM("Input Ouster pointcloud has an invalid data layout (row step, data size or byte order) : frame ignored.");
+    return;
+  }
+
+  // Look up input fields once
+  Utils::PointField x, y, z, reflectivity, ring;
+  if (!x.Init(cloudO, "x") || !y.Init(cloudO, "y") || !z.Init(cloudO, "z") ||
+      !reflectivity.Init(cloudO, "reflectivity") || !ring.Init(cloudO, "ring"))
+  {
+    ROS_ERROR_STREAM("Input Ouster pointcloud misses some required fields (x, y, z, reflectivity, ring) : frame ignored.");
     return;
   }
 
   // Init SLAM pointcloud
-  CloudS cloudS;
-  cloudS.reserve(cloudO.size());
+  CloudS::Ptr cloudSPtr(new CloudS);
+  CloudS& cloudS = *cloudSPtr;
 
   // Copy pointcloud metadata
   Utils::CopyPointCloudMetadata(cloudO, cloudS);
 
-  // Check wether to use custom laser ID mapping or leave it untouched
-  bool useLaserIdMapping = !this->LaserIdMapping.empty();
-
-  // Helper to estimate frameAdvancement in case time field is invalid
-  Utils::SpinningFrameAdvancementEstimator frameAdvancementEstimator;
-
   // Build SLAM pointcloud
-  for (const PointO& ousterPoint : cloudO)
+  Utils::ConvertPoints(cloudO, cloudS, this->NbThreads,
+    [&](unsigned int, const uint8_t* data, PointS& slamPoint)
+    {
+      slamPoint.x = x.Get<float>(data);
+      slamPoint.y = y.Get<float>(data);
+      slamPoint.z = z.Get<float>(data);
+
+      // Remove no return points
+      if (slamPoint.getVector3fMap().norm() < 1e-3)
+        return false;
+
+      slamPoint.intensity = reflectivity.Get<float>(data);
+      slamPoint.laser_id = Utils::LookUpLaserId(this->LaserIdLut, ring.Get<unsigned int>(data));
+      slamPoint.device_id = this->DeviceId;
+      return true;
+    });
+
+  // Build approximate point-wise timestamp from azimuth angle
+  // 'frameAdvancement' is 0 for first point, and should match 1 for last point
+  // for a 360 degrees scan at ideal spinning frequency.
+  // 'time' is the offset to add to 'header.stamp' to get approximate point-wise timestamp.
+  // By default, 'header.stamp' is the timestamp of the last Veloydne packet,
+  // but user can choose the first packet timestamp using parameter 'timestamp_first_packet'.
+  // This estimation relies on the previous points of each ring, so it is done sequentially.
+  Utils::SpinningFrameAdvancementEstimator frameAdvancementEstimator;
+  for (PointS& slamPoint : cloudS)
   {
-    // Remove no return points
-    if (ousterPoint.getVector3fMap().norm() < 1e-3)
-      continue;
-
-    PointS slamPoint;
-    slamPoint.x = ousterPoint.x;
-    slamPoint.y = ousterPoint.y;
-    slamPoint.z = ousterPoint.z;
-    slamPoint.intensity = ousterPoint.reflectivity;
-    slamPoint.laser_id = useLaserIdMapping ? this->LaserIdMapping[ousterPoint.ring] : ousterPoint.ring;
-    slamPoint.device_id = this->DeviceId;
-
-    // Build approximate point-wise timestamp from azimuth angle
-    // 'frameAdvancement' is 0 for first point, and should match 1 for last point
-    // for a 360 degrees scan at ideal spinning frequency.
-    // 'time' is the offset to add to 'header.stamp' to get approximate point-wise timestamp.
-    // By default, 'header.stamp' is the timestamp of the last Veloydne packet,
-    // but user can choose the first packet timestamp using parameter 'timestamp_first_packet'.
     double frameAdvancement = frameAdvancementEstimator(slamPoint);
     slamPoint.time = (this->TimestampFirstPacket ? frameAdvancement : frameAdvancement - 1) / this->Rpm * 60.;
-
-    cloudS.push_back(slamPoint);
   }
 
-  this->Talker.publish(cloudS);
+  this->Talker.publish(cloudSPtr);
 }
 
 }  // end of namespace lidar_conversions
-
-//------------------------------------------------------------------------------
-/*!
- * @brief Main node entry point.
- */
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "ouster_conversion");
-  ros::NodeHandle n;
-  ros::NodeHandle priv_nh("~");
-
-  lidar_conversions::OusterToLidarNode v2s(n, priv_nh);
-
-  ros::spin();
-
-  return 0;
-}
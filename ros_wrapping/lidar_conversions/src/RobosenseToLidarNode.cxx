@@ -29,7 +29,7 @@ namespace
 {
   // Mapping between RSLidar laser id and vertical laser id
   // TODO add laser ID mappings for RS32, RSBPEARL and RSBPEARL_MINI ?
-  const std::array<uint16_t, 16> LASER_ID_MAPPING_RS16 = {0, 1, 2, 3, 4, 5, 6, 7, 15, 14, 13, 12, 11, 10, 9, 8};
+  const std::vector<uint16_t> LASER_ID_MAPPING_RS16 = {0, 1, 2, 3, 4, 5, 6, 7, 15, 14, 13, 12, 11, 10, 9, 8};
 }
 
 RobosenseToLidarNode::RobosenseToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
@@ -38,6 +38,7 @@ RobosenseToLidarNode::RobosenseToLidarNode(ros::NodeHandle& nh, ros::NodeHandle&
 {
   // Get laser ID mapping
   this->PrivNh.param("laser_id_mapping", this->LaserIdMapping, this->LaserIdMapping);
+  this->LaserIdLut = Utils::BuildLaserIdLut(this->LaserIdMapping);
 
   //  Get LiDAR id
   this->PrivNh.param("device_id", this->DeviceId, this->DeviceId);
@@ -45,6 +46,9 @@ RobosenseToLidarNode::RobosenseToLidarNode(ros::NodeHandle& nh, ros::NodeHandle&
   // Get LiDAR spinning speed
   this->PrivNh.param("rpm", this->Rpm, this->Rpm);
 
+  // Get number of threads used to convert large clouds
+  this->PrivNh.param("nb_threads", this->NbThreads, this->NbThreads);
+
   // Init ROS publisher
   this->Talker = nh.advertise<CloudS>("lidar_points", 1);
 
@@ -55,92 +59,89 @@ RobosenseToLidarNode::RobosenseToLidarNode(ros::NodeHandle& nh, ros::NodeHandle&
 }
 
 //------------------------------------------------------------------------------
-void RobosenseToLidarNode::Callback(const CloudRS& cloudRS)
+void RobosenseToLidarNode::Callback(const sensor_msgs::PointCloud2& cloudRS)
 {
   // If input cloud is empty, ignore it
-  if (cloudRS.empty())
+  if (cloudRS.width * cloudRS.height == 0)
   {
     ROS_ERROR_STREAM("Input RSLidar pointcloud is empty : frame ignored.");
     return;
   }
 
+  // Check that all points can be read from the message data
+  if (!Utils::IsDataLayoutValid(cloudRS))
+  {
+    ROS_ERROR_STREAM("Input RSLidar pointcloud has an invalid data layout (row step, data size or byte order) : frame ignored.");
+    return;
+  }
+
+  // Look up input fields once
+  Utils::PointField x, y, z, intensity;
+  if (!x.Init(cloudRS, "x") || !y.Init(cloudRS, "y") || !z.Init(cloudRS, "z") ||
+      !intensity.Init(cloudRS, "intensity"))
+  {
+    ROS_ERROR_STREAM("Input RSLidar pointcloud misses some required fields (x, y, z, intensity) : frame ignored.");
+    return;
+  }
+
   // Init SLAM pointcloud
-  CloudS cloudS;
-  cloudS.reserve(cloudRS.size());
+  CloudS::Ptr cloudSPtr(new CloudS);
+  CloudS& cloudS = *cloudSPtr;
 
   // Copy pointcloud metadata
   Utils::CopyPointCloudMetadata(cloudRS, cloudS);
   cloudS.is_dense = true;
 
   // Helpers to estimate point-wise fields
+  // Use LaserIdMapping if given, otherwise use RS16's if input has 16 rings,
+  // otherwise do not correct laser_id.
+  // CHECK this operation for other sensors than RS16
   const unsigned int nLasers = cloudRS.height;
-  const unsigned int pointsPerRing = cloudRS.size() / nLasers;
-  const bool useLaserIdMapping = !this->LaserIdMapping.empty();
+  const unsigned int pointsPerRing = cloudRS.width;
+  const std::vector<uint16_t>& laserIdLut = !this->LaserIdLut.empty() ? this->LaserIdLut :
+                                            (nLasers == 16) ? LASER_ID_MAPPING_RS16 : this->LaserIdLut;
 
   // Build SLAM pointcloud
-  for (unsigned int i = 0; i < cloudRS.size(); ++i)
-  {
-    const PointRS& rsPoint = cloudRS[i];
-
-    // Check that input point does not have NaNs as even invalid points are
-    // returned by the RSLidar driver
-    if (!Utils::IsFinite(rsPoint))
-      continue;
-
-    // In case of dual returns mode, check that the second return is not identical to the first
-    // CHECK this operation for other sensors than RS16
-    if (!cloudS.empty() && std::equal(rsPoint.data, rsPoint.data + 3, cloudS.back().data))
-      continue;
-
-    // Copy coordinates and intensity
-    PointS slamPoint;
-    slamPoint.x = rsPoint.x;
-    slamPoint.y = rsPoint.y;
-    slamPoint.z = rsPoint.z;
-    slamPoint.intensity = rsPoint.intensity;
-    slamPoint.device_id = this->DeviceId;
-
-    // Compute laser ID
-    // Use LaserIdMapping if given, otherwise use RS16's if input has 16 rings,
-    // otherwise do not correct laser_id.
-    // CHECK this operation for other sensors than RS16
-    uint16_t laser_id = i / cloudRS.width;
-    slamPoint.laser_id = useLaserIdMapping ? this->LaserIdMapping[laser_id] :
-                                             (nLasers == 16) ? LASER_ID_MAPPING_RS16[laser_id] : laser_id;
-
-    // Build approximate point-wise timestamp from point id.
-    // 'frame advancement' is 0 for first point, and should match 1 for last point
-    // for a 360 degrees scan at ideal spinning frequency.
-    // 'time' is the offset to add to 'header.stamp' (timestamp of the last RSLidar packet)
-    // to get approximate point-wise timestamp.
-    // NOTE: to be precise, this estimation requires that each input scan is an
-    // entire scan covering excatly 360°.
-    double frameAdvancement = static_cast<double>(i % pointsPerRing) / pointsPerRing;
-    slamPoint.time = (frameAdvancement - 1) / this->Rpm * 60.;
-
-    cloudS.push_back(slamPoint);
-  }
+  Utils::ConvertPoints(cloudRS, cloudS, this->NbThreads,
+    [&](unsigned int i, const uint8_t* data, PointS& slamPoint)
+    {
+      // Copy coordinates and intensity
+      slamPoint.x = x.Get<float>(data);
+      slamPoint.y = y.Get<float>(data);
+      slamPoint.z = z.Get<float>(data);
+
+      // Check that input point does not have NaNs as even invalid points are
+      // returned by the RSLidar driver
+      if (!Utils::IsFinite(slamPoint))
+        return false;
+
+      slamPoint.intensity = intensity.Get<float>(data);
+      slamPoint.device_id = this->DeviceId;
+
+      // Compute laser ID
+      slamPoint.laser_id = Utils::LookUpLaserId(laserIdLut, i / pointsPerRing);
+
+      // Build approximate point-wise timestamp from point id.
+      // 'frame advancement' is 0 for first point, and should match 1 for last point
+      // for a 360 degrees scan at ideal spinning frequency.
+      // 'time' is the offset to add to 'header.stamp' (timestamp of the last RSLidar packet)
+      // to get approximate point-wise timestamp.
+      // NOTE: to be precise, this estimation requires that each input scan is an
+      // entire scan covering excatly 360°.
+      double frameAdvancement = static_cast<double>(i % pointsPerRing) / pointsPerRing;
+      slamPoint.time = (frameAdvancement - 1) / this->Rpm * 60.;
+      return true;
+    });
+
+  // In case of dual returns mode, check that the second return is not identical to the first
+  // CHECK this operation for other sensors than RS16
+  auto isSameReturn = [](const PointS& p1, const PointS& p2) { return std::equal(p1.data, p1.data + 3, p2.data); };
+  cloudS.points.erase(std::unique(cloudS.begin(), cloudS.end(), isSameReturn), cloudS.end());
+  cloudS.width = cloudS.size();
 
   // Publish pointcloud only if non empty
   if (!cloudS.empty())
-    this->Talker.publish(cloudS);
+    this->Talker.publish(cloudSPtr);
 }
 
 }  // end of namespace lidar_conversions
-
-//------------------------------------------------------------------------------
-/*!
- * @brief Main node entry point.
- */
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "rslidar_conversion");
-  ros::NodeHandle n;
-  ros::NodeHandle priv_nh("~");
-
-  lidar_conversions::RobosenseToLidarNode rs2s(n, priv_nh);
-
-  ros::spin();
-
-  return 0;
-}
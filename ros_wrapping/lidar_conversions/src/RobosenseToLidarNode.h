@@ -21,6 +21,7 @@
 
 #include <ros/ros.h>
 #include <pcl_ros/point_cloud.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <pcl/point_types.h>
 #include <LidarSlam/LidarPoint.h>
 
@@ -37,8 +38,7 @@ namespace lidar_conversions
 class RobosenseToLidarNode
 {
 public:
-  using PointRS = pcl::PointXYZI;
-  using CloudRS = pcl::PointCloud<PointRS>;  ///< Pointcloud published by rslidar driver
+  using PointRS = pcl::PointXYZI;  ///< Point layout published by rslidar driver
   using PointS = LidarSlam::LidarPoint;
   using CloudS = pcl::PointCloud<PointS>;  ///< Pointcloud needed by SLAM
 
@@ -54,8 +54,11 @@ public:
   /*!
    * @brief New lidar frame callback, converting and publishing RSLidar PointCloud as SLAM LidarPoint.
    * @param cloud New Lidar Frame, published by rslidar_pointcloud/cloud_node.
+   *
+   * The fields of the message are read directly from its raw buffer to fill the
+   * output cloud, without deserializing it to an intermediate PCL cloud.
    */
-  void Callback(const CloudRS& cloud);
+  void Callback(const sensor_msgs::PointCloud2& cloud);
 
 private:
 
@@ -72,6 +75,7 @@ private:
   // - if input cloud has 16 rings : RS16 mapping [0, 1, 2, 3, 4, 5, 6, 7, 15, 14, 13, 12, 11, 10, 9, 8]
   // - otherwise : identity mapping (no laser_id change)
   std::vector<int> LaserIdMapping;
+  std::vector<uint16_t> LaserIdLut;  ///< Lookup table built from LaserIdMapping.
 
   int DeviceId = 0;  ///< LiDAR device identifier to set for each point.
 
@@ -80,6 +84,8 @@ private:
   // NOTE: to be precise, this timestamp estimation requires that each input
   // scan is an entire scan covering excatly 360°.
   double Rpm = 600;  ///< Spinning speed of sensor [rpm]. The duration of each input scan will be 60 / Rpm seconds.
+
+  int NbThreads = 1;  ///< Max number of threads to use to convert large clouds in parallel chunks.
 };
 
 }  // end of namespace lidar_conversions
@@ -0,0 +1,18 @@
+#include "RobosenseToLidarNode.h"
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Main node entry point.
+ */
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "rslidar_conversion");
+  ros::NodeHandle n;
+  ros::NodeHandle priv_nh("~");
+
+  lidar_conversions::RobosenseToLidarNode rs2s(n, priv_nh);
+
+  ros::spin();
+
+  return 0;
+}
@@ -19,8 +19,13 @@
 #pragma once
 
 #include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <algorithm>
 #include <cmath>
-#include <map>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace lidar_conversions
 {
@@ -42,6 +47,233 @@ inline void CopyPointCloudMetadata(const pcl::PointCloud<PointI>& from, pcl::Poi
   to.sensor_origin_ = from.sensor_origin_;
 }
 
+//------------------------------------------------------------------------------
+/*!
+ * @brief Copy PointCloud2 message metadata to a PCL cloud
+ * @param[in] from The PointCloud2 message to copy info from
+ * @param[out] to The pointcloud to copy info to
+ */
+template<typename PointO>
+inline void CopyPointCloudMetadata(const sensor_msgs::PointCloud2& from, pcl::PointCloud<PointO>& to)
+{
+  pcl_conversions::toPCL(from.header, to.header);
+  to.is_dense = from.is_dense;
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Check if the byte order of the host is big endian.
+ */
+inline bool IsHostBigEndian()
+{
+  const uint16_t one = 1;
+  return *reinterpret_cast<const uint8_t*>(&one) == 0;
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Check that the data layout of a PointCloud2 message can be read.
+ * @param cloud The PointCloud2 message to check.
+ * @return true if the rows hold their points and the data holds all rows, with
+ *         the host byte order, false otherwise.
+ */
+inline bool IsDataLayoutValid(const sensor_msgs::PointCloud2& cloud)
+{
+  return cloud.is_bigendian == IsHostBigEndian() &&
+         static_cast<uint64_t>(cloud.width) * cloud.point_step <= cloud.row_step &&
+         static_cast<uint64_t>(cloud.height) * cloud.row_step <= cloud.data.size();
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Get the raw data of a point of a PointCloud2 message, with a valid data layout.
+ * @param cloud The PointCloud2 message.
+ * @param index The index of the point, in row-major order.
+ * @return Pointer to the beginning of the point in the message data.
+ */
+inline const uint8_t* GetPointData(const sensor_msgs::PointCloud2& cloud, unsigned int index)
+{
+  const uint64_t row = index / cloud.width;
+  const uint64_t col = index % cloud.width;
+  return &cloud.data[row * cloud.row_step + col * cloud.point_step];
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @struct Helper to read a field of the points of a PointCloud2 message,
+ * converting it from its stored datatype.
+ *
+ * The field offset and datatype are looked up once per message, then each point
+ * field is read directly from the message raw buffer.
+ */
+struct PointField
+{
+  /*!
+   * @brief Look up the field in the message description.
+   * @param cloud The PointCloud2 message to read.
+   * @param name The name of the field to read.
+   * @return true if the field exists with a supported datatype, lies within the
+   *         point data and has the host byte order, false otherwise.
+   */
+  bool Init(const sensor_msgs::PointCloud2& cloud, const std::string& name)
+  {
+    for (const sensor_msgs::PointField& field : cloud.fields)
+    {
+      if (field.name == name)
+      {
+        this->Offset = field.offset;
+        this->Datatype = field.datatype;
+        unsigned int size = DatatypeSize(field.datatype);
+        this->Valid = size > 0 &&
+                      static_cast<uint64_t>(field.offset) + size <= cloud.point_step &&
+                      cloud.is_bigendian == IsHostBigEndian();
+        return this->Valid;
+      }
+    }
+    this->Valid = false;
+    return false;
+  }
+
+  /*!
+   * @brief Read the field value of a point.
+   * @param pointData Pointer to the beginning of the point in the message data.
+   * @return The field value, converted to T.
+   */
+  template<typename T>
+  T Get(const uint8_t* pointData) const
+  {
+    const uint8_t* data = pointData + this->Offset;
+    switch (this->Datatype)
+    {
+      case sensor_msgs::PointField::INT8:    return static_cast<T>(Read<int8_t>(data));
+      case sensor_msgs::PointField::UINT8:   return static_cast<T>(Read<uint8_t>(data));
+      case sensor_msgs::PointField::INT16:   return static_cast<T>(Read<int16_t>(data));
+      case sensor_msgs::PointField::UINT16:  return static_cast<T>(Read<uint16_t>(data));
+      case sensor_msgs::PointField::INT32:   return static_cast<T>(Read<int32_t>(data));
+      case sensor_msgs::PointField::UINT32:  return static_cast<T>(Read<uint32_t>(data));
+      case sensor_msgs::PointField::FLOAT32: return static_cast<T>(Read<float>(data));
+      case sensor_msgs::PointField::FLOAT64: return static_cast<T>(Read<double>(data));
+      default:                               return T(0);
+    }
+  }
+
+  bool Valid = false;
+
+private:
+  // Size in bytes of a field datatype, or 0 if it is not supported
+  static unsigned int DatatypeSize(uint8_t datatype)
+  {
+    switch (datatype)
+    {
+      case sensor_msgs::PointField::INT8:
+      case sensor_msgs::PointField::UINT8:   return 1;
+      case sensor_msgs::PointField::INT16:
+      case sensor_msgs::PointField::UINT16:  return 2;
+      case sensor_msgs::PointField::INT32:
+      case sensor_msgs::PointField::UINT32:
+      case sensor_msgs::PointField::FLOAT32: return 4;
+      case sensor_msgs::PointField::FLOAT64: return 8;
+      default:                               return 0;
+    }
+  }
+
+  // Message data may not be aligned with the field type
+  template<typename T>
+  static T Read(const uint8_t* data)
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  uint32_t Offset = 0;
+  uint8_t Datatype = 0;
+};
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Build a laser ID lookup table from an optional user mapping.
+ * @param mapping The user mapping from input ring to SLAM laser ID. If empty, the default mapping is used.
+ * @param defaultMapping The mapping to use if no user mapping is given. If empty, identity is used.
+ * @return The lookup table. Rings out of its range must be left untouched (see LookUpLaserId).
+ */
+inline std::vector<uint16_t> BuildLaserIdLut(const std::vector<int>& mapping, const std::vector<uint16_t>& defaultMapping = {})
+{
+  std::vector<uint16_t> lut;
+  if (!mapping.empty())
+    lut.assign(mapping.begin(), mapping.end());
+  else
+    lut.assign(defaultMapping.begin(), defaultMapping.end());
+  return lut;
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Get the SLAM laser ID of a ring from a lookup table built with BuildLaserIdLut.
+ */
+inline uint16_t LookUpLaserId(const std::vector<uint16_t>& lut, unsigned int ring)
+{
+  return ring < lut.size() ? lut[ring] : ring;
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Convert the points of a PointCloud2 message, splitting large clouds in
+ * chunks converted in parallel.
+ * @param[in] cloud The PointCloud2 message to convert. Its data layout must be
+ *                  valid (see IsDataLayoutValid).
+ * @param[out] output The converted cloud. Its points are resized in place.
+ * @param[in] nbThreads The maximum number of threads to use.
+ * @param[in] convert Function with signature bool(unsigned int index, const uint8_t* data, PointO& point),
+ *                    filling the output point from the input point raw data. It
+ *                    must return false to drop the point.
+ *
+ * Output points are written directly to the output buffer, and keep the input order.
+ * The output cloud should be allocated and published as a shared pointer: when
+ * the conversion and SLAM nodelets share a manager, it is then received without
+ * serialization nor copy.
+ */
+template<typename PointO, typename Converter>
+inline void ConvertPoints(const sensor_msgs::PointCloud2& cloud, pcl::PointCloud<PointO>& output,
+                          int nbThreads, const Converter& convert)
+{
+  // Split input points in chunks. Small clouds are converted by a single thread.
+  constexpr unsigned int MIN_CHUNK_SIZE = 8192;
+  const unsigned int nbPoints = cloud.width * cloud.height;
+  const int nbChunks = std::max(1, std::min(nbThreads, static_cast<int>(nbPoints / MIN_CHUNK_SIZE)));
+  const unsigned int chunkSize = (nbPoints + nbChunks - 1) / nbChunks;
+
+  // Each chunk writes its kept points at the beginning of its own output range
+  output.points.resize(nbPoints);
+  std::vector<unsigned int> nbKeptPoints(nbChunks, 0);
+  #pragma omp parallel for num_threads(nbChunks) schedule(static, 1)
+  for (int c = 0; c < nbChunks; ++c)
+  {
+    unsigned int begin = c * chunkSize;
+    unsigned int end = std::min(begin + chunkSize, nbPoints);
+    unsigned int kept = begin;
+    for (unsigned int i = begin; i < end; ++i)
+    {
+      if (convert(i, GetPointData(cloud, i), output.points[kept]))
+        ++kept;
+    }
+    nbKeptPoints[c] = kept - begin;
+  }
+
+  // Gather chunks. They are already in place while no point has been dropped.
+  unsigned int nbOutputPoints = nbKeptPoints[0];
+  for (int c = 1; c < nbChunks; ++c)
+  {
+    auto chunkBegin = output.points.begin() + c * chunkSize;
+    if (nbOutputPoints != c * chunkSize)
+      std::move(chunkBegin, chunkBegin + nbKeptPoints[c], output.points.begin() + nbOutputPoints);
+    nbOutputPoints += nbKeptPoints[c];
+  }
+  output.points.resize(nbOutputPoints);
+  output.width = nbOutputPoints;
+  output.height = 1;
+}
+
 //------------------------------------------------------------------------------
 /*!
  * @brief Check if a PCL point is valid
@@ -99,8 +331,9 @@ struct SpinningFrameAdvancementEstimator
     double frameAdvancement = wrapMax(pointAdvancement - this->InitAdvancement, 1.);
 
     // If we detect overflow, correct it
-    // If current laser_id is not in map, the following line will insert it,
-    // associating it to value 0.0.
+    // If current laser_id has not been seen yet, its previous advancement is 0.0.
+    if (point.laser_id >= this->PreviousAdvancementPerRing.size())
+      this->PreviousAdvancementPerRing.resize(point.laser_id + 1, 0.);
     if (frameAdvancement < this->PreviousAdvancementPerRing[point.laser_id])
       frameAdvancement += 1.;
     this->PreviousAdvancementPerRing[point.laser_id] = frameAdvancement;
@@ -110,7 +343,7 @@ struct SpinningFrameAdvancementEstimator
 
 private:
   double InitAdvancement;
-  std::map<int, double> PreviousAdvancementPerRing;
+  std::vector<double> PreviousAdvancementPerRing;  ///< Indexed by laser_id
 };
 
 }  // end of namespace Utils
@@ -31,6 +31,7 @@ VelodyneToLidarNode::VelodyneToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& p
 {
   // Get laser ID mapping
   this->PrivNh.param("laser_id_mapping", this->LaserIdMapping, this->LaserIdMapping);
+  this->LaserIdLut = Utils::BuildLaserIdLut(this->LaserIdMapping);
 
   //  Get LiDAR id
   this->PrivNh.param("device_id", this->DeviceId, this->DeviceId);
@@ -39,6 +40,9 @@ VelodyneToLidarNode::VelodyneToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& p
   this->PrivNh.param("rpm", this->Rpm, this->Rpm);
   this->PrivNh.param("timestamp_first_packet", this->TimestampFirstPacket, this->TimestampFirstPacket);
 
+  // Get number of threads used to convert large clouds
+  this->PrivNh.param("nb_threads", this->NbThreads, this->NbThreads);
+
   // Init ROS publisher
   this->Talker = nh.advertise<CloudS>("lidar_points", 1);
 
@@ -49,83 +53,81 @@ VelodyneToLidarNode::VelodyneToLidarNode(ros::NodeHandle& nh, ros::NodeHandle& p
 }
 
 //------------------------------------------------------------------------------
-void VelodyneToLidarNode::Callback(const CloudV& cloudV)
+void VelodyneToLidarNode::Callback(const sensor_msgs::PointCloud2& cloudV)
 {
   // If input cloud is empty, ignore it
-  if (cloudV.empty())
+  if (cloudV.width * cloudV.height == 0)
   {
     ROS_ERROR_STREAM("Input Velodyne pointcloud is empty : frame ignored.");
     return;
   }
 
+  // Check that all points can be read from the message data
+  if (!Utils::IsDataLayoutValid(cloudV))
+  {
+    ROS_ERROR_STREAM("Input Velodyne pointcloud has an invalid data layout (row step, data size or byte order) : frame ignored.");
+    return;
+  }
+
+  // Look up input fields once
+  Utils::PointField x, y, z, intensity, ring, time;
+  if (!x.Init(cloudV, "x") || !y.Init(cloudV, "y") || !z.Init(cloudV, "z") ||
+      !intensity.Init(cloudV, "intensity") || !ring.Init(cloudV, "ring"))
+  {
+    ROS_ERROR_STREAM("Input Velodyne pointcloud misses some required fields (x, y, z, intensity, ring) : frame ignored.");
+    return;
+  }
+
   // Init SLAM pointcloud
-  CloudS cloudS;
-  cloudS.reserve(cloudV.size());
+  CloudS::Ptr cloudSPtr(new CloudS);
+  CloudS& cloudS = *cloudSPtr;
 
   // Copy pointcloud metadata
   Utils::CopyPointCloudMetadata(cloudV, cloudS);
 
-  // Check wether to use custom laser ID mapping or leave it untouched
-  bool useLaserIdMapping = !this->LaserIdMapping.empty();
-
   // Check if time field looks properly set
   // If first and last points have same timestamps, this is not normal
-  bool isTimeValid = cloudV.back().time - cloudV.front().time > 1e-8;
+  const unsigned int lastPointIndex = cloudV.width * cloudV.height - 1;
+  bool isTimeValid = time.Init(cloudV, "time") &&
+                     time.Get<double>(Utils::GetPointData(cloudV, lastPointIndex)) - time.Get<double>(Utils::GetPointData(cloudV, 0)) > 1e-8;
   if (!isTimeValid)
     ROS_WARN_STREAM("Invalid 'time' field, it will be built from azimuth advancement.");
 
-  // Helper to estimate frameAdvancement in case time field is invalid
-  Utils::SpinningFrameAdvancementEstimator frameAdvancementEstimator;
-
   // Build SLAM pointcloud
-  for (const PointV& velodynePoint : cloudV)
+  Utils::ConvertPoints(cloudV, cloudS, this->NbThreads,
+    [&](unsigned int, const uint8_t* data, PointS& slamPoint)
+    {
+      slamPoint.x = x.Get<float>(data);
+      slamPoint.y = y.Get<float>(data);
+      slamPoint.z = z.Get<float>(data);
+      slamPoint.intensity = intensity.Get<float>(data);
+      slamPoint.laser_id = Utils::LookUpLaserId(this->LaserIdLut, ring.Get<unsigned int>(data));
+      slamPoint.device_id = this->DeviceId;
+
+      // Use time field if available
+      // time is the offset to add to header.stamp to get point-wise timestamp
+      slamPoint.time = isTimeValid ? time.Get<double>(data) : 0.;
+      return true;
+    });
+
+  // Build approximate point-wise timestamp from azimuth angle
+  // 'frameAdvancement' is 0 for first point, and should match 1 for last point
+  // for a 360 degrees scan at ideal spinning frequency.
+  // 'time' is the offset to add to 'header.stamp' to get approximate point-wise timestamp.
+  // By default, 'header.stamp' is the timestamp of the last Veloydne packet,
+  // but user can choose the first packet timestamp using parameter 'timestamp_first_packet'.
+  // This estimation relies on the previous points of each ring, so it is done sequentially.
+  if (!isTimeValid)
   {
-    PointS slamPoint;
-    slamPoint.x = velodynePoint.x;
-    slamPoint.y = velodynePoint.y;
-    slamPoint.z = velodynePoint.z;
-    slamPoint.intensity = velodynePoint.intensity;
-    slamPoint.laser_id = useLaserIdMapping ? this->LaserIdMapping[velodynePoint.ring] : velodynePoint.ring;
-    slamPoint.device_id = this->DeviceId;
-
-    // Use time field if available
-    // time is the offset to add to header.stamp to get point-wise timestamp
-    if (isTimeValid)
-      slamPoint.time = velodynePoint.time;
-
-    // Build approximate point-wise timestamp from azimuth angle
-    // 'frameAdvancement' is 0 for first point, and should match 1 for last point
-    // for a 360 degrees scan at ideal spinning frequency.
-    // 'time' is the offset to add to 'header.stamp' to get approximate point-wise timestamp.
-    // By default, 'header.stamp' is the timestamp of the last Veloydne packet,
-    // but user can choose the first packet timestamp using parameter 'timestamp_first_packet'.
-    else
+    Utils::SpinningFrameAdvancementEstimator frameAdvancementEstimator;
+    for (PointS& slamPoint : cloudS)
     {
       double frameAdvancement = frameAdvancementEstimator(slamPoint);
       slamPoint.time = (this->TimestampFirstPacket ? frameAdvancement : frameAdvancement - 1) / this->Rpm * 60.;
     }
-
-    cloudS.push_back(slamPoint);
   }
 
-  this->Talker.publish(cloudS);
+  this->Talker.publish(cloudSPtr);
 }
 
 }  // end of namespace lidar_conversions
-
-//------------------------------------------------------------------------------
-/*!
- * @brief Main node entry point.
- */
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "velodyne_conversion");
-  ros::NodeHandle n;
-  ros::NodeHandle priv_nh("~");
-
-  lidar_conversions::VelodyneToLidarNode v2s(n, priv_nh);
-
-  ros::spin();
-
-  return 0;
-}
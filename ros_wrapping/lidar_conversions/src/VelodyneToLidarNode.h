@@ -20,6 +20,7 @@
 
 #include <ros/ros.h>
 #include <pcl_ros/point_cloud.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <velodyne_point.h>
 #include <LidarSlam/LidarPoint.h>
 
@@ -36,8 +37,7 @@ namespace lidar_conversions
 class VelodyneToLidarNode
 {
 public:
-  using PointV = velodyne_pcl::PointXYZIRT;
-  using CloudV = pcl::PointCloud<PointV>;  ///< Pointcloud published by velodyne driver
+  using PointV = velodyne_pcl::PointXYZIRT;  ///< Point layout published by velodyne driver
   using PointS = LidarSlam::LidarPoint;
   using CloudS = pcl::PointCloud<PointS>;  ///< Pointcloud needed by SLAM
 
@@ -53,8 +53,11 @@ public:
   /*!
    * @brief New lidar frame callback, converting and publishing Velodyne PointCloud as SLAM LidarPoint.
    * @param cloud New Lidar Frame, published by velodyne_pointcloud/transform_node.
+   *
+   * The fields of the message are read directly from its raw buffer to fill the
+   * output cloud, without deserializing it to an intermediate PCL cloud.
    */
-  void Callback(const CloudV& cloud);
+  void Callback(const sensor_msgs::PointCloud2& cloud);
 
 private:
 
@@ -71,6 +74,7 @@ private:
   // NOTE: the Velodyne ROS driver should already correctly modify the laser_id,
   // so this shouldn't be needed.
   std::vector<int> LaserIdMapping;
+  std::vector<uint16_t> LaserIdLut;  ///< Lookup table built from LaserIdMapping.
 
   int DeviceId = 0;  ///< LiDAR device identifier to set for each point.
 
@@ -78,6 +82,8 @@ private:
   // These parameters should be set to the same values as ROS Velodyne driver's.
   double Rpm = 600;  ///< Spinning speed of sensor [rpm]
   bool TimestampFirstPacket = false;  ///< Wether timestamping is based on the first or last packet of each scan
+
+  int NbThreads = 1;  ///< Max number of threads to use to convert large clouds in parallel chunks.
 };
 
 }  // end of namespace lidar_conversions
@@ -0,0 +1,18 @@
+#include "VelodyneToLidarNode.h"
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Main node entry point.
+ */
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "velodyne_conversion");
+  ros::NodeHandle n;
+  ros::NodeHandle priv_nh("~");
+
+  lidar_conversions::VelodyneToLidarNode v2s(n, priv_nh);
+
+  ros::spin();
+
+  return 0;
+}
@@ -24,7 +24,91 @@
 #include <pcl_conversions/pcl_conversions.h>
 #include <geometry_msgs/TransformStamped.h>
 
-#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/*!
+ * @brief Write LidarPoints to a PCD file one by one, without storing them.
+ *
+ * The number of points is only known at the end : it is written in a fixed
+ * width field of the header, which is updated when closing the file.
+ */
+class PCDStreamWriter
+{
+public:
+  bool Open(const std::string& path, bool binary)
+  {
+    this->Binary = binary;
+    this->NbPoints = 0;
+    this->File.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->File)
+      return false;
+    this->File << "# .PCD v0.7 - Point Cloud Data file format\n"
+               << "VERSION 0.7\n"
+               << "FIELDS x y z time intensity laser_id device_id label\n"
+               << "SIZE 4 4 4 8 4 2 1 1\n"
+               << "TYPE F F F F F U U U\n"
+               << "COUNT 1 1 1 1 1 1 1 1\n"
+               << "WIDTH ";
+    this->WidthPos = this->File.tellp();
+    this->File << std::setw(CountWidth) << 0 << "\n"
+               << "HEIGHT 1\n"
+               << "VIEWPOINT 0 0 0 1 0 0 0\n"
+               << "POINTS ";
+    this->PointsPos = this->File.tellp();
+    this->File << std::setw(CountWidth) << 0 << "\n"
+               << "DATA " << (binary ? "binary" : "ascii") << "\n";
+    this->File << std::setprecision(std::numeric_limits<double>::max_digits10);
+    return bool(this->File);
+  }
+
+  void Write(const LidarSlam::LidarPoint& p)
+  {
+    if (this->Binary)
+    {
+      // Fields are packed, following the header description
+      this->File.write(reinterpret_cast<const char*>(&p.x), 3 * sizeof(float));
+      this->File.write(reinterpret_cast<const char*>(&p.time), sizeof(double));
+      this->File.write(reinterpret_cast<const char*>(&p.intensity), sizeof(float));
+      this->File.write(reinterpret_cast<const char*>(&p.laser_id), sizeof(uint16_t));
+      this->File.write(reinterpret_cast<const char*>(&p.device_id), sizeof(uint8_t));
+      this->File.write(reinterpret_cast<const char*>(&p.label), sizeof(uint8_t));
+    }
+    else
+      this->File << p.x << " " << p.y << " " << p.z << " " << p.time << " " << p.intensity << " "
+                 << p.laser_id << " " << int(p.device_id) << " " << int(p.label) << "\n";
+    ++this->NbPoints;
+  }
+
+  bool Close()
+  {
+    this->File.seekp(this->WidthPos);
+    this->File << std::setw(CountWidth) << this->NbPoints;
+    this->File.seekp(this->PointsPos);
+    this->File << std::setw(CountWidth) << this->NbPoints;
+    bool ok = bool(this->File);
+    this->File.close();
+    return ok;
+  }
+
+  uint64_t GetNbPoints() const { return this->NbPoints; }
+
+private:
+  static constexpr int CountWidth = 20;
+  std::ofstream File;
+  std::streampos WidthPos, PointsPos;
+  uint64_t NbPoints = 0;
+  bool Binary = true;
+};
+} // end of anonymous namespace
 
 //==============================================================================
 //   Basic SLAM use
@@ -39,6 +123,8 @@ AggregationNode::AggregationNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
   // Init ROS publisher
   // aggregated points with specified density
   this->PointsPublisher = this->Nh.advertise<CloudS>("aggregated_cloud", 10, false);
+  // points newly validated by the last frame
+  this->NewPointsPublisher = this->Nh.advertise<CloudS>("aggregated_cloud_updates", 10, false);
 
   // Init ROS subscriber
   // Lidar frame undistorted
@@ -61,17 +147,80 @@ AggregationNode::AggregationNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
   int minNbPointsPerVoxel = this->PrivNh.param("min_points_per_voxel", 2);
   this->DenseMap->SetMinFramesPerVoxel(minNbPointsPerVoxel);
 
+  // Out-of-core accumulation of the points leaving the dense map
+  this->OutOfCore = this->PrivNh.param("out_of_core/enable", false);
+  if (this->OutOfCore)
+  {
+    std::string tilesDirectory = this->PrivNh.param<std::string>("out_of_core/tiles_directory", "");
+    this->TilesDirectory = tilesDirectory.empty() ? boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("aggregation_tiles_%%%%%%")
+                                                  : boost::filesystem::path(tilesDirectory);
+    this->RemoveTilesDirectory = tilesDirectory.empty();
+    this->TileMaxPoints = std::max(this->PrivNh.param("out_of_core/tile_max_points", 1000000), 1);
+    boost::system::error_code error;
+    boost::filesystem::create_directories(this->TilesDirectory, error);
+    if (error)
+    {
+      ROS_ERROR_STREAM("Unable to create tiles directory " << this->TilesDirectory << " (" << error.message() << ") : out-of-core accumulation is disabled.");
+      this->OutOfCore = false;
+    }
+    else
+    {
+      this->DenseMap->SetRollOutCallback([this](const Eigen::Array3i& coords, const LidarSlam::RollingGrid::SamplingVG& innerVoxels)
+                                         { this->FlushVoxel(coords, innerVoxels); });
+      ROS_INFO_STREAM("Points leaving the dense map are written to " << this->TilesDirectory);
+    }
+  }
+
+  // Init timer to publish the whole aggregated cloud
+  double fullCloudPeriod = this->PrivNh.param("full_cloud_period", 10.);
+  if (fullCloudPeriod > 0.)
+    this->FullCloudTimer = this->Nh.createTimer(ros::Duration(fullCloudPeriod), &AggregationNode::PublishFullCloud, this);
+
   ROS_INFO_STREAM("Aggregation node is ready !");
 }
 
+//------------------------------------------------------------------------------
+AggregationNode::~AggregationNode()
+{
+  if (!this->OutOfCore)
+    return;
+  // Stop writing the voxels leaving the dense map
+  this->DenseMap->SetRollOutCallback(nullptr);
+
+  // Keep all tiles in the user directory, they may be merged later
+  if (!this->RemoveTilesDirectory)
+  {
+    this->WriteTile();
+    return;
+  }
+  boost::system::error_code error;
+  boost::filesystem::remove_all(this->TilesDirectory, error);
+  if (error)
+    ROS_WARN_STREAM("Unable to remove tiles directory " << this->TilesDirectory << " (" << error.message() << ").");
+}
+
 //------------------------------------------------------------------------------
 void AggregationNode::Callback(const CloudS::Ptr registeredCloud)
 {
   // Aggregated points from all frames
-  this->DenseMap->Add(registeredCloud, false);
+  CloudS::Ptr newPoints(new CloudS);
+  this->DenseMap->Add(registeredCloud, false, true, newPoints.get());
+  this->LastHeader = registeredCloud->header;
+  this->DenseMapChanged = true;
+
+  // Publish the points validated by this frame
+  newPoints->header = registeredCloud->header;
+  this->NewPointsPublisher.publish(newPoints);
+}
+
+//------------------------------------------------------------------------------
+void AggregationNode::PublishFullCloud(const ros::TimerEvent&)
+{
+  if (!this->DenseMapChanged || this->PointsPublisher.getNumSubscribers() == 0)
+    return;
   this->Pointcloud = this->DenseMap->Get(true);
-  this->Pointcloud->header = registeredCloud->header;
-  // Publish them
+  this->Pointcloud->header = this->LastHeader;
+  this->DenseMapChanged = false;
   this->PointsPublisher.publish(this->Pointcloud);
 }
 
@@ -89,27 +238,170 @@ bool AggregationNode::SavePointcloudService(lidar_slam::save_pcRequest& req, lid
   if (req.format > 2 || req.format < 0)
     req.format = 0;
   LidarSlam::PCDFormat f = static_cast<LidarSlam::PCDFormat>(req.format);
-  std::cout << ros::Time().toSec() << std::endl;
   std::string outputFilePath = outputPrefixPath.string() + "_" + std::to_string(int(ros::Time::now().toSec())) + ".pcd";
+
+  // Merge the on-disk tiles with the current dense map
+  if (this->OutOfCore)
+  {
+    res.success = this->SaveOutOfCore(outputFilePath, f);
+    return true;
+  }
+
+  // Extract the current aggregated cloud, and publish it as well
+  if (this->DenseMapChanged || !this->Pointcloud)
+  {
+    this->Pointcloud = this->DenseMap->Get(true);
+    this->Pointcloud->header = this->LastHeader;
+    this->DenseMapChanged = false;
+    this->PointsPublisher.publish(this->Pointcloud);
+  }
+
   LidarSlam::savePointCloudToPCD<PointS>(outputFilePath, *this->Pointcloud, f);
   ROS_INFO_STREAM("Pointcloud saved to " << outputFilePath);
   res.success = true;
   return true;
 }
 
+//==============================================================================
+//   Out-of-core accumulation
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void AggregationNode::FlushVoxel(const Eigen::Array3i& coords, const LidarSlam::RollingGrid::SamplingVG& innerVoxels)
+{
+  // Merge the voxel parts as done when saving : the number of frames that have
+  // seen each inner voxel is summed, and its last point is kept.
+  LidarSlam::RollingGrid::SamplingVG& pending = this->PendingVoxels[std::make_tuple(coords.x(), coords.y(), coords.z())];
+  this->NbPendingPoints -= pending.size();
+  for (const auto& kvIn : innerVoxels)
+  {
+    auto& voxel = pending[kvIn.first];
+    voxel.point = kvIn.second.point;
+    voxel.count += kvIn.second.count;
+  }
+  this->NbPendingPoints += pending.size();
+
+  if (this->NbPendingPoints >= this->TileMaxPoints)
+    this->WriteTile();
+}
+
+//------------------------------------------------------------------------------
+bool AggregationNode::WriteTile()
+{
+  if (this->PendingVoxels.empty())
+    return true;
+
+  std::vector<std::pair<Eigen::Array3i, const LidarSlam::RollingGrid::SamplingVG*>> voxels;
+  voxels.reserve(this->PendingVoxels.size());
+  for (const auto& kv : this->PendingVoxels)
+    voxels.emplace_back(Eigen::Array3i(std::get<0>(kv.first), std::get<1>(kv.first), std::get<2>(kv.first)), &kv.second);
+
+  std::string tilePath = (this->TilesDirectory / ("tile_" + std::to_string(this->Tiles.size()) + ".map")).string();
+  bool written = this->DenseMap->SaveVoxels(tilePath, voxels);
+  if (written)
+    this->Tiles.push_back(tilePath);
+  else
+    ROS_ERROR_STREAM("Unable to write tile " << tilePath << " : " << this->NbPendingPoints << " points are lost.");
+
+  this->PendingVoxels.clear();
+  this->NbPendingPoints = 0;
+  return written;
+}
+
 //------------------------------------------------------------------------------
-int main(int argc, char **argv)
+bool AggregationNode::SaveOutOfCore(const std::string& path, LidarSlam::PCDFormat format)
 {
-  ros::init(argc, argv, "aggregation");
-  ros::NodeHandle nh;
-  ros::NodeHandle priv_nh("~");
+  // Write the buffered voxels, then the current dense map as a last tile
+  this->WriteTile();
+  std::string gridPath = (this->TilesDirectory / "grid.map").string();
+  if (!this->DenseMap->Save(gridPath))
+  {
+    ROS_ERROR_STREAM("Unable to write current dense map to " << gridPath << " : pointcloud not saved.");
+    return false;
+  }
+  std::vector<std::string> tilePaths = this->Tiles;
+  tilePaths.push_back(gridPath);
 
-  // Create lidar slam node, which subscribes to pointclouds coming from conversion node
-  // and to external sensor messages in parallel.
-  AggregationNode slam(nh, priv_nh);
+  // Map all tiles, and index their outer voxels by global coordinates.
+  // Only the tiles headers and indices are read at this point.
+  using VoxelPart = std::pair<const LidarSlam::MapFile*, const LidarSlam::MapFile::VoxelRecord*>;
+  auto compareCoords = [](const Eigen::Array3i& a, const Eigen::Array3i& b)
+  { return std::make_tuple(a.z(), a.y(), a.x()) < std::make_tuple(b.z(), b.y(), b.x()); };
+  std::map<Eigen::Array3i, std::vector<VoxelPart>, decltype(compareCoords)> voxelParts(compareCoords);
+  std::vector<LidarSlam::MapFile> tiles(tilePaths.size());
+  for (unsigned int i = 0; i < tiles.size(); ++i)
+  {
+    if (!tiles[i].Open(tilePaths[i]))
+    {
+      ROS_WARN_STREAM("Tile " << tilePaths[i] << " can not be read : its points are not saved.");
+      continue;
+    }
+    const LidarSlam::MapFile::VoxelRecord* voxels = tiles[i].GetVoxels();
+    for (unsigned int v = 0; v < tiles[i].GetNbVoxels(); ++v)
+      voxelParts[Eigen::Array3i(voxels[v].X, voxels[v].Y, voxels[v].Z)].emplace_back(&tiles[i], &voxels[v]);
+  }
 
-  // Handle callbacks until shut down
-  ros::spin();
+  bool binary = format != LidarSlam::PCDFormat::ASCII;
+  if (format == LidarSlam::PCDFormat::BINARY_COMPRESSED)
+    ROS_WARN_STREAM("Compressed PCD can not be written out of core : using binary format instead.");
+  PCDStreamWriter writer;
+  if (!writer.Open(path, binary))
+  {
+    ROS_ERROR_STREAM("Unable to open " << path << " for writing : pointcloud not saved.");
+    return false;
+  }
 
-  return 0;
-}
\ No newline at end of file
+  // Merge and write one outer voxel at a time.
+  // An outer voxel may have left the map several times : its parts are merged
+  // in writing order, summing the number of frames that have seen each inner
+  // voxel and keeping its last point. As in Get(true), only the inner voxels
+  // seen in more than MinFramesPerVoxel frames are written.
+  const unsigned int minFrames = this->DenseMap->GetMinFramesPerVoxel();
+  std::unordered_map<uint32_t, LidarSlam::MapFile::PointRecord> innerVoxels;
+  for (const auto& kv : voxelParts)
+  {
+    innerVoxels.clear();
+    for (const VoxelPart& part : kv.second)
+    {
+      const LidarSlam::MapFile::PointRecord* records = part.first->GetPoints(*part.second);
+      for (unsigned int i = 0; i < part.second->NbPoints; ++i)
+      {
+        auto it = innerVoxels.find(records[i].InnerIndex);
+        if (it == innerVoxels.end())
+          innerVoxels.emplace(records[i].InnerIndex, records[i]);
+        else
+        {
+          uint32_t count = it->second.Count + records[i].Count;
+          it->second = records[i];
+          it->second.Count = count;
+        }
+      }
+    }
+
+    for (const auto& kvIn : innerVoxels)
+    {
+      const LidarSlam::MapFile::PointRecord& record = kvIn.second;
+      if (record.Count <= minFrames)
+        continue;
+      PointS point;
+      point.x = record.X;
+      point.y = record.Y;
+      point.z = record.Z;
+      point.time = record.Time;
+      point.intensity = record.Intensity;
+      point.laser_id = record.LaserId;
+      point.device_id = record.DeviceId;
+      point.label = record.Label;
+      writer.Write(point);
+    }
+  }
+
+  if (!writer.Close())
+  {
+    ROS_ERROR_STREAM("Unable to write pointcloud to " << path);
+    return false;
+  }
+  ROS_INFO_STREAM("Pointcloud of " << writer.GetNbPoints() << " points merged from " << tilePaths.size()
+                  << " tiles and saved to " << path);
+  return true;
+}
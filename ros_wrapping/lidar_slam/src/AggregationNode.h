@@ -29,6 +29,13 @@
 
 #include "lidar_slam/save_pc.h"
 
+#include <LidarSlam/PointCloudStorage.h>
+
+#include <boost/filesystem.hpp>
+
+#include <map>
+#include <tuple>
+
 class AggregationNode
 {
 public:
@@ -44,6 +51,13 @@ public:
    */
   AggregationNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh);
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Destructor. The temporary tiles directory is removed, while the
+   *            buffered voxels are written to a last tile in a user directory.
+   */
+  ~AggregationNode();
+
   //----------------------------------------------------------------------------
   /*!
    * @brief     New main frame callback, aggregating frames
@@ -62,19 +76,75 @@ public:
    */
   void Callback(const CloudS::Ptr registeredCloud);
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Publish the whole aggregated cloud, if it has changed since last publication.
+   *
+   * As it requires to copy the whole dense map, this is done on a slow timer,
+   * while only the newly validated points are published at frame rate.
+   */
+  void PublishFullCloud(const ros::TimerEvent& = ros::TimerEvent());
+
   bool SavePointcloudService(lidar_slam::save_pcRequest& req, lidar_slam::save_pcResponse& res);
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Buffer an outer voxel leaving the dense map, to write it to disk.
+   * @param[in] coords      Global coordinates of the outer voxel
+   * @param[in] innerVoxels Points of the outer voxel
+   *
+   * If the voxel has already left the map since the last written tile, its
+   * parts are merged. The buffered voxels are written to a new tile once they
+   * hold more than TileMaxPoints points.
+   */
+  void FlushVoxel(const Eigen::Array3i& coords, const LidarSlam::RollingGrid::SamplingVG& innerVoxels);
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Write the buffered outer voxels to a new on-disk tile, and clear them.
+   * @return    false if the tile could not be written, true otherwise.
+   */
+  bool WriteTile();
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Merge the on-disk tiles and the current dense map to a PCD file.
+   * @param[in] path   Output PCD file path
+   * @param[in] format PCD data format. BINARY_COMPRESSED can not be streamed,
+   *                   BINARY is used instead.
+   * @return    true if the file has been written, false otherwise.
+   *
+   * The points are merged and written one outer voxel at a time, so that the
+   * whole dense cloud is never loaded in memory.
+   */
+  bool SaveOutOfCore(const std::string& path, LidarSlam::PCDFormat format);
+
 private:
 
   // ROS node handles, subscribers and publishers
   ros::NodeHandle &Nh, &PrivNh;
   ros::Subscriber FrameSubscriber;
   ros::Publisher PointsPublisher;
+  ros::Publisher NewPointsPublisher;
   ros::ServiceServer SaveService;
+  ros::Timer FullCloudTimer;
 
   // Dense map containing aggregated points from all frames
   std::shared_ptr<LidarSlam::RollingGrid> DenseMap;
-  CloudS::Ptr Pointcloud;
+  CloudS::Ptr Pointcloud;  ///< Last extracted aggregated cloud
+  pcl::PCLHeader LastHeader;  ///< Header of the last aggregated frame
+  bool DenseMapChanged = false;  ///< True if the dense map has changed since Pointcloud extraction
+
+  // Out-of-core accumulation : the outer voxels leaving the dense map are
+  // written to tiles in the native map file format, to be able to save the
+  // dense cloud of the whole run.
+  bool OutOfCore = false;
+  boost::filesystem::path TilesDirectory;  ///< Folder where the tiles are written
+  bool RemoveTilesDirectory = false;       ///< True if TilesDirectory is a temporary folder, removed on destruction
+  std::vector<std::string> Tiles;          ///< Paths of the tiles written so far, in writing order
+  unsigned int TileMaxPoints = 1000000;    ///< Number of buffered points triggering a tile writing
+  std::map<std::tuple<int, int, int>, LidarSlam::RollingGrid::SamplingVG> PendingVoxels;  ///< Outer voxels buffered to write, by global coordinates
+  unsigned int NbPendingPoints = 0;        ///< Number of points in PendingVoxels
 };
 
 #endif // AGGREGATION_NODE_H
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "AggregationNode.h"
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Main node entry point.
+ */
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "aggregation");
+  ros::NodeHandle nh;
+  ros::NodeHandle priv_nh("~");
+
+  // Create lidar slam node, which subscribes to pointclouds coming from conversion node
+  // and to external sensor messages in parallel.
+  AggregationNode slam(nh, priv_nh);
+
+  // Handle callbacks until shut down
+  ros::spin();
+
+  return 0;
+}
\ No newline at end of file
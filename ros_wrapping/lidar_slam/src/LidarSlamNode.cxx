@@ -25,6 +25,8 @@
 #include <geometry_msgs/TransformStamped.h>
 #include <nav_msgs/Path.h>
 
+#include <algorithm>
+
 #ifdef USE_CV_BRIDGE
 #include <cv_bridge/cv_bridge.h>
 #endif
@@ -58,6 +60,9 @@ enum Output
 
   CONFIDENCE,                // Publish confidence estimators on output pose to topic 'slam_confidence'.
 
+  TIMING,                    // Publish latency statistics of each SLAM processing stage to topic 'slam_timing'.
+  SYNC_TIMING,               // Publish latency statistics of the multi-LiDAR synchronization to topic 'slam_sync_timing'.
+
   PGO_PATH,              // Publish optimized SLAM trajectory as Path msg to 'pgo_slam_path' latched topic.
 };
 
@@ -94,33 +99,47 @@ LidarSlamNode::LidarSlamNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
 
   priv_nh.param("output/pose/tf",           this->Publish[POSE_TF],            true);
   priv_nh.param("output/pose/predicted_tf", this->Publish[POSE_PREDICTION_TF], false);
-  initPublisher(POSE_ODOM,            "slam_odom",           nav_msgs::Odometry, "output/pose/odom",           true,  1, false);
+  // All poses since last frame are published at once, so the queue must be able to hold them
+  initPublisher(POSE_ODOM,            "slam_odom",           nav_msgs::Odometry, "output/pose/odom",           true,  100, false);
   initPublisher(POSE_PREDICTION_ODOM, "slam_predicted_odom", nav_msgs::Odometry, "output/pose/predicted_odom", false, 1, false);
 
+  // Keypoints maps are published either as whole pointclouds, or as incremental updates.
+  // Updates are queued, as a missed update requires a full map to be sent again.
+  priv_nh.param("output/maps/incremental", this->IncrementalMaps, false);
+  #define initMapPublisher(publisher, name)                                                                                     \
+    if (this->IncrementalMaps)                                                                                                 \
+    {                                                                                                                          \
+      initPublisher(publisher, "map_updates/" name, lidar_slam::MapUpdate, "output/maps/" name, true, 10, false);              \
+    }                                                                                                                          \
+    else                                                                                                                       \
+    {                                                                                                                          \
+      initPublisher(publisher, "maps/" name, CloudS, "output/maps/" name, true, 1, false);                                     \
+    }
+
   if(this->LidarSlam.KeypointTypeEnabled(LidarSlam::EDGE))
   {
-    initPublisher(EDGES_MAP,  "maps/edges",  CloudS, "output/maps/edges",  true, 1, false);
+    initMapPublisher(EDGES_MAP,  "edges");
     initPublisher(EDGES_SUBMAP,  "submaps/edges",  CloudS, "output/submaps/edges",  true, 1, false);
     initPublisher(EDGE_KEYPOINTS,  "keypoints/edges",  CloudS, "output/keypoints/edges",  true, 1, false);
   }
 
   if(this->LidarSlam.KeypointTypeEnabled(LidarSlam::INTENSITY_EDGE))
   {
-    initPublisher(INTENSITY_EDGES_MAP,  "maps/intensity_edges",  CloudS, "output/maps/intensity_edges",  true, 1, false);
+    initMapPublisher(INTENSITY_EDGES_MAP,  "intensity_edges");
     initPublisher(INTENSITY_EDGES_SUBMAP,  "submaps/intensity_edges",  CloudS, "output/submaps/intensity_edges",  true, 1, false);
     initPublisher(INTENSITY_EDGE_KEYPOINTS,  "keypoints/intensity_edges",  CloudS, "output/keypoints/intensity_edges",  true, 1, false);
   }
 
   if(this->LidarSlam.KeypointTypeEnabled(LidarSlam::PLANE))
   {
-    initPublisher(PLANES_MAP, "maps/planes", CloudS, "output/maps/planes", true, 1, false);
+    initMapPublisher(PLANES_MAP, "planes");
     initPublisher(PLANES_SUBMAP, "submaps/planes", CloudS, "output/submaps/planes", true, 1, false);
     initPublisher(PLANE_KEYPOINTS, "keypoints/planes", CloudS, "output/keypoints/planes", true, 1, false);
   }
 
   if(this->LidarSlam.KeypointTypeEnabled(LidarSlam::BLOB))
   {
-    initPublisher(BLOBS_MAP,  "maps/blobs",  CloudS, "output/maps/blobs",  true, 1, false);
+    initMapPublisher(BLOBS_MAP,  "blobs");
     initPublisher(BLOBS_SUBMAP,  "submaps/blobs",  CloudS, "output/submaps/blobs",  true, 1, false);
     initPublisher(BLOB_KEYPOINTS,  "keypoints/blobs",  CloudS, "output/keypoints/blobs",  true, 1, false);
   }
@@ -129,6 +148,10 @@ LidarSlamNode::LidarSlamNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
 
   initPublisher(CONFIDENCE, "slam_confidence", lidar_slam::Confidence, "output/confidence", true, 1, false);
 
+  initPublisher(TIMING, "slam_timing", lidar_slam::TimingStatistics, "output/timing", false, 1, false);
+
+  initPublisher(SYNC_TIMING, "slam_sync_timing", lidar_slam::TimingStatistics, "output/sync_timing", false, 1, false);
+
   if (this->UseExtSensor[LidarSlam::GPS] || this->UseExtSensor[LidarSlam::LANDMARK_DETECTOR])
   {
     initPublisher(PGO_PATH, "pgo_slam_path", nav_msgs::Path, "graph/publish_path", false, 1, true);
@@ -136,6 +159,21 @@ LidarSlamNode::LidarSlamNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
 
   // Set frequency of output pose (all poses are published at the end of the frames process)
   priv_nh.param("output/pose/frequency", this->TrajFrequency, -1.);
+  // Set frequency of keypoints maps publication
+  priv_nh.param("output/maps/frequency", this->MapsFrequency, 1.);
+  // Set period of full maps publication, when publishing incremental updates
+  priv_nh.param("output/maps/full_period", this->FullMapsPeriod, 30.);
+  this->LidarSlam.SetMapChangesTracking(this->IncrementalMaps);
+
+  // Register disabled outputs too, so that the publishers maps are not
+  // modified anymore once the publication thread reads them
+  for (int output = POSE_ODOM; output <= PGO_PATH; ++output)
+    this->Publish.emplace(output, false);
+
+  // Publish outputs from a dedicated thread
+  priv_nh.param("output/async", this->AsyncPublishing, true);
+  if (this->AsyncPublishing)
+    this->OutputThread = std::thread(&LidarSlamNode::PublishOutputLoop, this);
 
   // ***************************************************************************
   // Init ROS subscribers
@@ -146,10 +184,23 @@ LidarSlamNode::LidarSlamNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
     lidarTopics.push_back(priv_nh.param<std::string>("input", "lidar_points"));
   this->CloudSubs.push_back(nh.subscribe(lidarTopics[0], 1, &LidarSlamNode::ScanCallback, this));
   ROS_INFO_STREAM("Using LiDAR frames on topic '" << lidarTopics[0] << "'");
-  for (unsigned int lidarTopicId = 1; lidarTopicId < lidarTopics.size(); lidarTopicId++)
+
+  // Secondary LiDAR inputs are received in parallel by their own spinner, and
+  // buffered to be synchronized with the main frames
+  this->NbSecondaryLidars = lidarTopics.size() - 1;
+  if (this->NbSecondaryLidars)
   {
-    this->CloudSubs.push_back(nh.subscribe(lidarTopics[lidarTopicId], 1, &LidarSlamNode::SecondaryScanCallback, this));
-    ROS_INFO_STREAM("Using secondary LiDAR frames on topic '" << lidarTopics[lidarTopicId] << "'");
+    priv_nh.param("input_sync/window", this->SyncWindow, 0.05);
+    priv_nh.param("input_sync/timeout", this->SyncTimeout, 0.05);
+    ros::NodeHandle secondaryNh(nh);
+    secondaryNh.setCallbackQueue(&this->SecondaryQueue);
+    for (unsigned int lidarTopicId = 1; lidarTopicId < lidarTopics.size(); lidarTopicId++)
+    {
+      this->CloudSubs.push_back(secondaryNh.subscribe(lidarTopics[lidarTopicId], 10, &LidarSlamNode::SecondaryScanCallback, this));
+      ROS_INFO_STREAM("Using secondary LiDAR frames on topic '" << lidarTopics[lidarTopicId] << "'");
+    }
+    this->SecondarySpinnerPtr = std::make_shared<ros::AsyncSpinner>(this->NbSecondaryLidars, &this->SecondaryQueue);
+    this->SecondarySpinnerPtr->start();
   }
 
   // Set SLAM pose from external guess
@@ -161,7 +212,29 @@ LidarSlamNode::LidarSlamNode(ros::NodeHandle& nh, ros::NodeHandle& priv_nh)
   // Init logging of GPS data for GPS/SLAM calibration or Pose Graph Optimization.
   // Perfect synchronization is not required as GPS data are not used in SLAM local process
   if (this->UseExtSensor[LidarSlam::GPS])
-    this->GpsOdomSub = nh.subscribe("gps_odom", 1, &LidarSlamNode::GpsCallback, this);
+  {
+    // GPS input can be the UTM odometry from gps_conversions nodes,
+    // or raw WGS84 fixes directly projected to UTM here, avoiding conversion hops
+    std::string gpsInput = priv_nh.param("external_sensors/gps/input", std::string("odom"));
+    if (gpsInput == "gps_fix" || gpsInput == "nav_sat_fix")
+    {
+      priv_nh.param("external_sensors/gps/utm_frame_id", this->GpsFrameId, std::string("utm"));
+      this->UtmProjection.SetZone(priv_nh.param("external_sensors/gps/utm_zone", 0),
+                                  priv_nh.param("external_sensors/gps/utm_north", true));
+      // Raw receivers may publish at high rate : do not drop fixes
+      if (gpsInput == "gps_fix")
+        this->GpsFixSub = nh.subscribe("gps_fix", 100, &LidarSlamNode::GpsFixCallback, this);
+      else
+        this->GpsFixSub = nh.subscribe("fix", 100, &LidarSlamNode::NavSatFixCallback, this);
+      ROS_INFO_STREAM("Using raw GPS fixes on topic '" << this->GpsFixSub.getTopic() << "', projected to UTM.");
+    }
+    else
+    {
+      if (gpsInput != "odom")
+        ROS_WARN_STREAM("Unknown GPS input '" << gpsInput << "', using 'odom'.");
+      this->GpsOdomSub = nh.subscribe("gps_odom", 1, &LidarSlamNode::GpsCallback, this);
+    }
+  }
 
   // Init logging of landmark data and/or Camera data
   if (this->UseExtSensor[LidarSlam::LANDMARK_DETECTOR] || this->UseExtSensor[LidarSlam::CAMERA])
@@ -206,6 +279,19 @@ LidarSlamNode::~LidarSlamNode()
     // Not stopping async spinner can lead to boost::lock error on shutdown
     if (ExternalSpinnerPtr)
         this->ExternalSpinnerPtr->stop();
+    if (this->SecondarySpinnerPtr)
+        this->SecondarySpinnerPtr->stop();
+
+    // Stop output publication thread
+    if (this->OutputThread.joinable())
+    {
+      {
+        std::lock_guard<std::mutex> lock(this->OutputMutex);
+        this->StopPublishing = true;
+      }
+      this->OutputCondition.notify_one();
+      this->OutputThread.join();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -241,15 +327,41 @@ void LidarSlamNode::ScanCallback(const CloudS::Ptr cloudS_ptr)
   if (!this->UpdateBaseToLidarOffset(cloudS_ptr->header.frame_id, cloudS_ptr->front().device_id))
     return;
 
-  // Set the SLAM main input frame at first position
-  this->Frames.insert(this->Frames.begin(), cloudS_ptr);
+  // Gather the secondary frames acquired at the same time
+  std::vector<CloudS::Ptr> frames = this->SynchronizeFrames(cloudS_ptr);
 
   // Run SLAM : register new frame and update localization and map.
-  this->LidarSlam.AddFrames(this->Frames);
-  this->Frames.clear();
+  this->LidarSlam.AddFrames(frames);
+
+  // Publish background pose graph optimization results once applied
+  if (this->GraphOptimizationPending && !this->LidarSlam.IsGraphOptimizationPending())
+  {
+    this->GraphOptimizationPending = false;
+    if (this->LidarSlam.GetLastGraphOptimizationSuccess())
+      this->PublishGraphOptimizationResults();
+    else
+      ROS_WARN_STREAM("Background pose graph optimization failed : its results are not published");
+  }
 
   // Publish SLAM output as requested by user
-  this->PublishOutput();
+  // In async mode, the snapshot is handed to the publication thread, and SLAM
+  // can process the next frame without waiting for the outputs serialization.
+  std::shared_ptr<const OutputSnapshot> snapshot = this->BuildOutputSnapshot();
+  if (!this->AsyncPublishing)
+    this->PublishOutput(*snapshot);
+  else if (this->OutputQueue.push(snapshot))
+  {
+    // Lock the mutex to ensure the publication thread is either waiting or
+    // about to check the queue, so that the notification is not lost.
+    { std::lock_guard<std::mutex> lock(this->OutputMutex); }
+    this->OutputCondition.notify_one();
+  }
+  else
+  {
+    ROS_WARN_STREAM_THROTTLE(1., "Output publication is too slow : dropping SLAM outputs of current frame.");
+    // Incremental maps updates have been lost : send full maps next time
+    this->FullMapsRequested = true;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -261,12 +373,31 @@ void LidarSlamNode::SecondaryScanCallback(const CloudS::Ptr cloudS_ptr)
     return;
   }
 
-  // Update TF from BASE to LiDAR for this device
-  if (!this->UpdateBaseToLidarOffset(cloudS_ptr->header.frame_id, cloudS_ptr->front().device_id))
+  // Get TF from BASE to LiDAR for this device.
+  // It will be set to SLAM with the frame, as SLAM may be running meanwhile.
+  SecondaryFrame frame;
+  frame.Cloud = cloudS_ptr;
+  frame.Time = LidarSlam::Utils::PclStampToSec(cloudS_ptr->header.stamp);
+  frame.ReceptionTime = std::chrono::steady_clock::now();
+  Eigen::Isometry3d baseToLidar = Eigen::Isometry3d::Identity();
+  if (cloudS_ptr->header.frame_id != this->TrackingFrameId &&
+      !Utils::Tf2LookupTransform(baseToLidar, this->TfBuffer, this->TrackingFrameId, cloudS_ptr->header.frame_id))
     return;
+  frame.BaseToLidar = baseToLidar;
 
-  // Add new frame to SLAM input frames
-  this->Frames.push_back(cloudS_ptr);
+  // Buffer new frame, keeping frames sorted by time
+  {
+    std::lock_guard<std::mutex> lock(this->SyncMutex);
+    std::deque<SecondaryFrame>& frames = this->SecondaryDevices[cloudS_ptr->front().device_id].Frames;
+    auto it = std::upper_bound(frames.begin(), frames.end(), frame.Time,
+                               [](double time, const SecondaryFrame& f) { return time < f.Time; });
+    frames.insert(it, frame);
+    // Bound the buffer if main frames are not received anymore
+    const unsigned int maxBufferedFrames = 10;
+    while (frames.size() > maxBufferedFrames)
+      frames.pop_front();
+  }
+  this->SecondaryFrameReceived.notify_one();
 }
 
 //------------------------------------------------------------------------------
@@ -366,6 +497,80 @@ void LidarSlamNode::GpsCallback(const nav_msgs::Odometry& gpsMsg)
     ROS_WARN_STREAM("The transform between the GPS and the tracking frame was not found -> GPS info ignored");
 }
 
+//------------------------------------------------------------------------------
+void LidarSlamNode::GpsFixCallback(const gps_common::GPSFix& msg)
+{
+  if (msg.status.status < gps_common::GPSStatus::STATUS_FIX)
+    return;
+  this->AddGpsFix(msg.header, msg.latitude, msg.longitude, msg.altitude, msg.position_covariance);
+}
+
+//------------------------------------------------------------------------------
+void LidarSlamNode::NavSatFixCallback(const sensor_msgs::NavSatFix& msg)
+{
+  if (msg.status.status < sensor_msgs::NavSatStatus::STATUS_FIX)
+    return;
+  this->AddGpsFix(msg.header, msg.latitude, msg.longitude, msg.altitude, msg.position_covariance);
+}
+
+//------------------------------------------------------------------------------
+void LidarSlamNode::AddGpsFix(const std_msgs::Header& header, double latitude, double longitude, double altitude,
+                              const boost::array<double, 9>& covariance)
+{
+  if (!this->UseExtSensor[LidarSlam::GPS])
+    return;
+
+  // Project GPS fix to UTM, in the zone of the 1st fix (or the imposed one)
+  bool firstFix = !this->UtmProjection.GetBand();
+  Eigen::Vector3d position;
+  if (!this->UtmProjection.Project(latitude, longitude, altitude, position))
+  {
+    ROS_WARN_STREAM_THROTTLE(1, "Invalid GPS fix (lat " << latitude << ", lon " << longitude << ") -> GPS info ignored");
+    return;
+  }
+  if (firstFix)
+  {
+    // Share UTM zone/band as gps_to_utm does, for other GPS conversions
+    std::string utmBandLetter(1, this->UtmProjection.GetBand());
+    ros::param::set("utm_zone", this->UtmProjection.GetZone());
+    ros::param::set("utm_band", utmBandLetter);
+    ROS_INFO_STREAM("GPS fixes projected to UTM zone " << this->UtmProjection.GetZone() << utmBandLetter << ".");
+  }
+
+  // GPS calibration is only needed for the 1st measurement
+  if (!this->LidarSlam.GpsHasData())
+  {
+    // Transform to apply to points represented in GPS frame to express them in base frame
+    Eigen::Isometry3d baseToGps;
+    if (!Utils::Tf2LookupTransform(baseToGps, this->TfBuffer, this->TrackingFrameId, header.frame_id, header.stamp))
+    {
+      ROS_WARN_STREAM("The transform between the GPS and the tracking frame was not found -> GPS info ignored");
+      return;
+    }
+    this->LidarSlam.SetGpsCalibration(baseToGps);
+  }
+
+  // Get gps position and timestamp
+  this->LastGpsMeas.Position = position;
+  this->LastGpsMeas.Time = header.stamp.sec + header.stamp.nsec * 1e-9;
+
+  // Get GPS covariance
+  // ROS covariance message is row major
+  // Eigen matrix is col major by default
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+      this->LastGpsMeas.Covariance(i, j) = covariance[i * 3 + j];
+  }
+  // Correct GPS covariance if needed
+  if (!LidarSlam::Utils::isCovarianceValid(this->LastGpsMeas.Covariance))
+    this->LastGpsMeas.Covariance = Eigen::Matrix3d::Identity() * 4e-4; // 2cm
+
+  // Add gps measurement to measurements list
+  this->LidarSlam.AddGpsMeasurement(this->LastGpsMeas);
+  this->GpsLastTime = header.stamp;
+}
+
 //------------------------------------------------------------------------------
 int LidarSlamNode::BuildId(const std::vector<int>& ids)
 {
@@ -662,12 +867,18 @@ void LidarSlamNode::SlamCommandCallback(const lidar_slam::SlamCommand& msg)
       break;
     }
 
-    // Save SLAM keypoints maps to PCD files
+    // Save SLAM keypoints maps to PCD files or to native map files
     case lidar_slam::SlamCommand::SAVE_KEYPOINTS_MAPS:
     {
-      ROS_INFO_STREAM("Saving keypoints maps to PCD.");
       if (this->LidarSlam.GetMapUpdate() == LidarSlam::MappingMode::NONE)
         ROS_WARN_STREAM("The initially loaded maps were not modified but are saved anyway.");
+      if (this->PrivNh.param("maps/native_format", false))
+      {
+        ROS_INFO_STREAM("Saving keypoints maps to native map files.");
+        this->LidarSlam.SaveMapsToMapFile(msg.string_arg);
+        break;
+      }
+      ROS_INFO_STREAM("Saving keypoints maps to PCD.");
       int pcdFormatInt = this->PrivNh.param("maps/export_pcd_format", static_cast<int>(LidarSlam::PCDFormat::BINARY_COMPRESSED));
       LidarSlam::PCDFormat pcdFormat = static_cast<LidarSlam::PCDFormat>(pcdFormatInt);
       if (pcdFormat != LidarSlam::PCDFormat::ASCII &&
@@ -698,11 +909,22 @@ void LidarSlamNode::SlamCommandCallback(const lidar_slam::SlamCommand& msg)
       break;
     }
 
-    // Load SLAM keypoints maps from PCD files
+    // Load SLAM keypoints maps from PCD files or from native map files
     case lidar_slam::SlamCommand::LOAD_KEYPOINTS_MAPS:
     {
-      ROS_INFO_STREAM("Loading keypoints maps from PCD.");
-      this->LidarSlam.LoadMapsFromPCD(msg.string_arg);
+      this->LoadMaps(msg.string_arg);
+      break;
+    }
+
+    // Send the whole keypoints maps with the next incremental maps updates
+    case lidar_slam::SlamCommand::PUBLISH_FULL_MAPS:
+    {
+      if (!this->IncrementalMaps)
+      {
+        ROS_WARN_STREAM("Cannot publish full maps as maps are not published incrementally.");
+        break;
+      }
+      this->FullMapsRequested = true;
       break;
     }
 
@@ -728,23 +950,20 @@ void LidarSlamNode::SlamCommandCallback(const lidar_slam::SlamCommand& msg)
           ROS_WARN_STREAM("No absolute landmark poses are supplied : the last estimated poses will be used");
       }
 
-      ROS_INFO_STREAM("Optimizing the pose graph");
-      this->LidarSlam.OptimizeGraph();
-      // Broadcast new calibration offset (GPS to base)
-      // if GPS used
-      if (this->LidarSlam.GpsHasData())
-        this->BroadcastGpsOffset();
-      // Publish new trajectory
-      if (this->Publish[PGO_PATH])
+      if (this->AsyncGraphOptimization)
       {
-        nav_msgs::Path optimSlamTraj;
-        optimSlamTraj.header.frame_id = this->OdometryFrameId;
-        std::list<LidarSlam::LidarState> optimizedSlamStates = this->LidarSlam.GetLogStates();
-        optimSlamTraj.header.stamp = ros::Time(optimizedSlamStates.back().Time);
-        for (const LidarSlam::LidarState& s: optimizedSlamStates)
-          optimSlamTraj.poses.emplace_back(Utils::IsometryToPoseStampedMsg(s.Isometry, s.Time, this->OdometryFrameId));
-        this->Publishers[PGO_PATH].publish(optimSlamTraj);
+        // Results are published once applied, after a next frame processing
+        ROS_INFO_STREAM("Optimizing the pose graph in background");
+        if (this->LidarSlam.OptimizeGraphAsync())
+          this->GraphOptimizationPending = true;
+        break;
       }
+
+      ROS_INFO_STREAM("Optimizing the pose graph");
+      if (this->LidarSlam.OptimizeGraph())
+        this->PublishGraphOptimizationResults();
+      else
+        ROS_WARN_STREAM("Pose graph optimization failed : its results are not published");
       break;
     }
 
@@ -800,11 +1019,181 @@ bool LidarSlamNode::UpdateBaseToLidarOffset(const std::string& lidarFrameId, uin
 }
 
 //------------------------------------------------------------------------------
-void LidarSlamNode::PublishOutput()
+std::vector<LidarSlamNode::CloudS::Ptr> LidarSlamNode::SynchronizeFrames(const CloudS::Ptr& mainFrame)
 {
+  // Set the SLAM main input frame at first position
+  std::vector<CloudS::Ptr> frames = {mainFrame};
+  if (!this->NbSecondaryLidars)
+    return frames;
+
+  double mainTime = LidarSlam::Utils::PclStampToSec(mainFrame->header.stamp);
+  std::map<uint8_t, SecondaryFrame> matched;
+
+  // Match the closest buffered frame of each device, within the time window.
+  // Frames older than the matched one, or too old to match any later main
+  // frame, are dropped. Return true once all devices have been matched.
+  auto matchFrames = [&]()
+  {
+    for (auto& device : this->SecondaryDevices)
+    {
+      if (matched.count(device.first))
+        continue;
+      std::deque<SecondaryFrame>& buffer = device.second.Frames;
+      while (!buffer.empty() && buffer.front().Time < mainTime - this->SyncWindow)
+        buffer.pop_front();
+      auto best = buffer.end();
+      for (auto it = buffer.begin(); it != buffer.end() && it->Time <= mainTime + this->SyncWindow; ++it)
+      {
+        if (best == buffer.end() || std::abs(it->Time - mainTime) < std::abs(best->Time - mainTime))
+          best = it;
+      }
+      if (best != buffer.end())
+      {
+        matched[device.first] = *best;
+        buffer.erase(buffer.begin(), std::next(best));
+      }
+    }
+    return matched.size() >= this->NbSecondaryLidars;
+  };
+
+  // Wait for the missing devices, with a bounded latency
+  auto waitStart = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(this->SyncMutex);
+  this->SecondaryFrameReceived.wait_until(lock, waitStart + std::chrono::duration<double>(this->SyncTimeout), matchFrames);
+  auto now = std::chrono::steady_clock::now();
+  this->SyncWaitTime.Record(std::chrono::duration<double>(now - waitStart).count());
+  if (matched.size() < this->NbSecondaryLidars)
+    ROS_WARN_STREAM_THROTTLE(1., "Only " << matched.size() << " of the " << this->NbSecondaryLidars
+                             << " secondary LiDAR frames have been received in time, "
+                             << "the missing ones are not used for this frame.");
+
+  // Add the matched frames, with their device TF
+  for (const auto& deviceFrame : matched)
+  {
+    const SecondaryFrame& frame = deviceFrame.second;
+    SecondaryDevice& device = this->SecondaryDevices[deviceFrame.first];
+    device.Latency.Record(std::chrono::duration<double>(now - frame.ReceptionTime).count());
+    device.TimeOffset.Record(std::abs(frame.Time - mainTime));
+    this->LidarSlam.SetBaseToLidarOffset(frame.BaseToLidar, deviceFrame.first);
+    frames.push_back(frame.Cloud);
+  }
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const LidarSlamNode::OutputSnapshot> LidarSlamNode::BuildOutputSnapshot()
+{
+  std::shared_ptr<OutputSnapshot> snapshot(new OutputSnapshot);
+
   // Get current SLAM poses in WORLD coordinates at the specified frequency
-  std::vector<LidarSlam::LidarState> lastStates = this->LidarSlam.GetLastStates(this->TrajFrequency);
-  double computationTime = (ros::Time::now().toSec() - this->StartTime);
+  snapshot->States = this->LidarSlam.GetLastStates(this->TrajFrequency);
+  snapshot->ComputationTime = (ros::Time::now().toSec() - this->StartTime);
+  double frameTime = snapshot->States.back().Time;
+
+  // Get latency compensated SLAM pose
+  if (this->Publish[POSE_PREDICTION_ODOM] || this->Publish[POSE_PREDICTION_TF])
+  {
+    snapshot->PredictionTime = frameTime + snapshot->ComputationTime;
+    snapshot->PredictionIsometry = this->LidarSlam.GetTworld(snapshot->PredictionTime);
+  }
+
+  // Get a pointcloud only if required and if someone is listening to it to spare bandwidth.
+  #define addPointCloud(publisher, pc)                                                \
+    if (this->Publish[publisher] && this->Publishers[publisher].getNumSubscribers())  \
+      snapshot->Clouds[publisher] = pc;
+
+  // Keypoints maps, extracted at most at the required frequency as they can be large
+  if (this->MapsFrequency <= 0. || this->LastMapsTime < 0. ||
+      frameTime - this->LastMapsTime >= 1. / this->MapsFrequency || frameTime < this->LastMapsTime)
+  {
+    this->LastMapsTime = frameTime;
+    if (this->IncrementalMaps)
+    {
+      // Send the full maps periodically or on request, and only the modified voxels otherwise.
+      // A new subscriber also gets the full map.
+      bool full = this->FullMapsRequested || (this->FullMapsPeriod > 0. &&
+                  (frameTime - this->LastFullMapsTime >= this->FullMapsPeriod || frameTime < this->LastFullMapsTime));
+      auto addMapChanges = [&](int publisher, LidarSlam::Keypoint k)
+      {
+        if (!this->Publish[publisher])
+          return;
+        uint32_t nbSubscribers = this->Publishers[publisher].getNumSubscribers();
+        if (nbSubscribers)
+        {
+          LidarSlam::RollingGrid::Changes changes = this->LidarSlam.GetMapChanges(k, full || nbSubscribers > this->MapsSubscribers[publisher]);
+          if (changes.Full || !changes.Voxels.empty())
+            snapshot->MapsChanges[publisher] = {this->MapsSequence[publisher]++, std::move(changes)};
+        }
+        this->MapsSubscribers[publisher] = nbSubscribers;
+      };
+      addMapChanges(EDGES_MAP,  LidarSlam::EDGE);
+      addMapChanges(INTENSITY_EDGES_MAP,  LidarSlam::INTENSITY_EDGE);
+      addMapChanges(PLANES_MAP, LidarSlam::PLANE);
+      addMapChanges(BLOBS_MAP,  LidarSlam::BLOB);
+      if (full)
+        this->LastFullMapsTime = frameTime;
+      this->FullMapsRequested = false;
+    }
+    else
+    {
+      addPointCloud(EDGES_MAP,  this->LidarSlam.GetMap(LidarSlam::EDGE));
+      addPointCloud(INTENSITY_EDGES_MAP,  this->LidarSlam.GetMap(LidarSlam::INTENSITY_EDGE));
+      addPointCloud(PLANES_MAP, this->LidarSlam.GetMap(LidarSlam::PLANE));
+      addPointCloud(BLOBS_MAP,  this->LidarSlam.GetMap(LidarSlam::BLOB));
+    }
+  }
+
+  // Keypoints submaps
+  // The submap can be kept by the SLAM for several frames with its header
+  // updated in place, so it is copied to remain unchanged during publication.
+  #define addSubMap(publisher, k) \
+    addPointCloud(publisher, CloudS::Ptr(new CloudS(*this->LidarSlam.GetTargetSubMap(k))));
+  addSubMap(EDGES_SUBMAP,  LidarSlam::EDGE);
+  addSubMap(INTENSITY_EDGES_SUBMAP,  LidarSlam::INTENSITY_EDGE);
+  addSubMap(PLANES_SUBMAP, LidarSlam::PLANE);
+  addSubMap(BLOBS_SUBMAP,  LidarSlam::BLOB);
+
+  // Current keypoints
+  addPointCloud(EDGE_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::EDGE));
+  addPointCloud(INTENSITY_EDGE_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::INTENSITY_EDGE));
+  addPointCloud(PLANE_KEYPOINTS, this->LidarSlam.GetKeypoints(LidarSlam::PLANE));
+  addPointCloud(BLOB_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::BLOB));
+
+  // Registered aggregated (and optionally undistorted) input scans points
+  addPointCloud(SLAM_REGISTERED_POINTS, this->LidarSlam.GetRegisteredFrame());
+
+  // Confidence estimators
+  if (this->Publish[CONFIDENCE])
+  {
+    snapshot->Overlap = this->LidarSlam.GetOverlapEstimation();
+    snapshot->NbMatches = this->LidarSlam.GetTotalMatchedKeypoints();
+    snapshot->ComplyMotionLimits = this->LidarSlam.GetComplyMotionLimits();
+  }
+
+  // Processing stages latency statistics
+  if (this->Publish[TIMING])
+    snapshot->Timings = this->LidarSlam.GetTimingStatistics();
+
+  // Multi-LiDAR synchronization statistics
+  if (this->Publish[SYNC_TIMING] && this->NbSecondaryLidars)
+  {
+    std::lock_guard<std::mutex> lock(this->SyncMutex);
+    snapshot->SyncTimings["wait"] = this->SyncWaitTime.GetStatistics();
+    for (const auto& device : this->SecondaryDevices)
+    {
+      std::string deviceName = "device_" + std::to_string(device.first);
+      snapshot->SyncTimings[deviceName + "/latency"] = device.second.Latency.GetStatistics();
+      snapshot->SyncTimings[deviceName + "/time_offset"] = device.second.TimeOffset.GetStatistics();
+    }
+  }
+
+  return snapshot;
+}
+
+//------------------------------------------------------------------------------
+void LidarSlamNode::PublishOutput(const OutputSnapshot& snapshot)
+{
+  const std::vector<LidarSlam::LidarState>& lastStates = snapshot.States;
   // Publish SLAM pose
   if (this->Publish[POSE_ODOM] || this->Publish[POSE_TF])
   {
@@ -837,27 +1226,20 @@ void LidarSlamNode::PublishOutput()
         tfMsg.transform = Utils::IsometryToTfMsg(state.Isometry);
         this->TfBroadcaster.sendTransform(tfMsg);
       }
-
-      // Enable subscribers to receive those messages
-      // Warning : this may alter cout working in this code area
-      ros::Duration(1e-6).sleep();
     }
   }
 
   // Publish latency compensated SLAM pose
   if (this->Publish[POSE_PREDICTION_ODOM] || this->Publish[POSE_PREDICTION_TF])
   {
-    double predTime = lastStates.back().Time + computationTime;
-    Eigen::Isometry3d predIsometry = this->LidarSlam.GetTworld(predTime);
-
     // Publish as odometry msg
     if (this->Publish[POSE_PREDICTION_ODOM])
     {
       nav_msgs::Odometry odomMsg;
-      odomMsg.header.stamp = ros::Time(predTime);
+      odomMsg.header.stamp = ros::Time(snapshot.PredictionTime);
       odomMsg.header.frame_id = this->OdometryFrameId;
       odomMsg.child_frame_id = this->TrackingFrameId + "_prediction";
-      odomMsg.pose.pose = Utils::IsometryToPoseMsg(predIsometry);
+      odomMsg.pose.pose = Utils::IsometryToPoseMsg(snapshot.PredictionIsometry);
       for (unsigned int i = 0; i < lastStates.back().Covariance.size(); ++i)
         odomMsg.pose.covariance[i] = lastStates.back().Covariance(i);
       this->Publishers[POSE_PREDICTION_ODOM].publish(odomMsg);
@@ -867,39 +1249,40 @@ void LidarSlamNode::PublishOutput()
     if (this->Publish[POSE_PREDICTION_TF])
     {
       geometry_msgs::TransformStamped tfMsg;
-      tfMsg.header.stamp = ros::Time(predTime);
+      tfMsg.header.stamp = ros::Time(snapshot.PredictionTime);
       tfMsg.header.frame_id = this->OdometryFrameId;
       tfMsg.child_frame_id = this->TrackingFrameId + "_prediction";
-      tfMsg.transform = Utils::IsometryToTfMsg(predIsometry);
+      tfMsg.transform = Utils::IsometryToTfMsg(snapshot.PredictionIsometry);
       this->TfBroadcaster.sendTransform(tfMsg);
     }
   }
 
-  // Publish a pointcloud only if required and if someone is listening to it to spare bandwidth.
-  #define publishPointCloud(publisher, pc)                                            \
-    if (this->Publish[publisher] && this->Publishers[publisher].getNumSubscribers())  \
-      this->Publishers[publisher].publish(pc);
-
-  // Keypoints maps
-  publishPointCloud(EDGES_MAP,  this->LidarSlam.GetMap(LidarSlam::EDGE));
-  publishPointCloud(INTENSITY_EDGES_MAP,  this->LidarSlam.GetMap(LidarSlam::INTENSITY_EDGE));
-  publishPointCloud(PLANES_MAP, this->LidarSlam.GetMap(LidarSlam::PLANE));
-  publishPointCloud(BLOBS_MAP,  this->LidarSlam.GetMap(LidarSlam::BLOB));
+  // Keypoints maps and submaps, current keypoints and registered points
+  for (const auto& cloud : snapshot.Clouds)
+    this->Publishers[cloud.first].publish(cloud.second);
 
-  // Keypoints submaps
-  publishPointCloud(EDGES_SUBMAP,  this->LidarSlam.GetTargetSubMap(LidarSlam::EDGE));
-  publishPointCloud(INTENSITY_EDGES_SUBMAP,  this->LidarSlam.GetTargetSubMap(LidarSlam::INTENSITY_EDGE));
-  publishPointCloud(PLANES_SUBMAP, this->LidarSlam.GetTargetSubMap(LidarSlam::PLANE));
-  publishPointCloud(BLOBS_SUBMAP,  this->LidarSlam.GetTargetSubMap(LidarSlam::BLOB));
-
-  // Current keypoints
-  publishPointCloud(EDGE_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::EDGE));
-  publishPointCloud(INTENSITY_EDGE_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::INTENSITY_EDGE));
-  publishPointCloud(PLANE_KEYPOINTS, this->LidarSlam.GetKeypoints(LidarSlam::PLANE));
-  publishPointCloud(BLOB_KEYPOINTS,  this->LidarSlam.GetKeypoints(LidarSlam::BLOB));
-
-  // Registered aggregated (and optionally undistorted) input scans points
-  publishPointCloud(SLAM_REGISTERED_POINTS, this->LidarSlam.GetRegisteredFrame());
+  // Incremental keypoints maps updates
+  for (const auto& mapChanges : snapshot.MapsChanges)
+  {
+    const LidarSlam::RollingGrid::Changes& changes = mapChanges.second.second;
+    lidar_slam::MapUpdate updateMsg;
+    updateMsg.header.stamp = ros::Time(lastStates.back().Time);
+    updateMsg.header.frame_id = this->OdometryFrameId;
+    updateMsg.sequence = mapChanges.second.first;
+    updateMsg.full = changes.Full;
+    updateMsg.voxel_width = changes.VoxelWidth;
+    updateMsg.voxels.resize(changes.Voxels.size());
+    for (unsigned int i = 0; i < changes.Voxels.size(); ++i)
+    {
+      lidar_slam::MapVoxel& voxelMsg = updateMsg.voxels[i];
+      voxelMsg.x = changes.Voxels[i].first.x();
+      voxelMsg.y = changes.Voxels[i].first.y();
+      voxelMsg.z = changes.Voxels[i].first.z();
+      pcl::toROSMsg(*changes.Voxels[i].second, voxelMsg.points);
+      voxelMsg.points.header = updateMsg.header;
+    }
+    this->Publishers[mapChanges.first].publish(updateMsg);
+  }
 
   // Overlap estimation
   if (this->Publish[CONFIDENCE])
@@ -908,16 +1291,62 @@ void LidarSlamNode::PublishOutput()
     lidar_slam::Confidence confidenceMsg;
     confidenceMsg.header.stamp = ros::Time(lastStates.back().Time);
     confidenceMsg.header.frame_id = this->OdometryFrameId;
-    confidenceMsg.overlap = this->LidarSlam.GetOverlapEstimation();
-    confidenceMsg.computation_time = computationTime;
+    confidenceMsg.overlap = snapshot.Overlap;
+    confidenceMsg.computation_time = snapshot.ComputationTime;
     // Note : in eigen 3.4, iterators are available on matrices directly
     //        >> std::copy(lastStates.back().Covariance.begin(), lastStates.back().Covariance.end(), confidenceMsg.covariance.begin());
     for (unsigned int i = 0; i < lastStates.back().Covariance.size(); ++i)
       confidenceMsg.covariance[i] = lastStates.back().Covariance(i);
-    confidenceMsg.nb_matches = this->LidarSlam.GetTotalMatchedKeypoints();
-    confidenceMsg.comply_motion_limits = this->LidarSlam.GetComplyMotionLimits();
+    confidenceMsg.nb_matches = snapshot.NbMatches;
+    confidenceMsg.comply_motion_limits = snapshot.ComplyMotionLimits;
     this->Publishers[CONFIDENCE].publish(confidenceMsg);
   }
+
+  // Processing stages and multi-LiDAR synchronization latency statistics
+  auto publishTimings = [&](int publisher, const std::map<std::string, LidarSlam::Profiling::Statistics>& timings)
+  {
+    lidar_slam::TimingStatistics timingMsg;
+    timingMsg.header.stamp = ros::Time(lastStates.back().Time);
+    timingMsg.header.frame_id = this->OdometryFrameId;
+    for (const auto& stage : timings)
+    {
+      lidar_slam::StageTiming stageMsg;
+      stageMsg.name  = stage.first;
+      stageMsg.count = stage.second.Count;
+      stageMsg.mean  = stage.second.Mean;
+      stageMsg.p50   = stage.second.P50;
+      stageMsg.p95   = stage.second.P95;
+      stageMsg.p99   = stage.second.P99;
+      stageMsg.max   = stage.second.Max;
+      timingMsg.stages.push_back(stageMsg);
+    }
+    this->Publishers[publisher].publish(timingMsg);
+  };
+  if (this->Publish[TIMING])
+    publishTimings(TIMING, snapshot.Timings);
+  if (this->Publish[SYNC_TIMING] && !snapshot.SyncTimings.empty())
+    publishTimings(SYNC_TIMING, snapshot.SyncTimings);
+}
+
+//------------------------------------------------------------------------------
+void LidarSlamNode::PublishOutputLoop()
+{
+  std::shared_ptr<const OutputSnapshot> snapshot;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->OutputMutex);
+      this->OutputCondition.wait(lock, [this]{ return this->StopPublishing || this->OutputQueue.read_available(); });
+      if (this->StopPublishing)
+        return;
+    }
+    // Publish all pending snapshots, in order, so that no pose is lost
+    while (this->OutputQueue.pop(snapshot))
+    {
+      this->PublishOutput(*snapshot);
+      snapshot.reset();
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -928,8 +1357,11 @@ void LidarSlamNode::SetSlamParameters()
   SetSlamParam(bool,   "slam/2d_mode", TwoDMode)
   SetSlamParam(int,    "slam/verbosity", Verbosity)
   SetSlamParam(int,    "slam/n_threads", NbThreads)
+  SetSlamParam(double, "slam/input_downsampling_leaf_size", InputDownsamplingLeafSize)
   SetSlamParam(double, "slam/logging/timeout", LoggingTimeout)
   SetSlamParam(bool,   "slam/logging/only_keyframes", LogOnlyKeyframes)
+  SetSlamParam(bool,   "slam/logging/async", LoggingAsync)
+  SetSlamParam(double, "slam/logging/precision", LoggingPrecision)
   int egoMotionMode;
   if (this->PrivNh.getParam("slam/ego_motion", egoMotionMode))
   {
@@ -978,7 +1410,9 @@ void LidarSlamNode::SetSlamParameters()
         storage != LidarSlam::PointCloudStorageType::OCTREE_COMPRESSED &&
         storage != LidarSlam::PointCloudStorageType::PCD_ASCII &&
         storage != LidarSlam::PointCloudStorageType::PCD_BINARY &&
-        storage != LidarSlam::PointCloudStorageType::PCD_BINARY_COMPRESSED)
+        storage != LidarSlam::PointCloudStorageType::PCD_BINARY_COMPRESSED &&
+        storage != LidarSlam::PointCloudStorageType::LIDAR_COMPRESSED &&
+        storage != LidarSlam::PointCloudStorageType::MAPPED_FILE)
     {
       ROS_ERROR_STREAM("Incorrect pointcloud logging type value (" << storage << "). Setting it to 'PCL'.");
       storage = LidarSlam::PointCloudStorageType::PCL_CLOUD;
@@ -1102,10 +1536,28 @@ void LidarSlamNode::SetSlamParameters()
   SetSlamParam(bool,        "graph/fix_last", FixLastVertex)
   SetSlamParam(float,       "graph/covariance_scale", CovarianceScale)
   SetSlamParam(int,         "graph/iterations_nb", NbGraphIterations)
+  SetSlamParam(bool,        "graph/incremental", IncrementalGraph)
+  SetSlamParam(bool,        "graph/keyframes_only", GraphKeyframesOnly)
+  SetSlamParam(double,      "graph/map_update/distance_threshold", MapUpdateDistanceThreshold)
+  SetSlamParam(double,      "graph/map_update/angle_threshold", MapUpdateAngleThreshold)
+  this->AsyncGraphOptimization = this->PrivNh.param("graph/async", false);
 
   // Confidence estimators
   // Overlap
   SetSlamParam(float,  "slam/confidence/overlap/sampling_ratio", OverlapSamplingRatio)
+  int overlapMode;
+  if (this->PrivNh.getParam("slam/confidence/overlap/mode", overlapMode))
+  {
+    LidarSlam::OverlapMode overlap = static_cast<LidarSlam::OverlapMode>(overlapMode);
+    if (overlap != LidarSlam::OverlapMode::LCP &&
+        overlap != LidarSlam::OverlapMode::MATCHING &&
+        overlap != LidarSlam::OverlapMode::VOXEL_OCCUPANCY)
+    {
+      ROS_ERROR_STREAM("Invalid overlap estimator mode (" << overlapMode << "). Setting it to 'LCP'.");
+      overlap = LidarSlam::OverlapMode::LCP;
+    }
+    this->LidarSlam.SetOverlapEstimator(overlap);
+  }
   // Motion limitations (hard constraints to detect failure)
   std::vector<float> acc;
   if (this->PrivNh.getParam("slam/confidence/motion_limits/acceleration", acc) && acc.size() == 2)
@@ -1146,6 +1598,10 @@ void LidarSlamNode::SetSlamParameters()
   SetSlamParam(int,    "slam/voxel_grid/size", VoxelGridSize)
   SetSlamParam(double, "slam/voxel_grid/decaying_threshold", VoxelGridDecayingThreshold)
   SetSlamParam(int,    "slam/voxel_grid/min_frames_per_voxel", VoxelGridMinFramesPerVoxel)
+  SetSlamParam(bool,   "slam/voxel_grid/paging/enable", MapPaging)
+  SetSlamParam(double, "slam/voxel_grid/paging/radius", MapPagingRadius)
+  SetSlamParam(double, "slam/voxel_grid/paging/look_ahead", MapPagingLookAhead)
+  SetSlamParam(int,    "slam/voxel_grid/paging/max_points", MapPagingMaxPoints)
   for (auto k : LidarSlam::KeypointTypes)
   {
     if (!this->LidarSlam.KeypointTypeEnabled(k))
@@ -1170,16 +1626,28 @@ void LidarSlamNode::SetSlamParameters()
   }
 }
 
+//------------------------------------------------------------------------------
+void LidarSlamNode::LoadMaps(const std::string& mapsPathPrefix)
+{
+  if (this->PrivNh.param("maps/native_format", false))
+  {
+    ROS_INFO_STREAM("Loading keypoints maps from native map files.");
+    this->LidarSlam.LoadMapsFromMapFile(mapsPathPrefix);
+  }
+  else
+  {
+    ROS_INFO_STREAM("Loading keypoints maps from PCD.");
+    this->LidarSlam.LoadMapsFromPCD(mapsPathPrefix);
+  }
+}
+
 //------------------------------------------------------------------------------
 void LidarSlamNode::SetSlamInitialState()
 {
   // Load initial SLAM maps if requested
   std::string mapsPathPrefix = this->PrivNh.param<std::string>("maps/initial_maps", "");
   if (!mapsPathPrefix.empty())
-  {
-    ROS_INFO_STREAM("Loading initial keypoints maps from PCD.");
-    this->LidarSlam.LoadMapsFromPCD(mapsPathPrefix);
-  }
+    this->LoadMaps(mapsPathPrefix);
 
   // Load initial Landmarks poses if requested
   std::string lmpath =
@@ -1214,3 +1682,23 @@ void LidarSlamNode::BroadcastGpsOffset()
   tfStamped.transform = Utils::IsometryToTfMsg(offset);
   this->StaticTfBroadcaster.sendTransform(tfStamped);
 }
+
+//------------------------------------------------------------------------------
+void LidarSlamNode::PublishGraphOptimizationResults()
+{
+  // Broadcast new calibration offset (GPS to base)
+  // if GPS used
+  if (this->LidarSlam.GpsHasData())
+    this->BroadcastGpsOffset();
+  // Publish new trajectory
+  if (this->Publish[PGO_PATH])
+  {
+    nav_msgs::Path optimSlamTraj;
+    optimSlamTraj.header.frame_id = this->OdometryFrameId;
+    std::list<LidarSlam::LidarState> optimizedSlamStates = this->LidarSlam.GetLogStates();
+    optimSlamTraj.header.stamp = ros::Time(optimizedSlamStates.back().Time);
+    for (const LidarSlam::LidarState& s: optimizedSlamStates)
+      optimSlamTraj.poses.emplace_back(Utils::IsometryToPoseStampedMsg(s.Isometry, s.Time, this->OdometryFrameId));
+    this->Publishers[PGO_PATH].publish(optimSlamTraj);
+  }
+}
@@ -29,14 +29,31 @@
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <lidar_slam/SlamCommand.h>
 #include <lidar_slam/Confidence.h>
+#include <lidar_slam/TimingStatistics.h>
+#include <lidar_slam/MapUpdate.h>
 #include <apriltag_ros/AprilTagDetection.h>
 #include <apriltag_ros/AprilTagDetectionArray.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/NavSatFix.h>
+#include <gps_common/GPSFix.h>
 
 // SLAM
 #include <LidarSlam/Slam.h>
 
+// LOCAL
+#include "UtmProjection.h"
+
+// STD
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// BOOST
+#include <boost/lockfree/spsc_queue.hpp>
+
 class LidarSlamNode
 {
 public:
@@ -56,7 +73,7 @@ public:
   /*!
    * @brief     Destructor.
    *
-   * Used to shut down external spinners
+   * Used to shut down external spinners and the output publication thread
    */
   ~LidarSlamNode();
 
@@ -65,6 +82,9 @@ public:
    * @brief     New main LiDAR frame callback, running SLAM and publishing TF.
    * @param[in] cloud New frame, published by conversion node.
    *
+   * In multi-LiDAR mode, the secondary frames acquired at the same time are
+   * added to this frame (see SynchronizeFrames).
+   *
    * Input pointcloud must have following fields :
    *  - x, y, z (float): point coordinates
    *  - time (double): time offset to add to the pointcloud header timestamp to
@@ -83,6 +103,8 @@ public:
    * @brief     New secondary lidar frame callback, buffered to be latered processed by SLAM.
    * @param[in] cloud New frame, published by conversion node.
    *
+   * Secondary frames are received by a dedicated spinner, in parallel of SLAM.
+   *
    * Input pointcloud must have following fields :
    *  - x, y, z (float): point coordinates
    *  - time (double): time offset to add to the pointcloud header timestamp to
@@ -103,6 +125,20 @@ public:
    */
   void GpsCallback(const nav_msgs::Odometry& msg);
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Optional raw GPS fix callback, projecting it to UTM and accumulating positions.
+   * @param[in] msg GPS fix in WGS84 format with its associated covariance.
+   */
+  void GpsFixCallback(const gps_common::GPSFix& msg);
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Optional raw GPS fix callback, projecting it to UTM and accumulating positions.
+   * @param[in] msg GPS fix in WGS84 format with its associated covariance.
+   */
+  void NavSatFixCallback(const sensor_msgs::NavSatFix& msg);
+
   //----------------------------------------------------------------------------
   /*!
    * @brief     Optional tag detection callback, adding a landmark relative pose to the SLAM
@@ -152,6 +188,53 @@ protected:
    */
   bool UpdateBaseToLidarOffset(const std::string& lidarFrameId, uint8_t lidarDeviceId);
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Gather the secondary frames to process with a main frame.
+   * @param[in] mainFrame The main LiDAR frame.
+   * @return    The main frame, followed by the secondary frames matched to it.
+   *
+   * For each secondary device, the buffered frame with the closest timestamp
+   * to the main frame one is used, if it lies within 'input_sync/window'.
+   * Older frames are dropped. If some devices have no matching frame yet, they
+   * are waited for at most 'input_sync/timeout'.
+   */
+  std::vector<CloudS::Ptr> SynchronizeFrames(const CloudS::Ptr& mainFrame);
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief Immutable copy of the SLAM outputs of one frame, built by the SLAM
+   *        thread and consumed by the output publication thread.
+   *
+   * Pointclouds are shared, not copied : the SLAM only replaces them by new
+   * clouds on next frames, and never modifies them in place.
+   */
+  struct OutputSnapshot
+  {
+    std::vector<LidarSlam::LidarState> States;              ///< Poses to publish, at the required frequency.
+    double ComputationTime = 0.;                            ///< [s] Processing duration of the frame.
+    double PredictionTime = 0.;                             ///< [s] Timestamp of the latency compensated pose.
+    Eigen::UnalignedIsometry3d PredictionIsometry;          ///< Latency compensated pose.
+    std::map<int, CloudS::Ptr> Clouds;                      ///< Pointclouds to publish, indexed by Output.
+    std::map<int, std::pair<uint64_t, LidarSlam::RollingGrid::Changes>> MapsChanges; ///< Incremental maps updates (sequence number and changes), indexed by Output.
+    float Overlap = 0.;                                     ///< Overlap estimation of current frame on maps.
+    int NbMatches = 0;                                      ///< Number of matched keypoints.
+    bool ComplyMotionLimits = true;                         ///< Is motion within the motion limits ?
+    std::map<std::string, LidarSlam::Profiling::Statistics> Timings; ///< Processing stages latencies.
+    std::map<std::string, LidarSlam::Profiling::Statistics> SyncTimings; ///< Multi-LiDAR synchronization latencies.
+  };
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief Gather SLAM outputs of the last processed frame as requested by user.
+   *
+   * Only the pointclouds that someone listens to are gathered. The keypoints
+   * maps are gathered at most at 'output/maps/frequency', as extracting them
+   * is expensive. If 'output/maps/incremental' is enabled, only the outer
+   * voxels of the maps modified since last publication are gathered.
+   */
+  std::shared_ptr<const OutputSnapshot> BuildOutputSnapshot();
+
   //----------------------------------------------------------------------------
   /*!
    * @brief Publish SLAM outputs as requested by user.
@@ -162,7 +245,14 @@ protected:
    *  - keypoints maps
    *  - undistorted input points registered in odometry frame
    */
-  void PublishOutput();
+  void PublishOutput(const OutputSnapshot& snapshot);
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief Loop of the output publication thread, publishing the snapshots
+   *        pushed by the SLAM thread until the node is destroyed.
+   */
+  void PublishOutputLoop();
 
   //----------------------------------------------------------------------------
   /*!
@@ -170,6 +260,14 @@ protected:
    */
   void SetSlamParameters();
 
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief Load keypoints maps from PCD files, or from native map files if
+   *        'maps/native_format' is enabled.
+   * @param mapsPathPrefix Path prefix of the maps files.
+   */
+  void LoadMaps(const std::string& mapsPathPrefix);
+
   //----------------------------------------------------------------------------
   /*!
    * @brief Fill the SLAM initial state with the given initial maps, pose and
@@ -196,16 +294,47 @@ protected:
    */
   int BuildId(const std::vector<int>& ids);
 
+  // Project a WGS84 GPS fix to UTM and add it to SLAM GPS measurements
+  void AddGpsFix(const std_msgs::Header& header, double latitude, double longitude, double altitude,
+                 const boost::array<double, 9>& covariance);
+
   // Publish static tf to link world (UTM) frame to SLAM origin
   // PGO must have been run, so we can average
   // the correspondant poses (GPS/LidarSLAM) distances to get the offset
   void BroadcastGpsOffset();
 
+  // Publish the pose graph optimization results :
+  // GPS offset (if GPS is used) and optimized trajectory (if required)
+  void PublishGraphOptimizationResults();
+
   //----------------------------------------------------------------------------
 
   // SLAM stuff
   LidarSlam::Slam LidarSlam;
-  std::vector<CloudS::Ptr> Frames;
+
+  // Multi-LiDAR synchronization
+  struct SecondaryFrame
+  {
+    CloudS::Ptr Cloud;                          ///< Received frame.
+    double Time = 0.;                           ///< [s] Frame timestamp.
+    std::chrono::steady_clock::time_point ReceptionTime;  ///< Reception time, to measure the synchronization latency.
+    Eigen::UnalignedIsometry3d BaseToLidar;     ///< Pose of the LiDAR in BASE coordinates.
+  };
+  struct SecondaryDevice
+  {
+    std::deque<SecondaryFrame> Frames;                 ///< Received frames not yet processed, sorted by time.
+    LidarSlam::Profiling::LatencyHistogram Latency;    ///< Durations between frame reception and processing.
+    LidarSlam::Profiling::LatencyHistogram TimeOffset; ///< Time offsets between used frames and main frames.
+  };
+  unsigned int NbSecondaryLidars = 0;
+  double SyncWindow = 0.05;                          ///< [s] Max time offset between a secondary frame and the main frame.
+  double SyncTimeout = 0.05;                         ///< [s] Max duration to wait for missing secondary frames.
+  std::map<uint8_t, SecondaryDevice> SecondaryDevices;  ///< Buffered frames of each secondary device, by device id.
+  LidarSlam::Profiling::LatencyHistogram SyncWaitTime;  ///< Durations waited for missing secondary frames.
+  std::mutex SyncMutex;                              ///< Protects SecondaryDevices.
+  std::condition_variable SecondaryFrameReceived;
+  ros::CallbackQueue SecondaryQueue;
+  std::shared_ptr<ros::AsyncSpinner> SecondarySpinnerPtr;
 
   // ROS node handles, subscribers and publishers
   ros::NodeHandle &Nh, &PrivNh;
@@ -217,6 +346,31 @@ protected:
   // Output pose required frequency (Hz)
   double TrajFrequency = -1;
 
+  // Keypoints maps publication frequency (Hz)
+  // If negative, maps are published at SLAM frequency.
+  double MapsFrequency = 1.;
+  double LastMapsTime = -1.;
+
+  // Incremental keypoints maps publication
+  // If enabled, only the outer voxels of the maps modified since last publication
+  // are sent. The full maps are sent periodically, on request or to new subscribers.
+  bool IncrementalMaps = false;
+  double FullMapsPeriod = 30.;                        ///< [s] If negative, full maps are only sent on request.
+  double LastFullMapsTime = -1.;
+  bool FullMapsRequested = false;
+  std::unordered_map<int, uint64_t> MapsSequence;     ///< Sequence number of the next update of each map.
+  std::unordered_map<int, uint32_t> MapsSubscribers;  ///< Number of subscribers of each map at last update.
+
+  // Output publication
+  // If enabled, outputs are serialized and published by a dedicated thread,
+  // fed by the SLAM thread through a lock-free queue of snapshots.
+  bool AsyncPublishing = true;
+  boost::lockfree::spsc_queue<std::shared_ptr<const OutputSnapshot>, boost::lockfree::capacity<32>> OutputQueue;
+  std::mutex OutputMutex;               ///< Only used to put the publication thread to sleep.
+  std::condition_variable OutputCondition;
+  bool StopPublishing = false;
+  std::thread OutputThread;
+
   // Start time (which corresponds to master Lidar scan reception)
   // It is stored to get the process time and be able to compensate the motion if required
   double StartTime = 0.;
@@ -251,6 +405,12 @@ protected:
   // Offset to apply to external sensors to get lidar time
   float SensorTimeOffset = 0.;
 
+  // Pose graph optimization
+  // If true, the graph is optimized in background while frames are processed,
+  // and the results are published once applied to SLAM.
+  bool AsyncGraphOptimization = false;
+  bool GraphOptimizationPending = false;
+
   // Landmarks
   ros::Subscriber LandmarksSub;
   bool PublishTags = false;
@@ -258,7 +418,9 @@ protected:
   // GPS
   Eigen::Isometry3d BaseToGpsOffset = Eigen::Isometry3d::Identity();  ///< Pose of the GPS antenna in BASE coordinates.
   ros::Subscriber GpsOdomSub;
+  ros::Subscriber GpsFixSub;
   LidarSlam::ExternalSensors::GpsMeasurement LastGpsMeas;
+  Utils::UtmProjector UtmProjection;  ///< WGS84 to UTM projection of raw GPS fixes, zone fixed on 1st fix.
 
   // Camera
   ros::Subscriber CameraSub;
@@ -0,0 +1,51 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlamNode.h"
+#include "AggregationNode.h"
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace lidar_slam
+{
+
+/**
+ * @class NodeletWrapper runs a ROS node inside a nodelet manager.
+ */
+template<typename Node>
+class NodeletWrapper : public nodelet::Nodelet
+{
+private:
+  void onInit() override
+  {
+    // The node stores references to the node handles, which are owned by the nodelet.
+    this->RosNode.reset(new Node(this->getNodeHandle(), this->getPrivateNodeHandle()));
+  }
+
+  std::unique_ptr<Node> RosNode;
+};
+
+using LidarSlamNodelet = NodeletWrapper<LidarSlamNode>;
+using AggregationNodelet = NodeletWrapper<AggregationNode>;
+
+}  // end of namespace lidar_slam
+
+PLUGINLIB_EXPORT_CLASS(lidar_slam::LidarSlamNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(lidar_slam::AggregationNodelet, nodelet::Nodelet)
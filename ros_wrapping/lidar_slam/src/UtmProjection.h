@@ -0,0 +1,148 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#ifndef UTM_PROJECTION_H
+#define UTM_PROJECTION_H
+
+#include <Eigen/Core>
+#include <cmath>
+
+namespace Utils
+{
+
+namespace Utm
+{
+  // WGS84 ellipsoid and UTM grid constants
+  constexpr double A   = 6378137.;                  ///< Semi-major axis [m]
+  constexpr double F   = 1. / 298.257223563;        ///< Flattening
+  constexpr double E2  = F * (2. - F);              ///< First eccentricity squared
+  constexpr double EP2 = E2 / (1. - E2);            ///< Second eccentricity squared
+  constexpr double K0  = 0.9996;                    ///< Scale factor on central meridian
+  constexpr double FalseEasting = 500000.;          ///< [m]
+  constexpr double FalseNorthingSouth = 10000000.;  ///< [m] Only applied in southern hemisphere
+
+  // Meridian arc series coefficients
+  constexpr double M1 = 1. - E2 / 4. - 3. * E2 * E2 / 64. - 5. * E2 * E2 * E2 / 256.;
+  constexpr double M2 = 3. * E2 / 8. + 3. * E2 * E2 / 32. + 45. * E2 * E2 * E2 / 1024.;
+  constexpr double M3 = 15. * E2 * E2 / 256. + 45. * E2 * E2 * E2 / 1024.;
+  constexpr double M4 = 35. * E2 * E2 * E2 / 3072.;
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Projection of WGS84 coordinates to UTM, with the zone fixed once.
+ *
+ * The zone is chosen by the first projected fix (or imposed with SetZone), and
+ * its parameters are cached: all positions are then expressed in the same
+ * cartesian frame, even when the trajectory crosses a zone boundary.
+ * The projection uses the USGS series expansion (Snyder, 1987), as geodesy does.
+ */
+class UtmProjector
+{
+public:
+
+  //! Impose UTM zone (1-60) and hemisphere. Zone 0 lets the next fix choose it.
+  void SetZone(int zone, bool north = true)
+  {
+    this->Zone = (zone >= 1 && zone <= 60) ? zone : 0;
+    this->North = north;
+    this->CentralMeridian = ((this->Zone - 1) * 6 - 180 + 3) * M_PI / 180.;
+  }
+
+  int GetZone() const { return this->Zone; }
+  char GetBand() const { return this->Band; }
+  bool IsZoneSet() const { return this->Zone > 0; }
+
+  //! Compute the standard UTM zone of a position, with Norway and Svalbard exceptions.
+  static int ComputeZone(double latitude, double longitude)
+  {
+    int zone = std::min(int((longitude + 180.) / 6.) + 1, 60);
+    if (latitude >= 56. && latitude < 64. && longitude >= 3. && longitude < 12.)
+      return 32;
+    if (latitude >= 72. && latitude < 84. && longitude >= 0. && longitude < 42.)
+    {
+      if (longitude < 9.)  return 31;
+      if (longitude < 21.) return 33;
+      if (longitude < 33.) return 35;
+      return 37;
+    }
+    return zone;
+  }
+
+  //! Compute the MGRS latitude band letter of a position.
+  static char ComputeBand(double latitude)
+  {
+    return "CDEFGHJKLMNPQRSTUVWXX"[int((latitude + 80.) / 8.)];
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+   * @brief     Project a WGS84 position to UTM coordinates in the cached zone.
+   * @param[in] latitude  Latitude, in degrees.
+   * @param[in] longitude Longitude, in degrees.
+   * @param[in] altitude  Altitude, in meters.
+   * @param[out] utm      (easting, northing, altitude) in meters.
+   * @return    False if the position is invalid or out of the UTM domain.
+   *
+   * If no zone is set yet, the zone and hemisphere of this position are used.
+   */
+  bool Project(double latitude, double longitude, double altitude, Eigen::Vector3d& utm)
+  {
+    if (!std::isfinite(latitude) || !std::isfinite(longitude) || !std::isfinite(altitude) ||
+        latitude < -80. || latitude > 84. || longitude < -180. || longitude > 180.)
+      return false;
+
+    if (!this->Band)
+      this->Band = ComputeBand(latitude);
+    if (!this->IsZoneSet())
+      this->SetZone(ComputeZone(latitude, longitude), latitude >= 0.);
+
+    // Longitude difference to central meridian, wrapped to [-pi, pi]
+    double phi = latitude * M_PI / 180.;
+    double lambda = std::remainder(longitude * M_PI / 180. - this->CentralMeridian, 2. * M_PI);
+
+    double sinPhi = std::sin(phi);
+    double cosPhi = std::cos(phi);
+    double tanPhi = std::tan(phi);
+    double n = Utm::A / std::sqrt(1. - Utm::E2 * sinPhi * sinPhi);
+    double t = tanPhi * tanPhi;
+    double c = Utm::EP2 * cosPhi * cosPhi;
+    double a = cosPhi * lambda;
+    double a2 = a * a;
+    double m = Utm::A * (Utm::M1 * phi - Utm::M2 * std::sin(2. * phi)
+                         + Utm::M3 * std::sin(4. * phi) - Utm::M4 * std::sin(6. * phi));
+
+    utm.x() = Utm::K0 * n * a * (1. + a2 / 6. * ((1. - t + c)
+                                 + a2 / 20. * (5. - 18. * t + t * t + 72. * c - 58. * Utm::EP2)))
+              + Utm::FalseEasting;
+    utm.y() = Utm::K0 * (m + n * tanPhi * a2 * (0.5 + a2 / 24. * ((5. - t + 9. * c + 4. * c * c)
+                                                + a2 / 30. * (61. - 58. * t + t * t + 600. * c - 330. * Utm::EP2))))
+              + (this->North ? 0. : Utm::FalseNorthingSouth);
+    utm.z() = altitude;
+    return true;
+  }
+
+private:
+  int Zone = 0;                 ///< UTM longitude zone number, 0 if not set yet.
+  char Band = 0;                ///< MGRS latitude band letter of the first fix.
+  bool North = true;            ///< Hemisphere, selecting the false northing.
+  double CentralMeridian = 0.;  ///< [rad] Longitude of the zone central meridian.
+};
+
+} // end of Utils namespace
+
+#endif // UTM_PROJECTION_H
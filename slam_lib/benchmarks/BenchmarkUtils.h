@@ -0,0 +1,199 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Inputs shared by the microbenchmarks and the overlap estimation test.
+//
+// Synthetic frames simulate a spinning LiDAR in a street : two facades, the
+// ground and a row of poles on each side, so that all keypoint types can be
+// extracted. Frames are given in the sensor frame, with the usual 'time' and
+// 'laser_id' fields.
+//
+// A recorded frame can also be used : set the SLAM_BENCHMARK_FRAME environment
+// variable to the path of a PCD file of LidarPoint. The benchmarks using it are
+// only registered if this variable is set (scale argument 0).
+
+#pragma once
+
+#include "LidarSlam/LidarPoint.h"
+
+#include <pcl/io/pcd_io.h>
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace Benchmarks
+{
+using Point = LidarSlam::LidarPoint;
+using PointCloud = pcl::PointCloud<Point>;
+
+//------------------------------------------------------------------------------
+//! Distance along the ray (origin, unit direction) to the street scene, or infinity if nothing is hit
+inline float CastRay(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir, float& intensity)
+{
+  constexpr float StreetHalfWidth = 10.f, GroundHeight = -1.8f, PoleRadius = 0.15f, PoleSpacing = 8.f, PoleY = 7.f;
+  float range = std::numeric_limits<float>::infinity();
+  auto hit = [&](float t, float i) { if (t > 0.f && t < range) { range = t; intensity = i; } };
+
+  // Facades and ground
+  if (dir.y() > 0.f) hit(( StreetHalfWidth - origin.y()) / dir.y(), 40.f);
+  if (dir.y() < 0.f) hit((-StreetHalfWidth - origin.y()) / dir.y(), 40.f);
+  if (dir.z() < 0.f) hit((GroundHeight - origin.z()) / dir.z(), 10.f);
+
+  // Poles : vertical cylinders, checking the nearest ones along x on each side
+  float a = dir.x() * dir.x() + dir.y() * dir.y();
+  if (a > 1e-9f)
+  {
+    for (float poleY : {-PoleY, PoleY})
+    {
+      float tSide = (poleY - origin.y()) / (std::abs(dir.y()) > 1e-6f ? dir.y() : 1e-6f);
+      if (tSide <= 0.f)
+        continue;
+      float xSide = origin.x() + tSide * dir.x();
+      for (float k : {-1.f, 0.f, 1.f})
+      {
+        float poleX = (std::round(xSide / PoleSpacing) + k) * PoleSpacing;
+        float ox = origin.x() - poleX, oy = origin.y() - poleY;
+        float b = ox * dir.x() + oy * dir.y();
+        float c = ox * ox + oy * oy - PoleRadius * PoleRadius;
+        float delta = b * b - a * c;
+        if (delta >= 0.f)
+          hit((-b - std::sqrt(delta)) / a, 200.f);
+      }
+    }
+  }
+  return range;
+}
+
+//------------------------------------------------------------------------------
+//! Simulate a spinning LiDAR frame acquired at the given position (sensor frame coordinates)
+inline PointCloud::Ptr CreateSpinningFrame(int nbRings, int nbPointsPerRing,
+                                           const Eigen::Vector3f& position = Eigen::Vector3f::Zero(),
+                                           unsigned int seed = 42)
+{
+  constexpr float MaxRange = 120.f, MinElevation = -25.f, MaxElevation = 15.f, Period = 0.1f;
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> noise(0.f, 0.01f);
+
+  PointCloud::Ptr cloud(new PointCloud);
+  cloud->reserve(nbRings * nbPointsPerRing);
+  for (int a = 0; a < nbPointsPerRing; ++a)
+  {
+    float azimuth = 2.f * M_PI * a / nbPointsPerRing;
+    for (int r = 0; r < nbRings; ++r)
+    {
+      float elevation = (MinElevation + (MaxElevation - MinElevation) * r / std::max(1, nbRings - 1)) * M_PI / 180.f;
+      Eigen::Vector3f dir(std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth), std::sin(elevation));
+      float intensity = 0.f;
+      float range = CastRay(position, dir, intensity);
+      if (range > MaxRange)
+        continue;
+      Point p;
+      p.getVector3fMap() = (range + noise(gen)) * dir;
+      p.intensity = intensity;
+      p.laser_id = r;
+      p.time = Period * a / nbPointsPerRing;
+      cloud->push_back(p);
+    }
+  }
+  return cloud;
+}
+
+//------------------------------------------------------------------------------
+//! Random points uniformly spread in a cube of the given size
+inline PointCloud::Ptr CreateRandomCloud(int nbPoints, float size, unsigned int seed = 42)
+{
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> coord(-size / 2.f, size / 2.f);
+  PointCloud::Ptr cloud(new PointCloud);
+  cloud->resize(nbPoints);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    Point& p = cloud->points[i];
+    p.x = coord(gen); p.y = coord(gen); p.z = coord(gen);
+    p.time = 1e-1 * i / nbPoints;
+    p.intensity = i % 255;
+    p.laser_id = i % 64;
+  }
+  return cloud;
+}
+
+//------------------------------------------------------------------------------
+//! Recorded frame given by SLAM_BENCHMARK_FRAME, or nullptr if it is not set
+inline PointCloud::Ptr LoadRecordedFrame()
+{
+  static PointCloud::Ptr recorded = []() -> PointCloud::Ptr
+  {
+    const char* path = std::getenv("SLAM_BENCHMARK_FRAME");
+    if (!path)
+      return nullptr;
+    PointCloud::Ptr cloud(new PointCloud);
+    if (pcl::io::loadPCDFile(path, *cloud) || cloud->empty())
+    {
+      std::cerr << "[ERROR] Unable to read recorded frame " << path << std::endl;
+      return nullptr;
+    }
+    return cloud;
+  }();
+  return recorded;
+}
+
+//------------------------------------------------------------------------------
+//! Frame scales used by the benchmarks : number of rings of the simulated
+//! sensor (with 1800 points per ring), or 0 for the recorded frame.
+constexpr int RecordedFrame = 0;
+constexpr int NbPointsPerRing = 1800;
+
+//! Get the input frame of a scale argument, acquired at the given position.
+//! The recorded frame is only translated, as if it was acquired by a moved sensor.
+inline PointCloud::Ptr GetFrame(int scale, const Eigen::Vector3f& position = Eigen::Vector3f::Zero())
+{
+  if (scale != RecordedFrame)
+    return CreateSpinningFrame(scale, NbPointsPerRing, position);
+  PointCloud::Ptr recorded = LoadRecordedFrame();
+  if (!recorded || position.isZero())
+    return recorded;
+  PointCloud::Ptr moved(new PointCloud(*recorded));
+  for (auto& p : *moved)
+    p.getVector3fMap() -= position;
+  return moved;
+}
+
+//! Get the input frame of a scale argument, acquired at the given position, in world coordinates
+inline PointCloud::Ptr GetWorldFrame(int scale, const Eigen::Vector3f& position = Eigen::Vector3f::Zero())
+{
+  PointCloud::Ptr world(new PointCloud(*GetFrame(scale, position)));
+  for (auto& p : *world)
+    p.getVector3fMap() += position;
+  return world;
+}
+
+//! Get the frame scales arguments, the recorded frame only being used if available
+inline std::vector<int> FrameScales(std::initializer_list<int> nbRings = {16, 32, 64, 128})
+{
+  std::vector<int> scales(nbRings);
+  if (LoadRecordedFrame())
+    scales.push_back(RecordedFrame);
+  return scales;
+}
+
+} // end of Benchmarks namespace
@@ -0,0 +1,93 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmarks of the trajectory interpolation models, used to undistort frames
+// and to synchronize external sensors : model build and pose evaluation.
+
+#include "LidarSlam/InterpolationModels.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using namespace LidarSlam;
+
+//------------------------------------------------------------------------------
+// Control poses of a sensor moving along a curve at 10 Hz
+std::vector<PoseStamped> CreateControlPoses(Interpolation::Model model)
+{
+  std::vector<PoseStamped> poses;
+  unsigned int nbPoses = Interpolation::ModelRequiredNbData.at(model);
+  for (unsigned int i = 0; i < nbPoses; ++i)
+  {
+    double t = 0.1 * i;
+    Eigen::UnalignedIsometry3d pose = Eigen::UnalignedIsometry3d::Identity();
+    pose.linear() = Eigen::AngleAxisd(0.2 * t, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    pose.translation() << 10. * t, std::sin(t), 0.05 * t;
+    poses.emplace_back(pose, t);
+  }
+  return poses;
+}
+
+//------------------------------------------------------------------------------
+// Arguments : interpolation model
+void BM_TrajectoryBuild(benchmark::State& state)
+{
+  auto model = static_cast<Interpolation::Model>(state.range(0));
+  std::vector<PoseStamped> poses = CreateControlPoses(model);
+  Interpolation::Trajectory trajectory(model);
+  for (auto _ : state)
+    trajectory.BuildModel(poses);
+  state.SetLabel(Interpolation::ModelNames.at(model));
+}
+
+//------------------------------------------------------------------------------
+// Arguments : interpolation model, number of evaluated times
+// Each iteration evaluates the poses at regularly spaced times, as done to
+// undistort the points of a frame.
+void BM_TrajectoryEvaluation(benchmark::State& state)
+{
+  auto model = static_cast<Interpolation::Model>(state.range(0));
+  std::vector<PoseStamped> poses = CreateControlPoses(model);
+  Interpolation::Trajectory trajectory(model, poses);
+  const int nbTimes = state.range(1);
+  const double t0 = poses.front().Time, dt = (poses.back().Time - t0) / nbTimes;
+  for (auto _ : state)
+    for (int i = 0; i < nbTimes; ++i)
+      benchmark::DoNotOptimize(trajectory(t0 + i * dt));
+  state.SetItemsProcessed(state.iterations() * nbTimes);
+  state.SetLabel(Interpolation::ModelNames.at(model));
+}
+
+void ModelArguments(benchmark::internal::Benchmark* b)
+{
+  for (const auto& model : Interpolation::ModelNames)
+    b->Arg(model.first);
+  b->ArgName("model");
+}
+
+void EvaluationArguments(benchmark::internal::Benchmark* b)
+{
+  for (const auto& model : Interpolation::ModelNames)
+    for (int nbTimes : {1000, 100000})
+      b->Args({model.first, nbTimes});
+  b->ArgNames({"model", "times"});
+}
+
+BENCHMARK(BM_TrajectoryBuild)->Apply(ModelArguments)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TrajectoryEvaluation)->Apply(EvaluationArguments)->Unit(benchmark::kMillisecond);
+} // end of anonymous namespace
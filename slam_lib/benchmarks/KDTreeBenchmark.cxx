@@ -0,0 +1,103 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmarks of the nanoflann KD-tree adaptor : build and k-nearest neighbors
+// search, on LiDAR frames and on uniformly spread points.
+
+#include "BenchmarkUtils.h"
+
+#include "LidarSlam/KDTreePCLAdaptor.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using namespace LidarSlam;
+using namespace Benchmarks;
+using KDTree = KDTreePCLAdaptor<Point>;
+
+//------------------------------------------------------------------------------
+// Input argument : frame scale, or number of random points if it is negative
+PointCloud::Ptr GetCloud(int input)
+{
+  return input >= 0 ? GetFrame(input) : CreateRandomCloud(-input, 50.f);
+}
+
+std::vector<int> CloudInputs()
+{
+  std::vector<int> inputs = FrameScales();
+  for (int nbPoints : {10000, 100000, 1000000})
+    inputs.push_back(-nbPoints);
+  return inputs;
+}
+
+//------------------------------------------------------------------------------
+// Arguments : input (see GetCloud)
+void BM_KDTreeBuild(benchmark::State& state)
+{
+  auto cloud = GetCloud(state.range(0));
+  KDTree kdTree;
+  for (auto _ : state)
+    kdTree.Reset(cloud);
+  state.SetItemsProcessed(state.iterations() * cloud->size());
+  state.counters["points"] = cloud->size();
+}
+
+void BuildArguments(benchmark::internal::Benchmark* b)
+{
+  for (int input : CloudInputs())
+    b->Arg(input);
+  b->ArgName("input");
+}
+
+BENCHMARK(BM_KDTreeBuild)->Apply(BuildArguments)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------------------
+// Arguments : input (see GetCloud), number of neighbors
+// The queries are the cloud points, slightly moved.
+void BM_KDTreeKnnSearch(benchmark::State& state)
+{
+  auto cloud = GetCloud(state.range(0));
+  KDTree kdTree(cloud);
+  const int k = state.range(1);
+  const int nbQueries = std::min<int>(cloud->size(), 10000);
+  const int step = cloud->size() / nbQueries;
+  std::vector<int> indices(k);
+  std::vector<float> sqDistances(k);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < nbQueries; ++i)
+    {
+      const Point& p = cloud->points[i * step];
+      const float query[3] = {p.x + 0.05f, p.y - 0.05f, p.z + 0.02f};
+      benchmark::DoNotOptimize(kdTree.KnnSearch(query, k, indices.data(), sqDistances.data()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nbQueries);
+  state.counters["points"] = cloud->size();
+}
+
+void KnnArguments(benchmark::internal::Benchmark* b)
+{
+  for (int input : CloudInputs())
+    for (int k : {1, 5, 10})
+      b->Args({input, k});
+  b->ArgNames({"input", "k"});
+}
+
+BENCHMARK(BM_KDTreeKnnSearch)->Apply(KnnArguments)->Unit(benchmark::kMicrosecond);
+} // end of anonymous namespace
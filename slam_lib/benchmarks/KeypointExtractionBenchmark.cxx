@@ -0,0 +1,63 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmark of the keypoints extraction from a spinning LiDAR frame.
+
+#include "BenchmarkUtils.h"
+
+#include "LidarSlam/SpinningSensorKeypointExtractor.h"
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+namespace
+{
+using namespace LidarSlam;
+using namespace Benchmarks;
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, number of threads
+void BM_KeypointsExtraction(benchmark::State& state)
+{
+  PointCloud::Ptr frame = GetFrame(state.range(0));
+  SpinningSensorKeypointExtractor extractor;
+  extractor.SetNbThreads(state.range(1));
+  // Keypoints types used by default by the SLAM
+  extractor.Enable({EDGE, INTENSITY_EDGE, PLANE});
+  for (auto _ : state)
+    extractor.ComputeKeyPoints(frame);
+  state.SetItemsProcessed(state.iterations() * frame->size());
+  state.counters["points"] = frame->size();
+  for (auto k : {EDGE, INTENSITY_EDGE, PLANE})
+    state.counters[KeypointTypeNames.at(k)] = extractor.GetKeypoints(k)->size();
+}
+
+void ExtractionArguments(benchmark::internal::Benchmark* b)
+{
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (int scale : FrameScales())
+  {
+    b->Args({scale, 1});
+    if (maxThreads > 1)
+      b->Args({scale, maxThreads});
+  }
+  b->ArgNames({"rings", "threads"});
+}
+
+BENCHMARK(BM_KeypointsExtraction)->Apply(ExtractionArguments)->Unit(benchmark::kMillisecond)->UseRealTime();
+} // end of anonymous namespace
@@ -0,0 +1,113 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmark of the maps rebuild from logged keyframes, as done after a pose
+// graph optimization : Slam::UpdateMaps(true) clears the local maps and calls
+// Slam::BuildMaps, which decompresses and transforms the keyframes keypoints
+// concurrently, then adds them to the rolling grids with outer voxels split
+// between threads.
+//
+// The logged keyframes are obtained by running the SLAM on simulated frames of
+// a sensor moving along a street, the maps being large enough to hold the
+// whole trajectory.
+
+#include "LidarSlam/Slam.h"
+#include "BenchmarkUtils.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace
+{
+using namespace LidarSlam;
+
+constexpr float KeyFramesSpacing = 1.f;  ///< [m] Distance between two frames
+constexpr int NbRings = 16;
+constexpr int NbPointsPerRing = 450;
+constexpr double VoxelResolution = 10.;   ///< [m] Outer voxel width of the maps
+constexpr float MaxRange = 120.f;         ///< [m] Max range of the simulated frames
+
+//------------------------------------------------------------------------------
+// SLAM whose logged states hold the given number of keyframes.
+// The SLAM are cached to be shared by the runs with different thread counts.
+Slam& GetSlam(int nbKeyFrames, PointCloudStorageType storage)
+{
+  static std::map<std::pair<int, int>, std::unique_ptr<Slam>> slams;
+  std::unique_ptr<Slam>& slam = slams[{nbKeyFrames, storage}];
+  if (slam)
+    return *slam;
+
+  slam.reset(new Slam);
+  slam->SetVerbosity(0);
+  slam->SetNbThreads(std::max(1u, std::thread::hardware_concurrency()));
+  slam->SetLoggingTimeout(1e6);
+  slam->SetLoggingStorage(storage);
+  slam->SetLogOnlyKeyframes(true);
+  slam->SetKfDistanceThreshold(0.5 * KeyFramesSpacing);
+  // The maps cover the whole trajectory, so that no keyframe is dropped
+  slam->SetVoxelGridResolution(VoxelResolution);
+  slam->SetVoxelGridSize(int(std::ceil((nbKeyFrames * KeyFramesSpacing + 2. * MaxRange) / VoxelResolution)) + 2);
+
+  for (int i = 0; slam->GetLogStates().size() < static_cast<unsigned int>(nbKeyFrames) && i < 2 * nbKeyFrames; ++i)
+  {
+    Eigen::Vector3f position(i * KeyFramesSpacing, 0.f, 0.f);
+    Benchmarks::PointCloud::Ptr frame = Benchmarks::CreateSpinningFrame(NbRings, NbPointsPerRing, position, i);
+    frame->header.stamp = Utils::SecToPclStamp(0.1 * i);
+    frame->header.frame_id = "lidar";
+    slam->AddFrames({frame});
+  }
+  return *slam;
+}
+
+//------------------------------------------------------------------------------
+// Arguments : number of keyframes, storage type, number of threads
+void BM_MapRebuild(benchmark::State& state)
+{
+  Slam& slam = GetSlam(state.range(0), static_cast<PointCloudStorageType>(state.range(1)));
+  slam.SetNbThreads(state.range(2));
+  for (auto _ : state)
+    slam.UpdateMaps(true);
+
+  unsigned int nbKeyFrames = slam.GetLogStates().size();
+  unsigned int nbMapPoints = 0;
+  for (auto k : KeypointTypes)
+    if (slam.KeypointTypeEnabled(k))
+      nbMapPoints += slam.GetMap(k)->size();
+  state.SetItemsProcessed(state.iterations() * nbKeyFrames);
+  state.counters["keyframes"] = nbKeyFrames;
+  state.counters["map_points"] = nbMapPoints;
+}
+
+void MapRebuildArguments(benchmark::internal::Benchmark* b)
+{
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (int storage : {PCL_CLOUD, LIDAR_COMPRESSED})
+    for (int nbKeyFrames : {50, 200, 800})
+    {
+      b->Args({nbKeyFrames, storage, 1});
+      if (maxThreads > 1)
+        b->Args({nbKeyFrames, storage, maxThreads});
+    }
+  b->ArgNames({"keyframes", "storage", "threads"});
+}
+
+BENCHMARK(BM_MapRebuild)->Apply(MapRebuildArguments)->Unit(benchmark::kMillisecond)->UseRealTime();
+} // end of anonymous namespace
@@ -0,0 +1,80 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Check of the overlap estimators against the exact LCP, on the registration
+// data of the microbenchmarks. It does not require Google Benchmark :
+//  - LCP must not differ from its exact computation by more than its early stop tolerance,
+//  - all estimators must agree with LCP that the misaligned registration has a lower overlap.
+// It returns a non-zero code if a check fails.
+
+#include "RegistrationData.h"
+
+#include <iostream>
+#include <thread>
+
+using namespace LidarSlam;
+using namespace Benchmarks;
+
+int main()
+{
+  constexpr float samplingRatio = 0.33;
+  constexpr float lcpTolerance = 0.01;
+  std::vector<int> threads = {1};
+  if (std::thread::hardware_concurrency() > 1)
+    threads.push_back(std::thread::hardware_concurrency());
+  const std::map<OverlapMode, std::string> modeNames = {{OverlapMode::LCP, "LCP"},
+                                                        {OverlapMode::MATCHING, "matching"},
+                                                        {OverlapMode::VOXEL_OCCUPANCY, "voxel occupancy"}};
+
+  int nbFailures = 0;
+  for (int scale : FrameScales({16, 32}))
+  {
+    const RegistrationData& data = GetRegistrationData(scale);
+    float reference = ExactLCP(data.WorldFrame, data.Maps, samplingRatio);
+    float misalignedReference = ExactLCP(data.MisalignedWorldFrame, data.Maps, samplingRatio);
+    std::cout << "Frame with " << scale << " rings : exact LCP " << reference
+              << " (misaligned : " << misalignedReference << ")" << std::endl;
+
+    for (const auto& modeName : modeNames)
+    {
+      OverlapMode mode = modeName.first;
+      for (int nbThreads : threads)
+      {
+        float overlap = EstimateOverlap(data, mode, false, samplingRatio, nbThreads);
+        float misalignedOverlap = EstimateOverlap(data, mode, true, samplingRatio, nbThreads);
+        std::cout << "  " << modeName.second << " with " << nbThreads << " threads : " << overlap
+                  << " (misaligned : " << misalignedOverlap << ")" << std::endl;
+
+        if (mode == OverlapMode::LCP &&
+            (std::abs(overlap - reference) > lcpTolerance || std::abs(misalignedOverlap - misalignedReference) > lcpTolerance))
+        {
+          std::cerr << "  ERROR : LCP estimation differs from its exact computation" << std::endl;
+          ++nbFailures;
+        }
+        if (misalignedReference < reference && misalignedOverlap >= overlap)
+        {
+          std::cerr << "  ERROR : " << modeName.second << " estimator does not detect the misaligned registration, contrary to LCP" << std::endl;
+          ++nbFailures;
+        }
+      }
+    }
+  }
+
+  if (nbFailures)
+    std::cerr << nbFailures << " overlap estimation checks failed" << std::endl;
+  return nbFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
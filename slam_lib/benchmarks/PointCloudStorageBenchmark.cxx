@@ -0,0 +1,94 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmarks of the logged pointclouds storage types : encoding (storing) and
+// decoding (getting the cloud back) durations, and stored size.
+// Notably, it compares the two in-memory compressions : the generic PCL octree
+// compression (OCTREE_COMPRESSED, which drops the LidarPoint specific fields)
+// and the dedicated LidarPoint codec (LIDAR_COMPRESSED, which keeps them).
+
+#include "BenchmarkUtils.h"
+
+#include "LidarSlam/PointCloudStorage.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using namespace LidarSlam;
+using namespace Benchmarks;
+
+const std::map<int, std::string> StorageNames = {
+  {PCL_CLOUD, "PCL_CLOUD"},
+  {OCTREE_COMPRESSED, "OCTREE_COMPRESSED"},
+  {PCD_ASCII, "PCD_ASCII"},
+  {PCD_BINARY, "PCD_BINARY"},
+  {PCD_BINARY_COMPRESSED, "PCD_BINARY_COMPRESSED"},
+  {LIDAR_COMPRESSED, "LIDAR_COMPRESSED"},
+  {MAPPED_FILE, "MAPPED_FILE"}
+};
+
+//------------------------------------------------------------------------------
+void SetStorageCounters(benchmark::State& state, const PointCloudStorage<Point>& storage, const PointCloud& cloud)
+{
+  state.SetLabel(StorageNames.at(state.range(1)));
+  state.counters["points"] = cloud.size();
+  state.counters["bytes_per_point"] = static_cast<double>(storage.MemorySize()) / cloud.size();
+  state.counters["compression_ratio"] = static_cast<double>(sizeof(Point) * cloud.size()) / storage.MemorySize();
+}
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, storage type
+void BM_StorageEncode(benchmark::State& state)
+{
+  PointCloud::ConstPtr cloud = GetFrame(state.range(0));
+  auto storageType = static_cast<PointCloudStorageType>(state.range(1));
+  for (auto _ : state)
+  {
+    std::unique_ptr<PointCloudStorage<Point>> storage(new PointCloudStorage<Point>(cloud, storageType));
+    // Exclude the storage release (e.g. file removal) from timing
+    state.PauseTiming();
+    storage.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * cloud->size());
+  SetStorageCounters(state, PointCloudStorage<Point>(cloud, storageType), *cloud);
+}
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, storage type
+void BM_StorageDecode(benchmark::State& state)
+{
+  PointCloud::ConstPtr cloud = GetFrame(state.range(0));
+  PointCloudStorage<Point> storage(cloud, static_cast<PointCloudStorageType>(state.range(1)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(storage.GetCloud()->size());
+  state.SetItemsProcessed(state.iterations() * cloud->size());
+  SetStorageCounters(state, storage, *cloud);
+}
+
+void StorageArguments(benchmark::internal::Benchmark* b)
+{
+  for (int scale : FrameScales({16, 64}))
+    for (const auto& storage : StorageNames)
+      b->Args({scale, storage.first});
+  b->ArgNames({"rings", "storage"});
+}
+
+BENCHMARK(BM_StorageEncode)->Apply(StorageArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StorageDecode)->Apply(StorageArguments)->Unit(benchmark::kMillisecond);
+} // end of anonymous namespace
@@ -0,0 +1,139 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmarks of the localization step kernels : keypoints matching on the
+// maps, Levenberg-Marquardt pose optimization with registration error
+// estimation, and the overlap estimators.
+
+#include "RegistrationData.h"
+
+#include "LidarSlam/LocalOptimizer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+namespace
+{
+using namespace LidarSlam;
+using namespace Benchmarks;
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, keypoint type, number of threads
+void BM_BuildMatchResiduals(benchmark::State& state)
+{
+  const RegistrationData& data = GetRegistrationData(state.range(0));
+  auto k = static_cast<Keypoint>(state.range(1));
+  KeypointsMatcher::Parameters params;
+  params.NbThreads = state.range(2);
+  KeypointsMatcher::MatchingResults results;
+  for (auto _ : state)
+  {
+    KeypointsMatcher matcher(params, data.PosePrior);
+    results = matcher.BuildMatchResiduals(data.Keypoints.at(k), data.Maps.at(k)->GetSubMapKdTree(), k);
+  }
+  state.SetItemsProcessed(state.iterations() * data.Keypoints.at(k)->size());
+  state.SetLabel(KeypointTypeNames.at(k));
+  state.counters["keypoints"] = data.Keypoints.at(k)->size();
+  state.counters["matches"] = results.NbMatches();
+}
+
+void MatchingArguments(benchmark::internal::Benchmark* b)
+{
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (int scale : FrameScales())
+    for (auto k : UsedKeypoints)
+    {
+      b->Args({scale, k, 1});
+      if (maxThreads > 1)
+        b->Args({scale, k, maxThreads});
+    }
+  b->ArgNames({"rings", "keypoint", "threads"});
+}
+
+BENCHMARK(BM_BuildMatchResiduals)->Apply(MatchingArguments)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale
+// One ICP iteration optimization : LM solving then registration error estimation
+void BM_LocalOptimization(benchmark::State& state)
+{
+  const RegistrationData& data = GetRegistrationData(state.range(0));
+  unsigned int nbResiduals = 0;
+  for (const auto& matches : data.Matches)
+    nbResiduals += matches.second.NbMatches();
+  Eigen::Isometry3d optimizedPose;
+  for (auto _ : state)
+  {
+    LocalOptimizer optimizer;
+    optimizer.SetPosePrior(data.PosePrior);
+    optimizer.SetLMMaxIter(15);
+    for (const auto& matches : data.Matches)
+      optimizer.AddResiduals(matches.second.Residuals);
+    optimizer.Solve();
+    optimizedPose = optimizer.GetOptimizedPose();
+    benchmark::DoNotOptimize(optimizer.EstimateRegistrationError());
+  }
+  state.counters["residuals"] = nbResiduals;
+  state.counters["error_cm"] = 100. * (data.Pose.translation() - optimizedPose.translation()).norm();
+}
+
+void FrameArguments(benchmark::internal::Benchmark* b)
+{
+  for (int scale : FrameScales())
+    b->Arg(scale);
+  b->ArgName("rings");
+}
+
+BENCHMARK(BM_LocalOptimization)->Apply(FrameArguments)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, overlap estimator (see OverlapMode), number of threads
+// Overlap estimation of the registered frame, with the default sampling ratio.
+// The estimators results are checked against the exact LCP by slam_overlap_test.
+void BM_OverlapEstimation(benchmark::State& state)
+{
+  const RegistrationData& data = GetRegistrationData(state.range(0));
+  auto mode = static_cast<OverlapMode>(state.range(1));
+  int nbThreads = state.range(2);
+  constexpr float samplingRatio = 0.33;
+
+  float overlap = 0.;
+  for (auto _ : state)
+  {
+    overlap = EstimateOverlap(data, mode, false, samplingRatio, nbThreads);
+    benchmark::DoNotOptimize(overlap);
+  }
+  state.counters["overlap"] = overlap;
+  state.counters["overlap_misaligned"] = EstimateOverlap(data, mode, true, samplingRatio, nbThreads);
+}
+
+void OverlapArguments(benchmark::internal::Benchmark* b)
+{
+  int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (int scale : FrameScales())
+    for (auto mode : {OverlapMode::LCP, OverlapMode::MATCHING, OverlapMode::VOXEL_OCCUPANCY})
+    {
+      b->Args({scale, static_cast<int>(mode), 1});
+      if (maxThreads > 1 && mode != OverlapMode::MATCHING)
+        b->Args({scale, static_cast<int>(mode), maxThreads});
+    }
+  b->ArgNames({"rings", "mode", "threads"});
+}
+
+BENCHMARK(BM_OverlapEstimation)->Apply(OverlapArguments)->Unit(benchmark::kMicrosecond);
+} // end of anonymous namespace
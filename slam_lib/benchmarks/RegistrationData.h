@@ -0,0 +1,156 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Registration inputs shared by the registration benchmarks and the overlap
+// estimation test : keypoints maps built from synthetic frames, and the current
+// frame registered on them with a good and with a wrong pose.
+
+#pragma once
+
+#include "BenchmarkUtils.h"
+
+#include "LidarSlam/ConfidenceEstimators.h"
+#include "LidarSlam/KeypointsMatcher.h"
+#include "LidarSlam/RollingGrid.h"
+#include "LidarSlam/SpinningSensorKeypointExtractor.h"
+
+#include <map>
+#include <memory>
+
+namespace Benchmarks
+{
+using namespace LidarSlam;
+
+const std::vector<Keypoint> UsedKeypoints = {EDGE, INTENSITY_EDGE, PLANE};
+
+//------------------------------------------------------------------------------
+// Current frame and keypoints maps, as given to the localization step
+struct RegistrationData
+{
+  std::map<Keypoint, PointCloud::Ptr> Keypoints;          ///< Current keypoints, in BASE coordinates
+  std::map<Keypoint, std::shared_ptr<RollingGrid>> Maps;  ///< Keypoints maps, with sub-map KD-trees built
+  PointCloud::Ptr WorldFrame;                             ///< Current frame, in WORLD coordinates
+  Eigen::Isometry3d Pose;                                 ///< Current pose
+  Eigen::Isometry3d PosePrior;                            ///< Current pose prior, slightly wrong
+  std::map<Keypoint, KeypointsMatcher::MatchingResults> Matches;  ///< Matches from the pose prior
+
+  // Same inputs for a wrong registration, to check that the overlap estimators detect it
+  Eigen::Isometry3d MisalignedPose;                                         ///< Pose far from the current one
+  PointCloud::Ptr MisalignedWorldFrame;                                     ///< Current frame, placed with the misaligned pose
+  std::map<Keypoint, KeypointsMatcher::MatchingResults> MisalignedMatches;  ///< Matches from the misaligned pose
+};
+
+//------------------------------------------------------------------------------
+// Get the registration data of a frame scale, built on first call
+inline const RegistrationData& GetRegistrationData(int scale)
+{
+  static std::map<int, std::unique_ptr<RegistrationData>> cache;
+  auto& data = cache[scale];
+  if (data)
+    return *data;
+  data.reset(new RegistrationData);
+
+  SpinningSensorKeypointExtractor extractor;
+  extractor.Enable(UsedKeypoints);
+  for (auto k : UsedKeypoints)
+  {
+    data->Maps[k] = std::make_shared<RollingGrid>();
+    data->Maps[k]->SetLeafSize(k == PLANE ? 0.6 : 0.3);
+  }
+
+  // Build the maps from the previous frames of a sensor moving along the street
+  constexpr int nbMapFrames = 5;
+  for (int i = 0; i < nbMapFrames; ++i)
+  {
+    Eigen::Vector3f position(i, 0.f, 0.f);
+    extractor.ComputeKeyPoints(GetFrame(scale, position));
+    for (auto k : UsedKeypoints)
+    {
+      PointCloud::Ptr worldKeypoints(new PointCloud(*extractor.GetKeypoints(k)));
+      for (auto& p : *worldKeypoints)
+        p.getVector3fMap() += position;
+      data->Maps[k]->Add(worldKeypoints);
+    }
+  }
+  for (auto k : UsedKeypoints)
+    data->Maps[k]->BuildSubMapKdTree();
+
+  // Current frame, with a pose prior extrapolated with a small error
+  Eigen::Vector3f position(nbMapFrames + 0.5f, 0.f, 0.f);
+  data->Pose = Eigen::Translation3d(position.cast<double>()) * Eigen::Isometry3d::Identity();
+  data->PosePrior = data->Pose * Eigen::Translation3d(0.05, -0.03, 0.02) * Eigen::AngleAxisd(0.02, Eigen::Vector3d::UnitZ());
+  data->WorldFrame = GetWorldFrame(scale, position);
+  extractor.ComputeKeyPoints(GetFrame(scale, position));
+  KeypointsMatcher matcher(KeypointsMatcher::Parameters(), data->PosePrior);
+  for (auto k : UsedKeypoints)
+  {
+    data->Keypoints[k].reset(new PointCloud(*extractor.GetKeypoints(k)));
+    data->Matches[k] = matcher.BuildMatchResiduals(data->Keypoints[k], data->Maps[k]->GetSubMapKdTree(), k);
+  }
+
+  // Wrong registration of the current frame
+  data->MisalignedPose = data->Pose * Eigen::Translation3d(0.4, 0.6, 0.3) * Eigen::AngleAxisd(0.1, Eigen::Vector3d::UnitZ());
+  data->MisalignedWorldFrame.reset(new PointCloud(*GetFrame(scale, position)));
+  const Eigen::Isometry3f misalignedPose = data->MisalignedPose.cast<float>();
+  for (auto& p : *data->MisalignedWorldFrame)
+    p.getVector3fMap() = misalignedPose * p.getVector3fMap();
+  KeypointsMatcher misalignedMatcher(KeypointsMatcher::Parameters(), data->MisalignedPose);
+  for (auto k : UsedKeypoints)
+    data->MisalignedMatches[k] = misalignedMatcher.BuildMatchResiduals(data->Keypoints[k], data->Maps[k]->GetSubMapKdTree(), k);
+  return *data;
+}
+
+//------------------------------------------------------------------------------
+// Reference LCP estimation, searching the nearest neighbor of each point in all maps
+inline float ExactLCP(PointCloud::ConstPtr cloud, const std::map<Keypoint, std::shared_ptr<RollingGrid>>& maps, float subsamplingRatio)
+{
+  int nbPoints = cloud->size() * subsamplingRatio;
+  float lcp = 0.;
+  for (int n = 0; n < nbPoints; ++n)
+  {
+    const auto& point = cloud->at(n / subsamplingRatio);
+    float bestProba = 0.;
+    for (const auto& map : maps)
+    {
+      int nnIndex;
+      float nnSqDist;
+      float sqLCPThreshold = std::pow(map.second->GetLeafSize() / 3.f, 2);
+      if (map.second->GetSubMapKdTree().KnnSearch(point.data, 1, &nnIndex, &nnSqDist))
+        bestProba = std::max(bestProba, std::exp(-nnSqDist / (2.f * sqLCPThreshold)));
+    }
+    lcp += bestProba;
+  }
+  return lcp / nbPoints;
+}
+
+//------------------------------------------------------------------------------
+// Overlap of a registration, estimated with the given estimator
+inline float EstimateOverlap(const RegistrationData& data, OverlapMode mode, bool misaligned, float samplingRatio, int nbThreads)
+{
+  switch (mode)
+  {
+    case OverlapMode::LCP:
+      return Confidence::LCPEstimator(misaligned ? data.MisalignedWorldFrame : data.WorldFrame, data.Maps, samplingRatio, nbThreads);
+    case OverlapMode::MATCHING:
+      return Confidence::MatchingEstimator(misaligned ? data.MisalignedMatches : data.Matches);
+    case OverlapMode::VOXEL_OCCUPANCY:
+      return Confidence::VoxelOccupancyEstimator(data.Keypoints, misaligned ? data.MisalignedPose : data.Pose, data.Maps, samplingRatio, nbThreads);
+  }
+  return -1.;
+}
+
+} // end of Benchmarks namespace
@@ -0,0 +1,126 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Benchmarks of the rolling grid map operations : adding a frame to a filled
+// map, rolling the grid and building the sub-map KD-tree used for matching.
+
+#include "BenchmarkUtils.h"
+
+#include "LidarSlam/RollingGrid.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using namespace LidarSlam;
+using namespace Benchmarks;
+
+constexpr int NbMapFrames = 10;
+constexpr float MapFramesSpacing = 1.f;
+
+//------------------------------------------------------------------------------
+// Map filled with successive frames of a sensor moving along the street
+std::unique_ptr<RollingGrid> CreateMap(int scale, double leafSize)
+{
+  std::unique_ptr<RollingGrid> map(new RollingGrid);
+  map->SetGridSize(50);
+  map->SetVoxelResolution(10.);
+  map->SetLeafSize(leafSize);
+  for (int i = 0; i < NbMapFrames; ++i)
+    map->Add(GetWorldFrame(scale, {i * MapFramesSpacing, 0.f, 0.f}));
+  return map;
+}
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, leaf size [cm]
+void BM_RollingGridAdd(benchmark::State& state)
+{
+  auto map = CreateMap(state.range(0), state.range(1) * 1e-2);
+  auto frame = GetWorldFrame(state.range(0), {NbMapFrames * MapFramesSpacing, 0.f, 0.f});
+  for (auto _ : state)
+    map->Add(frame);
+  state.SetItemsProcessed(state.iterations() * frame->size());
+  state.counters["points"] = frame->size();
+  state.counters["map_points"] = map->Size();
+}
+
+void AddArguments(benchmark::internal::Benchmark* b)
+{
+  for (int scale : FrameScales())
+    for (int leafSize : {10, 30})
+      b->Args({scale, leafSize});
+  b->ArgNames({"rings", "leaf_cm"});
+}
+
+BENCHMARK(BM_RollingGridAdd)->Apply(AddArguments)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, rolling shift [outer voxels]
+// Each iteration rolls the grid forth and back.
+void BM_RollingGridRoll(benchmark::State& state)
+{
+  auto map = CreateMap(state.range(0), 0.3);
+  // Bounding box of the size of the grid, forcing the grid center
+  Eigen::Array3f halfGrid = Eigen::Array3f::Constant(map->GetGridSize() * map->GetVoxelResolution() / 2.);
+  Eigen::Array3f shift(state.range(1) * map->GetVoxelResolution(), 0.f, 0.f);
+  for (auto _ : state)
+  {
+    map->Roll(shift - halfGrid, shift + halfGrid);
+    map->Roll(-halfGrid, halfGrid);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  state.counters["map_points"] = map->Size();
+}
+
+void RollArguments(benchmark::internal::Benchmark* b)
+{
+  for (int scale : FrameScales({16, 64}))
+    for (int shift : {1, 5})
+      b->Args({scale, shift});
+  b->ArgNames({"rings", "shift"});
+}
+
+BENCHMARK(BM_RollingGridRoll)->Apply(RollArguments)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------------------
+// Arguments : frame scale, sub-map half size [m] (0 for the whole map)
+void BM_RollingGridBuildSubMapKdTree(benchmark::State& state)
+{
+  auto map = CreateMap(state.range(0), 0.3);
+  Eigen::Array3f halfSize = Eigen::Array3f::Constant(state.range(1));
+  for (auto _ : state)
+  {
+    if (state.range(1) > 0)
+      map->BuildSubMapKdTree(-halfSize, halfSize);
+    else
+      map->BuildSubMapKdTree();
+    benchmark::DoNotOptimize(map->GetSubMap()->size());
+  }
+  state.counters["submap_points"] = map->GetSubMap()->size();
+  state.counters["map_points"] = map->Size();
+}
+
+void SubMapArguments(benchmark::internal::Benchmark* b)
+{
+  for (int scale : FrameScales())
+    for (int halfSize : {20, 60, 0})
+      b->Args({scale, halfSize});
+  b->ArgNames({"rings", "half_size"});
+}
+
+BENCHMARK(BM_RollingGridBuildSubMapKdTree)->Apply(SubMapArguments)->Unit(benchmark::kMillisecond);
+} // end of anonymous namespace
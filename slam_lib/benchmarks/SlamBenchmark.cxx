@@ -0,0 +1,638 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+// Offline replay benchmark of the whole SLAM pipeline, without ROS.
+//
+// Frames are read from a directory of PCD files (one frame per file, sorted
+// by name) or from a binary frame log, and fed to Slam::AddFrames as fast as
+// possible. Optional external sensors measurements are read from CSV files.
+// At the end, the throughput, the per-stage latency percentiles, the peak
+// memory usage and, if a reference trajectory is given, the absolute and
+// relative pose errors are reported.
+//
+// Binary frame log layout (little endian) :
+//   char[8]  "SLAMLOG1"
+//   for each frame :
+//     double   timestamp [s]
+//     uint32   number of points
+//     for each point : float x, y, z ; double time ; float intensity ;
+//                      uint16 laser_id ; uint8 device_id ; uint8 label
+//
+// Trajectories (reference, external poses and output) use the TUM format :
+//   timestamp x y z qx qy qz qw
+
+#include "LidarSlam/Slam.h"
+#include "LidarSlam/InterpolationModels.h"
+#include "LidarSlam/Utilities.h"
+
+#include <pcl/io/pcd_io.h>
+#include <boost/filesystem.hpp>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+using namespace LidarSlam;
+using PointCloud = pcl::PointCloud<LidarPoint>;
+using Trajectory = std::vector<PoseStamped>;
+
+const char LOG_MAGIC[8] = {'S', 'L', 'A', 'M', 'L', 'O', 'G', '1'};
+
+//------------------------------------------------------------------------------
+// Command line options
+struct Options
+{
+  std::string Input;
+  int NbThreads = std::max(1u, std::thread::hardware_concurrency());
+  int Verbosity = 0;
+  int EgoMotion = -1;
+  int Undistortion = -1;
+  unsigned int MaxFrames = 0;
+  double FrameRate = 10.;
+  std::string TimestampsFile;
+  std::string ReferenceFile;
+  int RpeDelta = 1;
+  double MaxTimeDiff = 0.05;
+  std::string OutputTrajectory;
+  std::string ReportFile;
+  std::string WriteLog;
+  std::string WheelOdomFile;
+  double WheelOdomWeight = 0.;
+  std::string PoseFile;
+  double PoseWeight = 0.;
+  std::string GpsFile;
+  bool OptimizeGraph = false;
+};
+
+//------------------------------------------------------------------------------
+void PrintUsage(const char* exe)
+{
+  std::cout << "Usage : " << exe << " <input> [options]\n"
+    "Replay LiDAR frames through the SLAM and report its performance.\n"
+    "<input> is a directory of PCD frames or a binary frame log.\n\n"
+    "Options :\n"
+    "  --threads N               Number of threads used by the SLAM (default : all cores)\n"
+    "  --verbosity N             SLAM verbosity level (default : 0)\n"
+    "  --ego-motion N            Ego-motion mode (see EgoMotionMode)\n"
+    "  --undistortion N          Undistortion mode (see UndistortionMode)\n"
+    "  --max-frames N            Only process the N first frames\n"
+    "  --frame-rate HZ           Frame rate used to timestamp PCD frames (default : 10)\n"
+    "  --timestamps FILE         Timestamps of the PCD frames, one per line\n"
+    "  --reference FILE          Reference trajectory (TUM format) to compute ATE/RPE\n"
+    "  --rpe-delta N             Frames gap used to compute RPE (default : 1)\n"
+    "  --max-time-diff S         Max time gap to associate a pose to the reference (default : 0.05)\n"
+    "  --output-trajectory FILE  Save the estimated trajectory (TUM format)\n"
+    "  --report FILE             Save the results as JSON\n"
+    "  --write-log FILE          Convert the input frames to a binary frame log and exit\n"
+    "  --wheel-odom FILE         Wheel odometry measurements (time,distance)\n"
+    "  --wheel-odom-weight W     Wheel odometry weight in local optimization\n"
+    "  --pose FILE               External poses measurements (TUM format)\n"
+    "  --pose-weight W           External poses weight in local optimization\n"
+    "  --gps FILE                GPS measurements (time,x,y,z), used in the final pose graph\n"
+    "  --optimize-graph          Run the pose graph optimization at the end\n";
+}
+
+//------------------------------------------------------------------------------
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto next = [&]() -> std::string
+    {
+      if (i + 1 >= argc)
+        throw std::invalid_argument("Missing value for option " + arg);
+      return argv[++i];
+    };
+    if (arg == "-h" || arg == "--help")                return false;
+    else if (arg == "--threads")                       options.NbThreads = std::stoi(next());
+    else if (arg == "--verbosity")                     options.Verbosity = std::stoi(next());
+    else if (arg == "--ego-motion")                    options.EgoMotion = std::stoi(next());
+    else if (arg == "--undistortion")                  options.Undistortion = std::stoi(next());
+    else if (arg == "--max-frames")                    options.MaxFrames = std::stoul(next());
+    else if (arg == "--frame-rate")                    options.FrameRate = std::stod(next());
+    else if (arg == "--timestamps")                    options.TimestampsFile = next();
+    else if (arg == "--reference")                     options.ReferenceFile = next();
+    else if (arg == "--rpe-delta")                     options.RpeDelta = std::max(1, std::stoi(next()));
+    else if (arg == "--max-time-diff")                 options.MaxTimeDiff = std::stod(next());
+    else if (arg == "--output-trajectory")             options.OutputTrajectory = next();
+    else if (arg == "--report")                        options.ReportFile = next();
+    else if (arg == "--write-log")                     options.WriteLog = next();
+    else if (arg == "--wheel-odom")                    options.WheelOdomFile = next();
+    else if (arg == "--wheel-odom-weight")             options.WheelOdomWeight = std::stod(next());
+    else if (arg == "--pose")                          options.PoseFile = next();
+    else if (arg == "--pose-weight")                   options.PoseWeight = std::stod(next());
+    else if (arg == "--gps")                           options.GpsFile = next();
+    else if (arg == "--optimize-graph")                options.OptimizeGraph = true;
+    else if (options.Input.empty() && arg[0] != '-')   options.Input = arg;
+    else
+      throw std::invalid_argument("Unknown option " + arg);
+  }
+  return !options.Input.empty();
+}
+
+//==============================================================================
+//   Inputs reading
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Read the numeric rows of a CSV or space separated file.
+// Comments (#) and rows which can not be parsed (e.g. header) are skipped.
+std::vector<std::vector<double>> ReadRows(const std::string& fileName, unsigned int nbColumns)
+{
+  std::vector<std::vector<double>> rows;
+  std::ifstream file(fileName);
+  if (!file.is_open())
+  {
+    PRINT_ERROR("Unable to open " << fileName);
+    return rows;
+  }
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream stream(line);
+    std::vector<double> row;
+    double value;
+    while (stream >> value)
+      row.push_back(value);
+    if (row.size() >= nbColumns)
+      rows.push_back(row);
+  }
+  return rows;
+}
+
+//------------------------------------------------------------------------------
+Trajectory ReadTumTrajectory(const std::string& fileName)
+{
+  Trajectory trajectory;
+  for (const auto& row : ReadRows(fileName, 8))
+  {
+    Eigen::UnalignedIsometry3d pose = Eigen::UnalignedIsometry3d::Identity();
+    pose.translation() << row[1], row[2], row[3];
+    pose.linear() = Eigen::Quaterniond(row[7], row[4], row[5], row[6]).normalized().toRotationMatrix();
+    trajectory.emplace_back(pose, row[0]);
+  }
+  std::sort(trajectory.begin(), trajectory.end(),
+            [](const PoseStamped& a, const PoseStamped& b) { return a.Time < b.Time; });
+  return trajectory;
+}
+
+//------------------------------------------------------------------------------
+bool WriteTumTrajectory(const std::string& fileName, const Trajectory& trajectory)
+{
+  std::ofstream file(fileName);
+  if (!file.is_open())
+  {
+    PRINT_ERROR("Unable to write " << fileName);
+    return false;
+  }
+  file << "# timestamp x y z qx qy qz qw\n" << std::fixed << std::setprecision(9);
+  for (const auto& p : trajectory)
+  {
+    Eigen::Quaterniond q(p.Pose.linear());
+    file << p.Time << " " << p.Pose.translation().x() << " " << p.Pose.translation().y() << " " << p.Pose.translation().z() << " "
+         << q.x() << " " << q.y() << " " << q.z() << " " << q.w() << "\n";
+  }
+  return true;
+}
+
+/**
+ * @brief Sequential reader of the input frames, from a PCD directory or a binary frame log.
+ */
+class FrameReader
+{
+public:
+  bool Open(const Options& options)
+  {
+    namespace fs = boost::filesystem;
+    if (fs::is_directory(options.Input))
+    {
+      for (const auto& entry : fs::directory_iterator(options.Input))
+        if (fs::is_regular_file(entry) && entry.path().extension() == ".pcd")
+          this->PcdFiles.push_back(entry.path().string());
+      std::sort(this->PcdFiles.begin(), this->PcdFiles.end());
+      if (!options.TimestampsFile.empty())
+        for (const auto& row : ReadRows(options.TimestampsFile, 1))
+          this->Timestamps.push_back(row[0]);
+      this->FrameRate = options.FrameRate;
+      return !this->PcdFiles.empty();
+    }
+
+    this->Log.open(options.Input, std::ios::binary);
+    char magic[8];
+    if (!this->Log.read(magic, sizeof(magic)) || std::memcmp(magic, LOG_MAGIC, sizeof(magic)))
+    {
+      PRINT_ERROR(options.Input << " is neither a PCD directory nor a binary frame log");
+      return false;
+    }
+    return true;
+  }
+
+  // Read next frame, return nullptr at the end of the input
+  PointCloud::Ptr Next()
+  {
+    PointCloud::Ptr cloud(new PointCloud);
+    double timestamp;
+    if (!this->PcdFiles.empty())
+    {
+      if (this->Index >= this->PcdFiles.size())
+        return nullptr;
+      if (pcl::io::loadPCDFile(this->PcdFiles[this->Index], *cloud))
+      {
+        PRINT_ERROR("Unable to read " << this->PcdFiles[this->Index]);
+        return nullptr;
+      }
+      // PCD files do not store timestamps
+      timestamp = this->Index < this->Timestamps.size() ? this->Timestamps[this->Index]
+                                                        : this->Index / this->FrameRate;
+    }
+    else
+    {
+      uint32_t nbPoints;
+      if (!this->Read(timestamp) || !this->Read(nbPoints))
+        return nullptr;
+      cloud->resize(nbPoints);
+      for (auto& p : *cloud)
+      {
+        if (!(this->Read(p.x) && this->Read(p.y) && this->Read(p.z) && this->Read(p.time) && this->Read(p.intensity) &&
+              this->Read(p.laser_id) && this->Read(p.device_id) && this->Read(p.label)))
+        {
+          PRINT_ERROR("Truncated binary frame log");
+          return nullptr;
+        }
+      }
+    }
+    cloud->header.stamp = Utils::SecToPclStamp(timestamp);
+    cloud->header.seq = this->Index++;
+    return cloud;
+  }
+
+private:
+  template<typename T>
+  bool Read(T& value) { return static_cast<bool>(this->Log.read(reinterpret_cast<char*>(&value), sizeof(T))); }
+
+  std::vector<std::string> PcdFiles;
+  std::vector<double> Timestamps;
+  double FrameRate = 10.;
+  std::ifstream Log;
+  unsigned int Index = 0;
+};
+
+//------------------------------------------------------------------------------
+// Append a frame to a binary frame log
+template<typename T>
+void Write(std::ofstream& log, const T& value) { log.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+void WriteFrame(std::ofstream& log, const PointCloud& cloud)
+{
+  Write(log, Utils::PclStampToSec(cloud.header.stamp));
+  Write(log, static_cast<uint32_t>(cloud.size()));
+  for (const auto& p : cloud)
+  {
+    Write(log, p.x); Write(log, p.y); Write(log, p.z); Write(log, p.time); Write(log, p.intensity);
+    Write(log, p.laser_id); Write(log, p.device_id); Write(log, p.label);
+  }
+}
+
+/**
+ * @brief External sensors measurements, fed to the SLAM in time order.
+ */
+struct SensorsFeeder
+{
+  std::vector<ExternalSensors::WheelOdomMeasurement> WheelOdom;
+  std::vector<ExternalSensors::PoseMeasurement> Poses;
+  std::vector<ExternalSensors::GpsMeasurement> Gps;
+  std::size_t WheelOdomIdx = 0, PoseIdx = 0, GpsIdx = 0;
+
+  void Load(const Options& options)
+  {
+    if (!options.WheelOdomFile.empty())
+      for (const auto& row : ReadRows(options.WheelOdomFile, 2))
+        this->WheelOdom.push_back({row[0], row[1]});
+    if (!options.PoseFile.empty())
+      for (const auto& p : ReadTumTrajectory(options.PoseFile))
+      {
+        ExternalSensors::PoseMeasurement meas;
+        meas.Time = p.Time;
+        meas.Pose = Eigen::Isometry3d(p.Pose.matrix());
+        this->Poses.push_back(meas);
+      }
+    if (!options.GpsFile.empty())
+      for (const auto& row : ReadRows(options.GpsFile, 4))
+      {
+        ExternalSensors::GpsMeasurement meas;
+        meas.Time = row[0];
+        meas.Position << row[1], row[2], row[3];
+        meas.Covariance = Eigen::Matrix3d::Identity() * 4e-4; // 2cm
+        this->Gps.push_back(meas);
+      }
+  }
+
+  // Feed the measurements acquired before the given time
+  void Feed(Slam& slam, double time)
+  {
+    for (; this->WheelOdomIdx < this->WheelOdom.size() && this->WheelOdom[this->WheelOdomIdx].Time <= time; ++this->WheelOdomIdx)
+      slam.AddWheelOdomMeasurement(this->WheelOdom[this->WheelOdomIdx]);
+    for (; this->PoseIdx < this->Poses.size() && this->Poses[this->PoseIdx].Time <= time; ++this->PoseIdx)
+      slam.AddPoseMeasurement(this->Poses[this->PoseIdx]);
+    for (; this->GpsIdx < this->Gps.size() && this->Gps[this->GpsIdx].Time <= time; ++this->GpsIdx)
+      slam.AddGpsMeasurement(this->Gps[this->GpsIdx]);
+  }
+};
+
+//==============================================================================
+//   Results
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Peak resident memory of the process, in MB
+double PeakRssMB()
+{
+#ifndef _WIN32
+  struct rusage usage;
+  if (!getrusage(RUSAGE_SELF, &usage))
+    return usage.ru_maxrss / 1024.; // kB on Linux
+#endif
+  return -1.;
+}
+
+//------------------------------------------------------------------------------
+struct TrajectoryErrors
+{
+  unsigned int NbAssociated = 0;
+  double AteRmse = 0.;           ///< [m] absolute translation error, after rigid alignment
+  double AteMax = 0.;            ///< [m]
+  double RpeTranslationRmse = 0.; ///< [m] relative translation error over RpeDelta frames
+  double RpeRotationRmse = 0.;    ///< [°] relative rotation error over RpeDelta frames
+};
+
+//------------------------------------------------------------------------------
+TrajectoryErrors ComputeErrors(const Trajectory& estimated, const Trajectory& reference, int rpeDelta, double maxTimeDiff)
+{
+  TrajectoryErrors errors;
+
+  // Associate each estimated pose to the reference pose interpolated at the same time
+  std::vector<Eigen::Isometry3d> est, ref;
+  for (const auto& p : estimated)
+  {
+    auto next = std::lower_bound(reference.begin(), reference.end(), p.Time,
+                                 [](const PoseStamped& r, double t) { return r.Time < t; });
+    if (next == reference.begin() || next == reference.end())
+      continue;
+    auto prev = std::prev(next);
+    if (std::min(p.Time - prev->Time, next->Time - p.Time) > maxTimeDiff)
+      continue;
+    est.push_back(Eigen::Isometry3d(p.Pose.matrix()));
+    ref.push_back(Interpolation::LinearInterpo(*prev, *next, p.Time));
+  }
+  errors.NbAssociated = est.size();
+  if (est.size() < 3)
+    return errors;
+
+  // ATE : align the estimated positions on the reference ones (SLAM and
+  // reference frames differ), then compare positions
+  Eigen::Matrix3Xd estPositions(3, est.size()), refPositions(3, est.size());
+  for (unsigned int i = 0; i < est.size(); ++i)
+  {
+    estPositions.col(i) = est[i].translation();
+    refPositions.col(i) = ref[i].translation();
+  }
+  Eigen::Isometry3d alignment(Eigen::umeyama(estPositions, refPositions, false));
+  double sqSum = 0.;
+  for (unsigned int i = 0; i < est.size(); ++i)
+  {
+    double error = (alignment * est[i].translation() - ref[i].translation()).norm();
+    sqSum += error * error;
+    errors.AteMax = std::max(errors.AteMax, error);
+  }
+  errors.AteRmse = std::sqrt(sqSum / est.size());
+
+  // RPE : compare the relative motions over rpeDelta frames
+  double sqTrans = 0., sqRot = 0.;
+  unsigned int nbPairs = 0;
+  for (unsigned int i = 0; i + rpeDelta < est.size(); ++i)
+  {
+    Eigen::Isometry3d estMotion = est[i].inverse() * est[i + rpeDelta];
+    Eigen::Isometry3d refMotion = ref[i].inverse() * ref[i + rpeDelta];
+    Eigen::Isometry3d error = refMotion.inverse() * estMotion;
+    sqTrans += error.translation().squaredNorm();
+    double angle = Utils::Rad2Deg(Eigen::AngleAxisd(error.linear()).angle());
+    sqRot += angle * angle;
+    ++nbPairs;
+  }
+  if (nbPairs)
+  {
+    errors.RpeTranslationRmse = std::sqrt(sqTrans / nbPairs);
+    errors.RpeRotationRmse = std::sqrt(sqRot / nbPairs);
+  }
+  return errors;
+}
+
+} // end of anonymous namespace
+
+//==============================================================================
+//   Main
+//==============================================================================
+
+int main(int argc, char** argv)
+{
+  Options options;
+  try
+  {
+    if (!ParseOptions(argc, argv, options))
+    {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    PRINT_ERROR(e.what());
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  FrameReader reader;
+  if (!reader.Open(options))
+  {
+    PRINT_ERROR("No frame to read in " << options.Input);
+    return 1;
+  }
+
+  // Only convert the input frames to a binary log
+  if (!options.WriteLog.empty())
+  {
+    std::ofstream log(options.WriteLog, std::ios::binary);
+    log.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+    unsigned int nbFrames = 0;
+    PointCloud::Ptr frame;
+    while ((!options.MaxFrames || nbFrames < options.MaxFrames) && (frame = reader.Next()))
+    {
+      WriteFrame(log, *frame);
+      ++nbFrames;
+    }
+    std::cout << nbFrames << " frames written to " << options.WriteLog << std::endl;
+    return 0;
+  }
+
+  // Set up SLAM
+  Slam slam;
+  slam.SetVerbosity(options.Verbosity);
+  slam.SetNbThreads(options.NbThreads);
+  if (options.EgoMotion >= 0)
+    slam.SetEgoMotion(static_cast<EgoMotionMode>(options.EgoMotion));
+  if (options.Undistortion >= 0)
+    slam.SetUndistortion(static_cast<UndistortionMode>(options.Undistortion));
+  SensorsFeeder sensors;
+  sensors.Load(options);
+  if (!sensors.WheelOdom.empty())
+    slam.SetWheelOdomWeight(options.WheelOdomWeight);
+  if (!sensors.Poses.empty())
+    slam.SetPoseWeight(options.PoseWeight);
+
+  // Replay frames, only timing the SLAM processing
+  Trajectory estimated;
+  unsigned int nbFrames = 0;
+  double processingDuration = 0.;
+  auto replayStart = std::chrono::steady_clock::now();
+  PointCloud::Ptr frame;
+  while ((!options.MaxFrames || nbFrames < options.MaxFrames) && (frame = reader.Next()))
+  {
+    // The measurements acquired until the end of the frame are available
+    double frameTime = Utils::PclStampToSec(frame->header.stamp);
+    double lastPointTime = frameTime;
+    for (const auto& p : *frame)
+      lastPointTime = std::max(lastPointTime, frameTime + p.time);
+    sensors.Feed(slam, lastPointTime);
+
+    auto start = std::chrono::steady_clock::now();
+    slam.AddFrames({frame});
+    processingDuration += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++nbFrames;
+
+    LidarState state = slam.GetLastState();
+    if (estimated.empty() || state.Time > estimated.back().Time)
+      estimated.emplace_back(Eigen::UnalignedIsometry3d(state.Isometry.matrix()), state.Time);
+  }
+  double replayDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+
+  // Optionally refine the trajectory with the pose graph
+  double graphDuration = 0.;
+  if (options.OptimizeGraph)
+  {
+    auto start = std::chrono::steady_clock::now();
+    if (slam.OptimizeGraph())
+    {
+      for (const auto& state : slam.GetLogStates())
+      {
+        auto it = std::lower_bound(estimated.begin(), estimated.end(), state.Time - 1e-6,
+                                   [](const PoseStamped& p, double t) { return p.Time < t; });
+        if (it != estimated.end() && std::abs(it->Time - state.Time) < 1e-6)
+          it->Pose = Eigen::UnalignedIsometry3d(state.Isometry.matrix());
+      }
+    }
+    graphDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  if (!options.OutputTrajectory.empty())
+    WriteTumTrajectory(options.OutputTrajectory, estimated);
+
+  TrajectoryErrors errors;
+  if (!options.ReferenceFile.empty())
+    errors = ComputeErrors(estimated, ReadTumTrajectory(options.ReferenceFile), options.RpeDelta, options.MaxTimeDiff);
+
+  // Report
+  auto stages = slam.GetTimingStatistics();
+  double peakRss = PeakRssMB();
+  SET_COUT_FIXED_PRECISION(3);
+  std::cout << "\n========== SLAM benchmark ==========\n"
+            << "Frames processed    : " << nbFrames << "\n"
+            << "Processing time     : " << processingDuration << " s (replay " << replayDuration << " s)\n"
+            << "Throughput          : " << (processingDuration > 0. ? nbFrames / processingDuration : 0.) << " frames/s\n"
+            << "Peak RSS            : " << peakRss << " MB\n";
+  if (options.OptimizeGraph)
+    std::cout << "Pose graph          : " << graphDuration << " s\n";
+  if (!options.ReferenceFile.empty())
+  {
+    std::cout << "Associated poses    : " << errors.NbAssociated << " / " << estimated.size() << "\n"
+              << "ATE RMSE / max      : " << errors.AteRmse << " / " << errors.AteMax << " m\n"
+              << "RPE (" << options.RpeDelta << " frames)      : " << errors.RpeTranslationRmse << " m, "
+              << errors.RpeRotationRmse << " °\n";
+  }
+  std::cout << "\nStage latencies [ms]  " << std::setw(8) << "count" << std::setw(9) << "mean" << std::setw(9) << "p50"
+            << std::setw(9) << "p95" << std::setw(9) << "p99" << std::setw(9) << "max" << "\n";
+  for (const auto& stage : stages)
+  {
+    const auto& s = stage.second;
+    std::cout << "  " << std::left << std::setw(20) << stage.first << std::right << std::setw(8) << s.Count
+              << std::setw(9) << s.Mean << std::setw(9) << s.P50 << std::setw(9) << s.P95
+              << std::setw(9) << s.P99 << std::setw(9) << s.Max << "\n";
+  }
+  std::cout << std::endl;
+  RESET_COUT_FIXED_PRECISION;
+
+  if (!options.ReportFile.empty())
+  {
+    std::ofstream report(options.ReportFile);
+    if (!report.is_open())
+    {
+      PRINT_ERROR("Unable to write " << options.ReportFile);
+      return 1;
+    }
+    report << std::setprecision(9)
+           << "{\n"
+           << "  \"frames\": " << nbFrames << ",\n"
+           << "  \"processing_time_s\": " << processingDuration << ",\n"
+           << "  \"throughput_fps\": " << (processingDuration > 0. ? nbFrames / processingDuration : 0.) << ",\n"
+           << "  \"peak_rss_mb\": " << peakRss << ",\n";
+    if (options.OptimizeGraph)
+      report << "  \"pose_graph_time_s\": " << graphDuration << ",\n";
+    if (!options.ReferenceFile.empty())
+      report << "  \"associated_poses\": " << errors.NbAssociated << ",\n"
+             << "  \"ate_rmse_m\": " << errors.AteRmse << ",\n"
+             << "  \"ate_max_m\": " << errors.AteMax << ",\n"
+             << "  \"rpe_delta_frames\": " << options.RpeDelta << ",\n"
+             << "  \"rpe_translation_rmse_m\": " << errors.RpeTranslationRmse << ",\n"
+             << "  \"rpe_rotation_rmse_deg\": " << errors.RpeRotationRmse << ",\n";
+    report << "  \"stages_ms\": {";
+    for (auto it = stages.begin(); it != stages.end(); ++it)
+    {
+      const auto& s = it->second;
+      report << (it == stages.begin() ? "\n" : ",\n")
+             << "    \"" << it->first << "\": {\"count\": " << s.Count << ", \"mean\": " << s.Mean << ", \"p50\": " << s.P50
+             << ", \"p95\": " << s.P95 << ", \"p99\": " << s.P99 << ", \"max\": " << s.Max << "}";
+    }
+    report << "\n  }\n}\n";
+  }
+  return 0;
+}
@@ -19,6 +19,7 @@
 #pragma once
 
 // LOCAL
+#include "LidarSlam/KeypointsMatcher.h"
 #include "LidarSlam/RollingGrid.h"
 #include "LidarSlam/LidarPoint.h"
 #include "LidarSlam/Enums.h"
@@ -42,7 +43,9 @@ using PointCloud = pcl::PointCloud<Point>;
 // In this LCP extension, we also check the distance between nearest neighbors
 // to make a smooth estimator.
 // To accelerate the process, the ratio of points (between 0 and 1) from the
-// input cloud to compute overlap on can be specified.
+// input cloud to compute overlap on can be specified. The search of a point
+// neighbor stops as soon as it is nearly superimposed on a map point, so the
+// estimation may be underestimated by at most 1%.
 // It returns a valid overlap value between 0 and 1, or -1 if the overlap could
 // not be computed (not enough points).
 float LCPEstimator(PointCloud::ConstPtr cloud,
@@ -50,5 +53,26 @@ float LCPEstimator(PointCloud::ConstPtr cloud,
                    float subsamplingRatio = 1.,
                    int nbThreads = 1);
 
+// Compute an overlap estimator from the keypoints matching results of a
+// registration : it is the ratio of successfully matched keypoints.
+// It is free to compute, but depends on the matching parameters (max distance,
+// model fitting...).
+// It returns a valid overlap value between 0 and 1, or -1 if no keypoint was matched.
+float MatchingEstimator(const std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults);
+
+// Compute an overlap estimator for the registration of some keypoints onto the
+// maps of their type : it is the ratio of keypoints lying in an occupied voxel
+// (of leaf size) of their map, which is tested with a simple hash lookup.
+// The keypoints are expressed in BASE coordinates, and are placed in WORLD
+// coordinates with the given pose.
+// As for LCP estimator, the ratio of keypoints to compute overlap on can be specified.
+// It returns a valid overlap value between 0 and 1, or -1 if the overlap could
+// not be computed (not enough points).
+float VoxelOccupancyEstimator(const std::map<Keypoint, PointCloud::Ptr>& keypoints,
+                              const Eigen::Isometry3d& pose,
+                              const std::map<Keypoint, std::shared_ptr<RollingGrid>>& maps,
+                              float subsamplingRatio = 1.,
+                              int nbThreads = 1);
+
 } // enf of Confidence namespace
 } // end of LidarSlam namespace
\ No newline at end of file
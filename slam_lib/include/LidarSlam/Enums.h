@@ -171,6 +171,24 @@ enum class SamplingMode
   CENTROID = 4
 };
 
+//------------------------------------------------------------------------------
+//! How to estimate the overlap of the current frame with the maps
+enum class OverlapMode
+{
+  //! LCP estimator : nearest neighbor search in the submaps KD-trees
+  //! for the points of the whole registered frame
+  //! Smooth estimator, but the slowest one
+  LCP = 0,
+
+  //! Ratio of keypoints successfully matched during the last localization
+  //! ICP iteration. It comes for free, but depends on the matching parameters.
+  MATCHING = 1,
+
+  //! Ratio of registered keypoints lying in an occupied voxel of the map
+  //! of their type (rolling grid hash lookup, no KD-tree query)
+  VOXEL_OCCUPANCY = 2
+};
+
 //------------------------------------------------------------------------------
 //! External sensors' references
 enum ExternalSensor
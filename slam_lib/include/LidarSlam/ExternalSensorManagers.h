@@ -193,6 +193,13 @@ public:
     return this->Measures;
   }
 
+  // Get the time of the last received measure (-1 if no measure was received)
+  double GetLastMeasureTime() const
+  {
+    std::lock_guard<std::mutex> lock(this->Mtx);
+    return this->Measures.empty() ? -1. : this->Measures.back().Time;
+  }
+
   GetSensorMacro(Residual, CeresTools::Residual)
 
   // -----------------Basic functions-----------------
@@ -0,0 +1,167 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#pragma once
+
+#include "LidarSlam/ExternalSensorManagers.h"
+#include "LidarSlam/State.h"
+
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/nonlinear/ISAM2.h>
+#include <gtsam/nonlinear/NonlinearFactorGraph.h>
+#include <gtsam/nonlinear/Values.h>
+
+#include <list>
+#include <set>
+#include <vector>
+
+#define SetMacro(name,type) void Set##name (type _arg) { name = _arg; }
+#define GetMacro(name,type) type Get##name () const { return name; }
+
+namespace LidarSlam
+{
+/**
+ * @brief The IncrementalPoseGraph class optimizes the SLAM trajectory
+ * incrementally with iSAM2, using the same constraints as PoseGraphOptimizer
+ * (odometry, loop closures, landmarks and GPS).
+ *
+ * Contrary to PoseGraphOptimizer, the graph is kept between optimizations :
+ * only the new states and the new constraints are added at each update, and
+ * iSAM2 only relinearizes and re-eliminates the part of the Bayes tree they
+ * affect. The cost of an update is therefore roughly constant, and does not
+ * grow with the trajectory length (except when a loop closure is added).
+ *
+ * The states are identified by their index, which must be increasing.
+ * If states were removed before being added to the graph, the first new
+ * state is linked to the last added one with the current relative pose.
+ *
+ * To bound the graph size, the oldest states can be marginalized : their
+ * information is kept as a prior on the remaining states, as done by gtsam
+ * IncrementalFixedLagSmoother.
+ */
+class IncrementalPoseGraph
+{
+public:
+  IncrementalPoseGraph();
+
+  //! Remove all states and constraints from the graph
+  void Reset();
+
+  //! Check if the graph contains a state
+  bool HasState(unsigned int index) const;
+
+  //! Index of the last state added to the graph (undefined if graph is empty)
+  GetMacro(LastIndex, unsigned int)
+
+  //! Number of states in the graph
+  unsigned int GetNbStates() const { return this->StatesIndices.size(); }
+
+  //! Add the states newer than the last added one, linked by odometry constraints.
+  //! It returns the number of added states.
+  unsigned int AddLidarStates(const std::list<LidarState>& states);
+
+  //! Check if a loop closure constraint already links two states
+  bool HasLoopClosure(unsigned int queryFrameIdx, unsigned int revisitedFrameIdx) const;
+
+  //! Add a constraint from a loop closure detection (the transform is from the revisited frame to the query frame)
+  bool AddLoopClosureConstraint(unsigned int queryFrameIdx, unsigned int revisitedFrameIdx,
+                                const Eigen::Isometry3d& loopClosureTransform, const Eigen::Matrix6d& loopClosureCovariance);
+
+  //! Add a constraint from a landmark detection.
+  //! The landmark measurement is expressed in the landmark detector frame,
+  //! which is placed on the base frame with detectorCalibration.
+  bool AddLandmarkConstraint(unsigned int lidarIdx, const Eigen::Isometry3d& detectorCalibration,
+                             const Eigen::Isometry3d& lmPose, const ExternalSensors::LandmarkMeasurement& lm,
+                             bool onlyPosition = false);
+
+  //! Add a constraint from a GPS measure, expressed in SLAM world frame.
+  //! The GPS antenna is placed on the base frame with gpsCalibration.
+  bool AddGpsConstraint(unsigned int lidarIdx, const Eigen::Isometry3d& gpsCalibration,
+                        const ExternalSensors::GpsMeasurement& gpsMeas);
+
+  //! Marginalize the states older than the given index during next updates.
+  //! They can not be constrained anymore. The last state is never marginalized.
+  void MarginalizeStatesBefore(unsigned int index) { this->MarginalizationIndex = index; }
+
+  //! Update the iSAM2 solution with the new states and constraints, and
+  //! marginalize the old states.
+  //! The indices of the states added or whose optimized pose has changed
+  //! since the previous update are set, in increasing order.
+  bool Process(std::vector<unsigned int>& updatedIndices);
+
+  //! Get the optimized pose of a state. Return false if the state is not in the graph.
+  bool GetPose(unsigned int index, Eigen::Isometry3d& pose) const;
+
+  GetMacro(Verbose, bool)
+  SetMacro(Verbose, bool)
+
+  GetMacro(FixFirst, bool)
+  SetMacro(FixFirst, bool)
+
+  GetMacro(NbUpdates, int)
+  SetMacro(NbUpdates, int)
+
+private:
+  // Convert a SLAM covariance (X, Y, Z, rX, rY, rZ) to a gtsam Pose3 covariance (rX, rY, rZ, X, Y, Z)
+  static Eigen::Matrix6d ToPose3Covariance(const Eigen::Matrix6d& covariance);
+
+  // Add the robustifier to a gaussian noise model
+  gtsam::SharedNoiseModel Robustify(const gtsam::SharedNoiseModel& model) const;
+
+  // Select the states to marginalize at this update : they must be in iSAM2
+  // already, and not be involved in the new constraints
+  gtsam::FastList<gtsam::Key> GetStatesToMarginalize() const;
+
+private:
+  gtsam::ISAM2 Isam;
+
+  // Factors and values not yet added to iSAM2
+  gtsam::NonlinearFactorGraph NewFactors;
+  gtsam::Values NewValues;
+
+  // Optimized poses of the states after the last update
+  gtsam::Values Estimate;
+
+  // States contained in the graph (added to iSAM2 or pending)
+  std::set<unsigned int> StatesIndices;
+  unsigned int LastIndex = 0;
+  // Pose of the last added state : it is updated after each optimization
+  // to link the next states with their relative pose
+  Eigen::Isometry3d LastPose = Eigen::Isometry3d::Identity();
+
+  // Pairs (query, revisited) of the loop closure constraints
+  std::set<std::pair<unsigned int, unsigned int>> LoopClosures;
+
+  // States older than this index are marginalized
+  unsigned int MarginalizationIndex = 0;
+
+  bool Verbose = false;
+  // Boolean to decide whether to fix the first pose or not
+  bool FixFirst = false;
+  // Number of iSAM2 updates performed at each processing.
+  // Additional updates relinearize the variables which moved much.
+  int NbUpdates = 2;
+  // Saturation distance to remove outliers (used in robustifier)
+  float SaturationDistance = 5.f;
+  // Min fraction of the graph states to marginalize at once, to amortize the
+  // re-elimination of the cliques depending on them
+  double MarginalizationRatio = 0.1;
+  // Tolerance to consider that an optimized pose has changed
+  double PoseTolerance = 1e-6;
+};
+
+} // end of LidarSlam namespace
@@ -0,0 +1,215 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#pragma once
+
+#include "LidarSlam/LidarPoint.h"
+
+#include <pcl/point_cloud.h>
+#include <Eigen/Dense>
+#include <nanoflann.hpp>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#define SetMacro(name,type) void Set##name (type _arg) { name = _arg; }
+#define GetMacro(name,type) type Get##name () const { return name; }
+
+namespace LidarSlam
+{
+
+/*!
+ * @brief Place recognition index used to detect loop closures automatically.
+ *
+ * A Scan Context global descriptor is computed for each added frame : the
+ * horizontal plane around the sensor is split into rings and sectors, and each
+ * bin stores the max height of the points it contains (relatively to the
+ * lowest point of the frame). This descriptor is a compact summary of the
+ * scene structure, independent of the sensor heading up to a circular shift
+ * of its sectors.
+ *
+ * Candidates are searched in two steps :
+ *  - the rotation invariant ring keys (mean height of each ring) of the
+ *    indexed frames are searched for the nearest ones to the query one, in a
+ *    KD-tree rebuilt each time TreeRebuildBatch frames have been added (the
+ *    frames added since the last rebuild are compared linearly),
+ *  - the full descriptors of these candidates are then compared to the query
+ *    one, the best sector shift being first estimated with the sector keys
+ *    (mean height of each sector) and refined around this estimate.
+ *
+ * The frames are identified by their index, which must be increasing.
+ * Descriptors computation and search cost a few tens of microseconds, and the
+ * search cost grows logarithmically with the number of indexed frames, which
+ * makes them usable online on each keyframe.
+ */
+class LoopClosureDetector
+{
+public:
+  // Useful types
+  using Point = LidarPoint;
+  using PointCloud = pcl::PointCloud<Point>;
+  using Descriptor = Eigen::MatrixXf;
+
+  //! Loop closure candidate found in the index
+  struct Candidate
+  {
+    unsigned int Index;  ///< Index of the revisited frame
+    float Distance;      ///< Descriptor distance to the query frame, in [0, 1]
+    float Yaw;           ///< [rad] Estimated heading of the query frame relatively to the revisited one
+  };
+
+  //============================================================================
+  //   Parameters
+  //============================================================================
+
+  //! Descriptor size : changing it clears the index.
+  void SetNbRings(unsigned int nbRings);
+  GetMacro(NbRings, unsigned int)
+
+  void SetNbSectors(unsigned int nbSectors);
+  GetMacro(NbSectors, unsigned int)
+
+  void SetMaxRadius(double radius);
+  GetMacro(MaxRadius, double)
+
+  SetMacro(NbCandidates, unsigned int)
+  GetMacro(NbCandidates, unsigned int)
+
+  SetMacro(MinIndexGap, unsigned int)
+  GetMacro(MinIndexGap, unsigned int)
+
+  SetMacro(MaxDistance, double)
+  GetMacro(MaxDistance, double)
+
+  SetMacro(TreeRebuildBatch, unsigned int)
+  GetMacro(TreeRebuildBatch, unsigned int)
+
+  //============================================================================
+  //   Index management
+  //============================================================================
+
+  //! Remove all frames from the index
+  void Clear();
+
+  //! Number of indexed frames
+  unsigned int Size() const { return this->Entries.size(); }
+
+  //! Index of the last added frame (undefined if index is empty)
+  unsigned int GetLastIndex() const { return this->Entries.back().Index; }
+
+  //! Compute the descriptor of a frame and add it to the index.
+  //! The pointclouds (typically the different keypoints of a frame) must be
+  //! expressed in the sensor/base frame, with the Z axis pointing upward.
+  //! The index must be greater than the previously added ones.
+  void AddFrame(unsigned int index, const std::vector<PointCloud::ConstPtr>& clouds);
+
+  //! Remove the frames with index lower than the given one
+  void RemoveBefore(unsigned int index);
+
+  //! Look for loop closure candidates of the indexed frame #queryIndex.
+  //! Only frames with index lower than queryIndex - MinIndexGap are considered.
+  //! The candidates are sorted by increasing descriptor distance, and only
+  //! those with distance lower than MaxDistance are returned.
+  std::vector<Candidate> FindCandidates(unsigned int queryIndex) const;
+
+  //============================================================================
+  //   Descriptor helpers
+  //============================================================================
+
+  //! Compute the Scan Context descriptor of a frame (NbRings x NbSectors)
+  Descriptor ComputeDescriptor(const std::vector<PointCloud::ConstPtr>& clouds) const;
+
+  //! Compute the distance between 2 descriptors, in [0, 1].
+  //! It is the mean cosine distance between the sectors of the 2 descriptors,
+  //! the sectors of d2 being circularly shifted by the best found shift.
+  //! If not null, the best found shift is returned in bestShift.
+  float Distance(const Descriptor& d1, const Descriptor& d2, int* bestShift = nullptr) const;
+
+private:
+  struct Entry
+  {
+    unsigned int Index;
+    Descriptor Desc;
+    Eigen::VectorXf RingKey;
+    Eigen::VectorXf SectorKey;
+  };
+
+  // Ring keys of the frames indexed in the KD-tree (one column per frame),
+  // with the nanoflann dataset adaptor interface
+  struct RingKeysSet
+  {
+    Eigen::MatrixXf Keys;
+    std::vector<unsigned int> Indices;
+
+    inline size_t kdtree_get_point_count() const { return this->Indices.size(); }
+    inline float kdtree_get_pt(const int idx, const int dim) const { return this->Keys(dim, idx); }
+    template <class BBOX>
+    inline bool kdtree_get_bbox(BBOX& /*bb*/) const { return false; }
+  };
+  using RingKeysMetric = nanoflann::metric_L2_Simple::traits<float, RingKeysSet>::distance_t;
+  using RingKeysTree = nanoflann::KDTreeSingleIndexAdaptor<RingKeysMetric, RingKeysSet, -1, int>;
+
+  // Build the KD-tree with the ring keys of all indexed frames
+  void BuildTree();
+
+  // Mean cosine distance between the sectors of d1 and the sectors of d2
+  // circularly shifted by shift
+  float ShiftedDistance(const Descriptor& d1, const Descriptor& d2, int shift) const;
+
+  // Estimate the sector shift between 2 descriptors from their sector keys
+  int EstimateShift(const Eigen::VectorXf& sectorKey1, const Eigen::VectorXf& sectorKey2) const;
+
+  const Entry* FindEntry(unsigned int index) const;
+
+private:
+  //! Number of rings (radial bins) of the descriptor
+  unsigned int NbRings = 20;
+
+  //! Number of sectors (angular bins) of the descriptor
+  unsigned int NbSectors = 60;
+
+  //! [m] Max horizontal distance of the points used in the descriptor
+  double MaxRadius = 80.;
+
+  //! Number of nearest ring keys whose full descriptor is compared to the query
+  unsigned int NbCandidates = 10;
+
+  //! Min index difference between the query frame and the revisited frames,
+  //! to avoid detecting the recent frames as loops
+  unsigned int MinIndexGap = 200;
+
+  //! Max descriptor distance to consider a candidate as a loop
+  double MaxDistance = 0.3;
+
+  //! Number of sectors to explore around the shift estimated with sector keys
+  int ShiftSearchRadius = 3;
+
+  //! Number of frames to add before rebuilding the ring keys KD-tree.
+  //! The frames added since the last rebuild are compared linearly.
+  unsigned int TreeRebuildBatch = 64;
+
+  //! Indexed frames, sorted by increasing index
+  std::deque<Entry> Entries;
+
+  //! Ring keys KD-tree, and the ring keys it was built from.
+  //! The frames removed since the last rebuild are ignored in its results.
+  RingKeysSet TreeKeys;
+  std::unique_ptr<RingKeysTree> Tree;
+};
+
+} // end of LidarSlam namespace
@@ -0,0 +1,153 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace LidarSlam
+{
+
+/*!
+ * @brief Native keypoints map file, storing the voxel layout of a RollingGrid.
+ *
+ * The file is made of 3 sections :
+ *  - a fixed size header, describing the voxel grid parameters,
+ *  - the index of the non empty outer voxels, sorted by (z, y, x) coordinates,
+ *  - the points of all outer voxels, each voxel points being contiguous.
+ *
+ * Outer voxels are identified by their global integer coordinates : the voxel
+ * (i, j, k) is centered on (i, j, k) * VoxelWidth, whatever the position of
+ * the rolling grid when the map was saved.
+ *
+ * The file is read through a read-only memory mapping : opening it only reads
+ * the header and the index, and the points of an outer voxel are only paged
+ * in from disk when they are accessed.
+ * Records are stored in the native endianness.
+ */
+class MapFile
+{
+public:
+
+  //! Header at the beginning of the file
+  struct Header
+  {
+    char Magic[8];              ///< File signature, "SLAMMAP" followed by a null character
+    uint32_t Version;           ///< File format version
+    uint32_t PointRecordSize;   ///< Size of a point record, to check compatibility
+    double LeafSize;            ///< [m] Size of an inner voxel
+    double VoxelWidth;          ///< [m] Size of an outer voxel
+    int32_t GridInSize;         ///< [voxels] Number of inner voxels in each direction of an outer voxel
+    int32_t Padding = 0;
+    float MinPoint[3];          ///< [m] Min corner of the map bounding box
+    float MaxPoint[3];          ///< [m] Max corner of the map bounding box
+    uint64_t NbVoxels;          ///< Number of outer voxels in index
+    uint64_t NbPoints;          ///< Total number of points
+    uint64_t IndexOffset;       ///< [bytes] Position of the outer voxels index in file
+    uint64_t PointsOffset;      ///< [bytes] Position of the first point record in file
+  };
+
+  //! Index entry of an outer voxel
+  struct VoxelRecord
+  {
+    int32_t X, Y, Z;            ///< Global coordinates of the outer voxel
+    uint32_t NbPoints;          ///< Number of points in this voxel
+    uint64_t FirstPoint;        ///< Index of the first point of this voxel in the points section
+
+    //! Index order : by z, then y, then x coordinates
+    bool operator<(const VoxelRecord& other) const
+    {
+      return std::tie(this->Z, this->Y, this->X) < std::tie(other.Z, other.Y, other.X);
+    }
+  };
+
+  //! Point stored in an inner voxel, with its voxel state
+  struct PointRecord
+  {
+    float X, Y, Z;              ///< Point coordinates
+    float Intensity;
+    double Time;
+    uint32_t InnerIndex;        ///< Flattened index of the inner voxel in its outer voxel
+    uint32_t Count;             ///< Number of frames that have updated this inner voxel
+    uint16_t LaserId;
+    uint8_t DeviceId;
+    uint8_t Label;
+    uint32_t Padding = 0;
+  };
+
+  static constexpr uint32_t FormatVersion = 1;
+
+  //----------------------------------------------------------------------------
+  //! Write a map file.
+  //! Voxels must be sorted in index order, the points of each voxel being
+  //! contiguous in points, starting at its FirstPoint.
+  //! Header magic, version, counts and offsets are filled by this function.
+  //! Return false if the file could not be written.
+  static bool Write(const std::string& path, Header header,
+                    const std::vector<VoxelRecord>& voxels,
+                    const std::vector<PointRecord>& points);
+
+  //----------------------------------------------------------------------------
+  //! Map a file in memory and check its header and index : sections must fit
+  //! in file, and index must be sorted with points ranges in the points section.
+  //! Return false if the file can not be mapped or is not a valid map file.
+  bool Open(const std::string& path);
+
+  //! Release the file mapping
+  void Close();
+
+  bool IsOpen() const { return this->Region != nullptr; }
+
+  const std::string& GetPath() const { return this->Path; }
+
+  const Header& GetHeader() const { return *this->FileHeader; }
+
+  //! Number of outer voxels in file
+  size_t GetNbVoxels() const { return this->IsOpen() ? this->FileHeader->NbVoxels : 0; }
+
+  //! Get the index of the outer voxels (GetNbVoxels entries, in index order)
+  const VoxelRecord* GetVoxels() const { return this->Voxels; }
+
+  //! Get the index entry of an outer voxel, or nullptr if it is empty
+  const VoxelRecord* FindVoxel(const Eigen::Array3i& coords) const;
+
+  //! Get the index entries of the outer voxels lying in the given box of
+  //! global voxel coordinates (bounds included)
+  std::vector<const VoxelRecord*> FindVoxels(const Eigen::Array3i& minCoords, const Eigen::Array3i& maxCoords) const;
+
+  //! Get the points of an outer voxel (NbPoints records)
+  const PointRecord* GetPoints(const VoxelRecord& voxel) const { return this->Points + voxel.FirstPoint; }
+
+private:
+
+  std::string Path;
+  std::unique_ptr<boost::interprocess::mapped_region> Region;   ///< Read-only mapping of the whole file
+  const Header* FileHeader = nullptr;
+  const VoxelRecord* Voxels = nullptr;                          ///< Outer voxels index, in mapping
+  const PointRecord* Points = nullptr;                          ///< Points section, in mapping
+};
+
+} // end of LidarSlam namespace
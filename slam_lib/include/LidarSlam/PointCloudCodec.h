@@ -0,0 +1,76 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#pragma once
+
+// LOCAL
+#include "LidarSlam/LidarPoint.h"
+
+// PCL
+#include <pcl/point_cloud.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace LidarSlam
+{
+namespace Codec
+{
+
+using Point = LidarPoint;
+using PointCloud = pcl::PointCloud<Point>;
+
+//! Parameters of the LidarPoint codec.
+struct Parameters
+{
+  // Quantization step of the x, y and z coordinates (in meters).
+  // The maximum coordinate error is half this value.
+  // It must be positive : otherwise, the default value is used.
+  double PositionPrecision = 0.001;
+
+  // Quantization step of the time field (in seconds).
+  // It must be positive : otherwise, the default value is used.
+  double TimePrecision = 1e-6;
+
+  // Number of consecutive points encoded together.
+  // Each block is independent, allowing multithreaded encoding/decoding.
+  unsigned int BlockSize = 4096;
+
+  // Max number of threads to use to encode/decode blocks.
+  int NbThreads = 1;
+
+  // Check if a quantization step is usable (positive and finite)
+  static bool IsPrecisionValid(double precision) { return std::isfinite(precision) && precision > 0.; }
+};
+
+// Compress a LidarPoint pointcloud into a compact binary buffer.
+// Coordinates and time are quantized according to the given precisions,
+// intensity, laser_id, device_id and label fields are stored losslessly, as
+// well as the PCL header.
+// Each field is delta coded relatively to the previous point, as successive
+// lidar points are usually close in space and time, before being packed with
+// variable length integers (and run-length encoding for device_id and label).
+std::vector<uint8_t> Encode(const PointCloud& cloud, const Parameters& params = Parameters());
+
+// Decompress a binary buffer created with Encode() into a pointcloud.
+// Blocks are decoded in parallel using at most nbThreads threads.
+// It returns false if data is corrupted, leaving cloud empty.
+bool Decode(const std::vector<uint8_t>& data, PointCloud& cloud, int nbThreads = 1);
+
+} // end of Codec namespace
+} // end of LidarSlam namespace
@@ -25,8 +25,25 @@
 #endif
 #include <pcl/io/pcd_io.h>
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 #include "LidarSlam/Utilities.h"
+#include "LidarSlam/LidarPoint.h"
+#include "LidarSlam/PointCloudCodec.h"
 
 // PCL Octree compression does not compile properly on Windows with MSVC
 // This issue may not be present on PCL version higher than 1.10.1
@@ -71,7 +88,9 @@ enum PointCloudStorageType
   OCTREE_COMPRESSED = 1,
   PCD_ASCII = 2,
   PCD_BINARY = 3,
-  PCD_BINARY_COMPRESSED = 4
+  PCD_BINARY_COMPRESSED = 4,
+  LIDAR_COMPRESSED = 5,
+  MAPPED_FILE = 6
 };
 
 //------------------------------------------------------------------------------
@@ -117,37 +136,44 @@ int savePointCloudToPCD(std::string const& path,
 //------------------------------------------------------------------------------
 /*!
  * @brief Base abstract class to store a PCL pointcloud under different formats.
+ *
+ * Stored clouds are considered immutable : the input cloud is only read (or
+ * shared without any copy for the uncompressed storage) and the returned cloud
+ * must not be modified. A caller needing to edit the points must copy them.
  */
 template<typename PointT>
 struct PointCloudData
 {
   using CloudT = pcl::PointCloud<PointT>;
-  using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
 
   virtual ~PointCloudData() = default;
 
-  virtual void SetCloud(CloudTPtr const& cloud) = 0;  ///< Fill with new cloud.
-  virtual CloudTPtr GetCloud() = 0;                   ///< Get stored cloud.
-  virtual size_t GetMemorySize() = 0;                 ///< Approximate memory usage by pointcloud data.
+  virtual void SetCloud(CloudTConstPtr const& cloud) = 0;  ///< Fill with new cloud.
+  virtual CloudTConstPtr GetCloud() = 0;                   ///< Get stored cloud.
+  virtual size_t GetMemorySize() = 0;                      ///< Approximate memory usage by pointcloud data.
 };
 
 //------------------------------------------------------------------------------
 /*!
  * @brief Store PCL pointcloud without any compression in RAM.
+ *
+ * The input cloud is not copied : its ownership is shared with the caller,
+ * which must not modify it afterwards.
  */
 template<typename PointT>
 struct PCLPointCloud final : public PointCloudData<PointT>
 {
   using CloudT = pcl::PointCloud<PointT>;
-  using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
 
-  PCLPointCloud(CloudTPtr const& cloud) : Cloud(cloud) {}
-  void SetCloud(CloudTPtr const& cloud) override { this->Cloud = cloud; }
-  CloudTPtr GetCloud() override { return this->Cloud; }
+  PCLPointCloud(CloudTConstPtr const& cloud) : Cloud(cloud) {}
+  void SetCloud(CloudTConstPtr const& cloud) override { this->Cloud = cloud; }
+  CloudTConstPtr GetCloud() override { return this->Cloud; }
   size_t GetMemorySize() override { return sizeof(*this->Cloud) + (sizeof(PointT) * this->Cloud->size()); }
 
   private:
-    CloudTPtr Cloud;  ///< Raw uncompressed pointcloud.
+    CloudTConstPtr Cloud;  ///< Raw uncompressed shared pointcloud.
 };
 
 
@@ -171,8 +197,9 @@ struct OctreeCompressedPointCloud final : public PointCloudData<PointT>
 {
   using CloudT = pcl::PointCloud<PointT>;
   using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
 
-  OctreeCompressedPointCloud(CloudTPtr const& cloud)
+  OctreeCompressedPointCloud(CloudTConstPtr const& cloud)
   {
     #ifdef __linux__
       // DEBUG : Attach SIGFPE to exception
@@ -187,7 +214,7 @@ struct OctreeCompressedPointCloud final : public PointCloudData<PointT>
     this->SetCloud(cloud);
   }
 
-  void SetCloud(CloudTPtr const& cloud) override
+  void SetCloud(CloudTConstPtr const& cloud) override
   {
     // Octree compression
     pcl::io::OctreePointCloudCompression<PointT> compression(pcl::io::MANUAL_CONFIGURATION, false,
@@ -198,12 +225,17 @@ struct OctreeCompressedPointCloud final : public PointCloudData<PointT>
                                                              1,     // colorBitResolution
                                                              false  // doColorEncoding
                                                              );
-    compression.encodePointCloud(cloud, this->CompressedData);
+    std::stringstream compressedData;
+    compression.encodePointCloud(cloud, compressedData);
+    this->CompressedData = compressedData.str();
   }
 
-  CloudTPtr GetCloud() override
+  CloudTConstPtr GetCloud() override
   {
-    // Decode compressed pointcloud
+    // Decode compressed pointcloud from a local stream, as decoding moves its
+    // read position : the stored data is never modified, and may be decoded
+    // concurrently by several threads
+    std::istringstream compressedData(this->CompressedData);
     CloudTPtr cloud(new CloudT);
     pcl::io::OctreePointCloudCompression<PointT> compression;
     #ifdef __linux__
@@ -214,31 +246,25 @@ struct OctreeCompressedPointCloud final : public PointCloudData<PointT>
       // This workaround is necessary until ROS uses PCL > 1.10.0.99 (>= 8ed756fcfaf710cd5f3051704fdd8af7b0d4bf61)
       try
       {
-        compression.decodePointCloud(this->CompressedData, cloud);
+        compression.decodePointCloud(compressedData, cloud);
       }
       catch (const std::logic_error& e)
       {
         PRINT_ERROR("Decompression failed. Returning empty pointcloud.");
       }
     #else
-      compression.decodePointCloud(this->CompressedData, cloud);
+      compression.decodePointCloud(compressedData, cloud);
     #endif
-    // Set back compressed data read position to beginning (missing in OctreePointCloudCompression::decodePointCloud())
-    this->CompressedData.seekg(0, std::ios::beg);
     return cloud;
   }
 
   size_t GetMemorySize() override
   {
-    std::streampos current = this->CompressedData.tellp();
-    this->CompressedData.seekp(0, std::ios::end);
-    size_t size = this->CompressedData.tellp();
-    this->CompressedData.seekp(current, std::ios::beg);
-    return size;
+    return this->CompressedData.size();
   }
 
   private:
-    std::stringstream CompressedData;  ///< Binary compressed pointcloud data.
+    std::string CompressedData;  ///< Binary compressed pointcloud data.
 };
 #endif
 
@@ -251,12 +277,12 @@ struct PCDFilePointCloud final : public PointCloudData<PointT>
 {
   using CloudT = pcl::PointCloud<PointT>;
   using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
 
-  PCDFilePointCloud(CloudTPtr const& cloud, std::string const& pcdDirPath = "point_cloud_log/")
+  PCDFilePointCloud(CloudTConstPtr const& cloud, std::string const& pcdDirPath = "point_cloud_log/")
   {
     boost::filesystem::create_directory(pcdDirPath);
-    this->PCDFilePath = pcdDirPath + std::to_string(this->PCDFileIndex) + ".pcd";
-    this->PCDFileIndex++;
+    this->PCDFilePath = pcdDirPath + std::to_string(this->PCDFileIndex++) + ".pcd";
     this->SetCloud(cloud);
   }
 
@@ -274,13 +300,13 @@ struct PCDFilePointCloud final : public PointCloudData<PointT>
     // No need to decrement PCDFileIndex, it will be clearer for debug like that.
   }
 
-  void SetCloud(CloudTPtr const& cloud) override
+  void SetCloud(CloudTConstPtr const& cloud) override
   {
     if (savePointCloudToPCD(this->PCDFilePath, *cloud, pcdFormat) != 0)
       PRINT_ERROR("Failed to write binary PCD file to " << this->PCDFilePath);
   }
 
-  CloudTPtr GetCloud() override
+  CloudTConstPtr GetCloud() override
   {
     CloudTPtr cloud(new CloudT);
     if (pcl::io::loadPCDFile(this->PCDFilePath, *cloud) != 0)
@@ -295,12 +321,12 @@ struct PCDFilePointCloud final : public PointCloudData<PointT>
   }
 
   protected:
-    static unsigned int PCDFileIndex;  ///< The index of the PCD file currently being written.
-    std::string PCDFilePath;           ///< Path to PCD file.
+    static std::atomic<unsigned int> PCDFileIndex;  ///< The index of the PCD file currently being written.
+    std::string PCDFilePath;                        ///< Path to PCD file.
 };
 
 template<typename PointT, PCDFormat pcdFormat>
-unsigned int PCDFilePointCloud<PointT, pcdFormat>::PCDFileIndex = 0;
+std::atomic<unsigned int> PCDFilePointCloud<PointT, pcdFormat>::PCDFileIndex(0);
 
 template<typename PointT>
 using AsciiPCDFilePointCloud = PCDFilePointCloud<PointT, PCDFormat::ASCII>;
@@ -311,43 +337,627 @@ using BinaryPCDFilePointCloud = PCDFilePointCloud<PointT, PCDFormat::BINARY>;
 template<typename PointT>
 using BinaryCompressedPCDFilePointCloud = PCDFilePointCloud<PointT, PCDFormat::BINARY_COMPRESSED>;
 
+//------------------------------------------------------------------------------
+/*!
+ * @brief Append-only binary records store, saved in a single memory-mapped file.
+ *
+ * Each record is appended at the end of the file, preceded by a small header
+ * (record id and size), and located by an in-memory index of offsets. The
+ * file grows by doubling its capacity. When removed records represent more
+ * than half of the used file size, the file is compacted : remaining records
+ * are moved to the beginning of the file, keeping their order.
+ * The file name is unique, so that several stores (of different processes) can
+ * share the same directory. All methods are thread safe.
+ */
+class MappedFileStore
+{
+public:
+  //! Get the store instance of this process using the given directory, created on first call.
+  //! Each record owner should keep a pointer to the store, so that it outlives them.
+  static std::shared_ptr<MappedFileStore> GetInstance(std::string const& dirPath = "point_cloud_log/")
+  {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<MappedFileStore>> stores;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<MappedFileStore> store = stores[dirPath].lock();
+    if (!store)
+    {
+      store = std::make_shared<MappedFileStore>(dirPath);
+      stores[dirPath] = store;
+    }
+    return store;
+  }
+
+  MappedFileStore(std::string const& dirPath)
+  {
+    boost::filesystem::create_directory(dirPath);
+    this->FilePath = (boost::filesystem::path(dirPath) / boost::filesystem::unique_path("records-%%%%-%%%%-%%%%-%%%%.bin")).string();
+    std::ofstream(this->FilePath, std::ios::binary);
+  }
+
+  ~MappedFileStore()
+  {
+    this->Region.reset();
+    if (std::remove(this->FilePath.c_str()) != 0)
+      PRINT_WARNING("Unable to delete records file at " << this->FilePath);
+  }
+
+  //! Append a new record, and get its id.
+  //! Return false if the file could not be grown to store it.
+  bool Append(const void* data, size_t size, uint64_t& id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    size_t recordSize = RecordSize(size);
+    if (!this->Reserve(this->UsedSize + recordSize))
+      return false;
+    id = this->NextId++;
+    uint8_t* record = this->Base() + this->UsedSize;
+    RecordHeader header{id, size};
+    std::memcpy(record, &header, sizeof(RecordHeader));
+    std::memcpy(record + sizeof(RecordHeader), data, size);
+    this->Index[id] = this->UsedSize;
+    this->UsedSize += recordSize;
+    return true;
+  }
+
+  //! Size of the record data, 0 if it does not exist.
+  size_t Size(uint64_t id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto it = this->Index.find(id);
+    return it == this->Index.end() ? 0 : this->Header(it->second).Size;
+  }
+
+  //! Copy record data to the given buffer, which must be at least Size(id) long.
+  bool Read(uint64_t id, void* data)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto it = this->Index.find(id);
+    if (it == this->Index.end())
+      return false;
+    std::memcpy(data, this->Base() + it->second + sizeof(RecordHeader), this->Header(it->second).Size);
+    return true;
+  }
+
+  //! Remove a record, compacting the file if there is too much unused space.
+  void Remove(uint64_t id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto it = this->Index.find(id);
+    if (it == this->Index.end())
+      return;
+    this->RemovedSize += RecordSize(this->Header(it->second).Size);
+    this->Index.erase(it);
+    if (this->RemovedSize > this->UsedSize / 2)
+      this->Compact();
+  }
+
+  //! Size of the file that is actually used by records.
+  size_t UsedFileSize()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->UsedSize;
+  }
+
+private:
+  //! Header stored in file before each record data.
+  struct RecordHeader
+  {
+    uint64_t Id;
+    uint64_t Size;
+  };
+
+  // Records are 16 bytes aligned
+  static size_t RecordSize(size_t dataSize) { return (sizeof(RecordHeader) + dataSize + 15) & ~size_t(15); }
+
+  uint8_t* Base() { return static_cast<uint8_t*>(this->Region->get_address()); }
+
+  RecordHeader Header(size_t offset)
+  {
+    RecordHeader header;
+    std::memcpy(&header, this->Base() + offset, sizeof(RecordHeader));
+    return header;
+  }
+
+  // Grow file if needed to store requested size
+  bool Reserve(size_t size)
+  {
+    if (size <= this->Capacity)
+      return true;
+    size_t capacity = std::max(this->Capacity, MinCapacity());
+    while (capacity < size)
+      capacity *= 2;
+    return this->Resize(capacity);
+  }
+
+  // Resize file and remap it.
+  // The current mapping and records are kept until the new mapping is valid :
+  // if resizing fails, the store is left unchanged.
+  bool Resize(size_t capacity)
+  {
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    try
+    {
+      #ifdef _WIN32
+        // A mapped file can not be resized on Windows : the mapping must be released first
+        this->Region.reset();
+      #endif
+      // As the new file size is always larger than the used size, the
+      // previous mapping remains valid for the records until it is replaced
+      boost::filesystem::resize_file(this->FilePath, capacity);
+      boost::interprocess::file_mapping mapping(this->FilePath.c_str(), boost::interprocess::read_write);
+      region.reset(new boost::interprocess::mapped_region(mapping, boost::interprocess::read_write));
+    }
+    catch (const std::exception& e)
+    {
+      PRINT_ERROR("Failed to map records file " << this->FilePath << " (" << e.what() << ").");
+      #ifdef _WIN32
+        // Records are lost, as the previous mapping has been released
+        this->Index.clear();
+        this->Capacity = this->UsedSize = this->RemovedSize = 0;
+        return false;
+      #endif
+      // Restore the file size of the current mapping. If it fails, the file
+      // size is unknown : only the used part is known to be valid.
+      boost::system::error_code error;
+      boost::filesystem::resize_file(this->FilePath, this->Capacity, error);
+      if (error)
+        this->Capacity = this->UsedSize;
+      return false;
+    }
+    this->Region = std::move(region);
+    this->Capacity = capacity;
+    return true;
+  }
+
+  // Move remaining records to the beginning of the file.
+  // As compaction is only triggered when half of the used size has been
+  // removed, its cost is amortized over the removed records.
+  void Compact()
+  {
+    // Records only move towards the beginning of the file :
+    // they can be moved in place, following their order in file
+    std::map<size_t, uint64_t> offsetToId;
+    for (const auto& idOffset : this->Index)
+      offsetToId[idOffset.second] = idOffset.first;
+    size_t newSize = 0;
+    for (const auto& offsetId : offsetToId)
+    {
+      size_t recordSize = RecordSize(this->Header(offsetId.first).Size);
+      if (offsetId.first != newSize)
+        std::memmove(this->Base() + newSize, this->Base() + offsetId.first, recordSize);
+      this->Index[offsetId.second] = newSize;
+      newSize += recordSize;
+    }
+    this->UsedSize = newSize;
+    this->RemovedSize = 0;
+
+    // Release disk space if file is mostly empty
+    if (this->Capacity > MinCapacity() && 4 * this->UsedSize < this->Capacity)
+      this->Resize(std::max(this->Capacity / 2, MinCapacity()));
+  }
+
+  // Minimal file size (16 MiB)
+  static size_t MinCapacity() { return size_t(1) << 24; }
+
+  std::string FilePath;                                         ///< Path to the records file.
+  std::unique_ptr<boost::interprocess::mapped_region> Region;   ///< Current mapping of the whole file.
+  std::unordered_map<uint64_t, size_t> Index;                   ///< Offset in file of each record.
+  size_t Capacity = 0;                                          ///< Current file size.
+  size_t UsedSize = 0;                                          ///< End of the last record in file.
+  size_t RemovedSize = 0;                                       ///< Size of removed records in used part of file.
+  uint64_t NextId = 0;                                          ///< Id of the next record.
+  std::mutex Mutex;                                             ///< Protects all members.
+};
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Store PCL pointcloud points in the memory-mapped records file.
+ *
+ * Unlike PCD file storage, all pointclouds share the same file, and reading
+ * them back is only a copy from the mapping, without any parsing.
+ * The pointcloud header and dimensions are kept in RAM, next to the record id.
+ * The record is removed from the file when this object is destroyed.
+ * If the file can not store the pointcloud, it is kept uncompressed in RAM.
+ */
+template<typename PointT>
+struct MappedFilePointCloud final : public PointCloudData<PointT>
+{
+  using CloudT = pcl::PointCloud<PointT>;
+  using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
+
+  MappedFilePointCloud(CloudTConstPtr const& cloud, std::string const& dirPath = "point_cloud_log/")
+    : Store(MappedFileStore::GetInstance(dirPath))
+  {
+    this->SetCloud(cloud);
+  }
+
+  MappedFilePointCloud(const MappedFilePointCloud&) = delete;
+  MappedFilePointCloud& operator=(const MappedFilePointCloud&) = delete;
+
+  ~MappedFilePointCloud() override { this->Release(); }
+
+  void SetCloud(CloudTConstPtr const& cloud) override
+  {
+    this->Release();
+    this->Header = cloud->header;
+    this->Width = cloud->width;
+    this->Height = cloud->height;
+    this->IsDense = cloud->is_dense;
+    this->Stored = this->Store->Append(cloud->points.data(), sizeof(PointT) * cloud->size(), this->Id);
+    if (!this->Stored)
+    {
+      PRINT_WARNING("Records file writing failed. Keeping pointcloud in memory.");
+      this->Cloud = cloud;
+    }
+  }
+
+  CloudTConstPtr GetCloud() override
+  {
+    if (!this->Stored)
+      return this->Cloud;
+    CloudTPtr cloud(new CloudT);
+    cloud->resize(this->Store->Size(this->Id) / sizeof(PointT));
+    if (!cloud->empty() && !this->Store->Read(this->Id, cloud->points.data()))
+    {
+      PRINT_ERROR("Records file reading failed. Returning empty pointcloud.");
+      cloud->clear();
+    }
+    cloud->header = this->Header;
+    if (static_cast<size_t>(this->Width) * this->Height == cloud->size())
+    {
+      cloud->width = this->Width;
+      cloud->height = this->Height;
+    }
+    cloud->is_dense = this->IsDense;
+    return cloud;
+  }
+
+  // The points stored in file are not counted
+  size_t GetMemorySize() override
+  {
+    size_t size = sizeof(*this) + this->Header.frame_id.capacity();
+    if (!this->Stored)
+      size += sizeof(*this->Cloud) + (sizeof(PointT) * this->Cloud->size());
+    return size;
+  }
+
+  private:
+    void Release()
+    {
+      if (this->Stored)
+        this->Store->Remove(this->Id);
+      this->Stored = false;
+      this->Cloud.reset();
+    }
+
+    std::shared_ptr<MappedFileStore> Store;  ///< Records store, shared by all pointclouds.
+    uint64_t Id = 0;                         ///< Id of the record in store.
+    bool Stored = false;                     ///< Whether a record is currently stored.
+    CloudTConstPtr Cloud;                    ///< Pointcloud kept in RAM if it could not be stored.
+    pcl::PCLHeader Header;                   ///< Header of the stored pointcloud.
+    uint32_t Width = 0;                      ///< Width of the stored pointcloud.
+    uint32_t Height = 0;                     ///< Height of the stored pointcloud.
+    bool IsDense = true;                     ///< Whether the stored pointcloud is dense.
+};
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Compress LidarPoint pointcloud with the dedicated Codec, and store it as binary data in RAM.
+ *
+ * Unlike octree compression, all LidarPoint fields are kept : xyz and time are
+ * quantized according to codec parameters, other fields are stored losslessly.
+ */
+struct LidarCompressedPointCloud final : public PointCloudData<LidarPoint>
+{
+  using CloudT = pcl::PointCloud<LidarPoint>;
+  using CloudTPtr = CloudT::Ptr;
+  using CloudTConstPtr = CloudT::ConstPtr;
+
+  LidarCompressedPointCloud(CloudTConstPtr const& cloud, Codec::Parameters const& params)
+    : Params(params)
+  {
+    this->SetCloud(cloud);
+  }
+
+  void SetCloud(CloudTConstPtr const& cloud) override { this->CompressedData = Codec::Encode(*cloud, this->Params); }
+
+  CloudTConstPtr GetCloud() override
+  {
+    CloudTPtr cloud(new CloudT);
+    if (!Codec::Decode(this->CompressedData, *cloud, this->Params.NbThreads))
+      PRINT_ERROR("Decompression failed. Returning empty pointcloud.");
+    return cloud;
+  }
+
+  size_t GetMemorySize() override { return sizeof(*this) + this->CompressedData.capacity(); }
+
+  private:
+    Codec::Parameters Params;             ///< Codec parameters.
+    std::vector<uint8_t> CompressedData;  ///< Binary compressed data.
+};
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Create the LIDAR_COMPRESSED pointcloud data.
+ *
+ * The codec is dedicated to LidarPoint : other point types are stored uncompressed.
+ */
+template<typename PointT>
+PointCloudData<PointT>* CreateLidarCompressedPointCloud(typename pcl::PointCloud<PointT>::ConstPtr const& cloud,
+                                                        Codec::Parameters const& /*params*/)
+{
+  PRINT_WARNING("LIDAR_COMPRESSED storage is only available for LidarPoint. Storing uncompressed pointcloud.");
+  return new PCLPointCloud<PointT>(cloud);
+}
+
+template<>
+inline PointCloudData<LidarPoint>* CreateLidarCompressedPointCloud<LidarPoint>(pcl::PointCloud<LidarPoint>::ConstPtr const& cloud,
+                                                                               Codec::Parameters const& params)
+{
+  return new LidarCompressedPointCloud(cloud, params);
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Create the pointcloud data corresponding to the required storage type.
+ * @param[in] cloud The pointcloud to store.
+ * @param[in] storage The storage type to use.
+ * @param[in] codecParams The parameters to use for LIDAR_COMPRESSED storage.
+ * @return The new pointcloud data, or nullptr if storage type is unknown.
+ */
+template<typename PointT>
+PointCloudData<PointT>* CreatePointCloudData(typename pcl::PointCloud<PointT>::ConstPtr const& cloud,
+                                             PointCloudStorageType storage,
+                                             Codec::Parameters const& codecParams = Codec::Parameters())
+{
+  switch (storage)
+  {
+    case PCL_CLOUD:             return new PCLPointCloud<PointT>(cloud);
+    case OCTREE_COMPRESSED:     return new OctreeCompressedPointCloud<PointT>(cloud);
+    case PCD_ASCII:             return new AsciiPCDFilePointCloud<PointT>(cloud);
+    case PCD_BINARY:            return new BinaryPCDFilePointCloud<PointT>(cloud);
+    case PCD_BINARY_COMPRESSED: return new BinaryCompressedPCDFilePointCloud<PointT>(cloud);
+    case LIDAR_COMPRESSED:      return CreateLidarCompressedPointCloud<PointT>(cloud, codecParams);
+    case MAPPED_FILE:           return new MappedFilePointCloud<PointT>(cloud);
+    default:
+      PRINT_ERROR("Unkown PointCloudStorageType (" << storage << ").");
+      return nullptr;
+  }
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Single background thread processing storage jobs in FIFO order.
+ *
+ * It is shared by all asynchronous pointclouds storages, so that compression
+ * or disk writing is done out of the SLAM thread.
+ */
+class StorageWorker
+{
+public:
+  //! Get the unique worker instance, started on first call.
+  static StorageWorker& GetInstance()
+  {
+    static StorageWorker worker;
+    return worker;
+  }
+
+  ~StorageWorker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+    }
+    this->JobAdded.notify_one();
+    this->Thread.join();
+  }
+
+  //! Enqueue a new job to process.
+  void Push(std::function<void()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Jobs.push_back(std::move(job));
+    }
+    this->JobAdded.notify_one();
+  }
+
+  //! Block until all enqueued jobs have been processed.
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->JobsDone.wait(lock, [this]{ return this->Jobs.empty() && !this->Busy; });
+  }
+
+private:
+  StorageWorker() : Thread(&StorageWorker::Run, this) {}
+  StorageWorker(const StorageWorker&) = delete;
+  StorageWorker& operator=(const StorageWorker&) = delete;
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (true)
+    {
+      this->JobAdded.wait(lock, [this]{ return this->Stop || !this->Jobs.empty(); });
+      // Pending jobs are processed before stopping
+      if (this->Jobs.empty())
+        return;
+      std::function<void()> job = std::move(this->Jobs.front());
+      this->Jobs.pop_front();
+      this->Busy = true;
+      lock.unlock();
+      job();
+      lock.lock();
+      this->Busy = false;
+      if (this->Jobs.empty())
+        this->JobsDone.notify_all();
+    }
+  }
+
+  std::deque<std::function<void()>> Jobs;  ///< Jobs waiting to be processed.
+  std::mutex Mutex;                        ///< Protects Jobs, Busy and Stop.
+  std::condition_variable JobAdded;        ///< Notified when a job is added or when stopping.
+  std::condition_variable JobsDone;        ///< Notified when all jobs have been processed.
+  bool Busy = false;                       ///< True if a job is being processed.
+  bool Stop = false;                       ///< True if worker must stop.
+  std::thread Thread;                      ///< Background thread. Must be the last member, as it starts on construction.
+};
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Store pointcloud asynchronously, using another storage type.
+ *
+ * The input cloud is first kept as is, and the storage job (compression or
+ * writing to disk) is delegated to the background StorageWorker. Once done,
+ * the stored data replaces the raw cloud, which is released. GetCloud() stays
+ * valid at any time, returning the raw cloud while the job is pending.
+ */
+template<typename PointT>
+struct AsyncPointCloud final : public PointCloudData<PointT>
+{
+  using CloudT = pcl::PointCloud<PointT>;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
+
+  AsyncPointCloud(CloudTConstPtr const& cloud, PointCloudStorageType storage,
+                  Codec::Parameters const& codecParams = Codec::Parameters())
+    : Storage(storage)
+    , CodecParams(codecParams)
+  {
+    this->SetCloud(cloud);
+  }
+
+  ~AsyncPointCloud() override { this->Cancel(); }
+
+  void SetCloud(CloudTConstPtr const& cloud) override
+  {
+    // Cancel previous pending job, if any
+    this->Cancel();
+    this->State = std::make_shared<SharedState>();
+    this->State->Cloud = cloud;
+    // The job only holds the shared state : it may outlive this object
+    std::shared_ptr<SharedState> state = this->State;
+    PointCloudStorageType storage = this->Storage;
+    Codec::Parameters codecParams = this->CodecParams;
+    StorageWorker::GetInstance().Push([state, storage, codecParams]()
+    {
+      CloudTConstPtr cloud;
+      {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        if (state->Cancelled)
+          return;
+        cloud = state->Cloud;
+      }
+      std::unique_ptr<PointCloudData<PointT>> data(CreatePointCloudData<PointT>(cloud, storage, codecParams));
+      std::lock_guard<std::mutex> lock(state->Mutex);
+      // If storage failed, keep raw cloud
+      if (!data || state->Cancelled)
+        return;
+      state->Data = std::move(data);
+      state->Cloud.reset();
+    });
+  }
+
+  CloudTConstPtr GetCloud() override
+  {
+    PointCloudData<PointT>* data;
+    {
+      std::lock_guard<std::mutex> lock(this->State->Mutex);
+      if (!this->State->Data)
+        return this->State->Cloud;
+      data = this->State->Data.get();
+    }
+    // Stored data is never modified once set, and storages decode it without
+    // changing any shared state (local streams or files, records store locked
+    // internally) : it can be decoded without lock, by several threads at once
+    return data->GetCloud();
+  }
+
+  size_t GetMemorySize() override
+  {
+    std::lock_guard<std::mutex> lock(this->State->Mutex);
+    if (this->State->Data)
+      return this->State->Data->GetMemorySize();
+    return sizeof(*this->State->Cloud) + (sizeof(PointT) * this->State->Cloud->size());
+  }
+
+  //! Check if the storage job is done.
+  bool IsStored()
+  {
+    std::lock_guard<std::mutex> lock(this->State->Mutex);
+    return static_cast<bool>(this->State->Data);
+  }
+
+  private:
+    //! Data shared with the background job.
+    struct SharedState
+    {
+      std::mutex Mutex;                              ///< Protects all below members.
+      CloudTConstPtr Cloud;                          ///< Raw cloud, released once stored.
+      std::unique_ptr<PointCloudData<PointT>> Data;  ///< Stored data, set once job is done.
+      bool Cancelled = false;                        ///< True if the result is not needed anymore.
+    };
+
+    void Cancel()
+    {
+      if (!this->State)
+        return;
+      std::lock_guard<std::mutex> lock(this->State->Mutex);
+      this->State->Cancelled = true;
+    }
+
+    PointCloudStorageType Storage;       ///< Storage type to use in background.
+    Codec::Parameters CodecParams;       ///< Parameters for LIDAR_COMPRESSED storage.
+    std::shared_ptr<SharedState> State;  ///< Current cloud state.
+};
+
 //------------------------------------------------------------------------------
 /*!
  * @brief Structure used to log pointclouds either under uncompressed/compressed format.
+ *
+ * The input cloud is adopted as a shared immutable cloud : with PCL_CLOUD
+ * storage, no copy is done and the cloud must not be modified afterwards.
+ * If async is enabled, the storage (compression or disk writing) is done by a
+ * background thread, and the cloud is kept as is until this job is done.
  */
 template<typename PointT>
 struct PointCloudStorage
 {
   using CloudT = pcl::PointCloud<PointT>;
-  using CloudTPtr = typename CloudT::Ptr;
+  using CloudTConstPtr = typename CloudT::ConstPtr;
 
-  PointCloudStorage(CloudTPtr const& cloud, PointCloudStorageType storage) { this->SetCloud(cloud, storage); }
+  PointCloudStorage(CloudTConstPtr const& cloud, PointCloudStorageType storage, bool async = false,
+                    Codec::Parameters const& codecParams = Codec::Parameters())
+  {
+    this->SetCloud(cloud, storage, async, codecParams);
+  }
 
   inline PointCloudStorageType StorageType() const { return this->Storage; }
+  inline bool IsAsync() const { return this->Async; }
   inline size_t PointsSize() const { return this->Points; }
   inline size_t MemorySize() const { return this->Data->GetMemorySize(); }
 
-  void SetCloud(CloudTPtr const& cloud, PointCloudStorageType storage)
+  void SetCloud(CloudTConstPtr const& cloud, PointCloudStorageType storage, bool async = false,
+                Codec::Parameters const& codecParams = Codec::Parameters())
   {
     this->Storage = storage;
     this->Points = cloud->size();
-    switch (storage)
-    {
-      case PCL_CLOUD:             this->Data.reset(new PCLPointCloud<PointT>(cloud));                     break;
-      case OCTREE_COMPRESSED:     this->Data.reset(new OctreeCompressedPointCloud<PointT>(cloud));        break;
-      case PCD_ASCII:             this->Data.reset(new AsciiPCDFilePointCloud<PointT>(cloud));            break;
-      case PCD_BINARY:            this->Data.reset(new BinaryPCDFilePointCloud<PointT>(cloud));           break;
-      case PCD_BINARY_COMPRESSED: this->Data.reset(new BinaryCompressedPCDFilePointCloud<PointT>(cloud)); break;
-      default:
-        PRINT_ERROR("Unkown PointCloudStorageType (" << storage << ")."); break;
-    }
+    // Storing a PCL pointcloud is free : no need for a background job
+    this->Async = async && storage != PCL_CLOUD;
+    if (this->Async)
+      this->Data.reset(new AsyncPointCloud<PointT>(cloud, storage, codecParams));
+    else
+      this->Data.reset(CreatePointCloudData<PointT>(cloud, storage, codecParams));
   }
 
-  CloudTPtr GetCloud() const { return this->Data->GetCloud(); }
+  CloudTConstPtr GetCloud() const { return this->Data->GetCloud(); }
 
   private:
     size_t Points;                                 ///< Number of points in stored pointcloud.
     PointCloudStorageType Storage;                 ///< How is stored pointcloud data.
+    bool Async = false;                            ///< Whether storage is done in background.
     std::unique_ptr<PointCloudData<PointT>> Data;  ///< Pointcloud data.
 };
 
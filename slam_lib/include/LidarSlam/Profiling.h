@@ -0,0 +1,169 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace LidarSlam
+{
+namespace Profiling
+{
+
+//------------------------------------------------------------------------------
+//! SLAM processing stages whose latency is recorded
+enum Stage
+{
+  FRAME = 0,              ///< whole frame processing (AddFrames)
+  KEYPOINTS_EXTRACTION,   ///< keypoints extraction
+  EGO_MOTION,             ///< whole ego-motion step
+  EGO_MOTION_ICP_LM,      ///< ego-motion ICP-LM registration loop
+  LOCALIZATION,           ///< whole localization step
+  LOCALIZATION_ICP_LM,    ///< localization ICP-LM registration loop
+  CONFIDENCE,             ///< confidence estimators computation
+  MAPS_UPDATE,            ///< keypoints maps update
+  LOGGING,                ///< current frame state logging
+  nStages
+};
+
+static const std::map<Stage, std::string> StageNames = {
+  {FRAME, "frame"},
+  {KEYPOINTS_EXTRACTION, "keypoints_extraction"},
+  {EGO_MOTION, "ego_motion"},
+  {EGO_MOTION_ICP_LM, "ego_motion_icp_lm"},
+  {LOCALIZATION, "localization"},
+  {LOCALIZATION_ICP_LM, "localization_icp_lm"},
+  {CONFIDENCE, "confidence"},
+  {MAPS_UPDATE, "maps_update"},
+  {LOGGING, "logging"}
+};
+
+//------------------------------------------------------------------------------
+//! Latency statistics of a stage, in milliseconds
+struct Statistics
+{
+  uint64_t Count = 0;  ///< Number of recorded durations
+  double Mean = 0.;    ///< Mean duration
+  double P50 = 0.;     ///< Median duration
+  double P95 = 0.;     ///< 95th percentile duration
+  double P99 = 0.;     ///< 99th percentile duration
+  double Max = 0.;     ///< Max duration
+};
+
+/**
+ * @brief Thread-safe latency histogram, with bounded relative error.
+ *
+ * As in HdrHistogram, the durations are stored with a microsecond resolution in
+ * log-linear buckets : each power of 2 range is split into linear sub-buckets.
+ * The percentiles relative error is therefore bounded (~3%), whatever the
+ * duration, with a fixed memory footprint.
+ * Recording is lock-free and can be done concurrently from several threads.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram() { this->Reset(); }
+
+  //! Record a duration, in seconds
+  void Record(double duration);
+
+  //! Remove all recorded durations
+  void Reset();
+
+  //! Get the statistics of the recorded durations
+  Statistics GetStatistics() const;
+
+private:
+  // Number of linear sub-buckets of each power of 2 range is 2^(SubBucketBits-1)
+  static constexpr int SubBucketBits = 6;
+  static constexpr uint64_t SubBucketHalfCount = 1u << (SubBucketBits - 1);
+  // [µs] Max recordable duration is 2^MaxValueBits µs (~12 days)
+  static constexpr int MaxValueBits = 40;
+  static constexpr int NbBuckets = (MaxValueBits - SubBucketBits + 2) * SubBucketHalfCount;
+
+  // Bucket index of a value, and value range of a bucket
+  static int BucketIndex(uint64_t value);
+  static uint64_t BucketUpperBound(int index);
+
+  // Value of the given percentile (between 0 and 1), in µs
+  uint64_t Percentile(double percentile, uint64_t count) const;
+
+  std::array<std::atomic<uint64_t>, NbBuckets> Counts;
+  std::atomic<uint64_t> Count;
+  std::atomic<uint64_t> Sum;
+  std::atomic<uint64_t> Max;
+};
+
+/**
+ * @brief Latency histograms of all SLAM processing stages.
+ *
+ * Each Slam instance owns its profiler, so that several instances can coexist.
+ */
+class Profiler
+{
+public:
+  //! Record the duration (in seconds) of a stage
+  void Record(Stage stage, double duration) { this->Histograms[stage].Record(duration); }
+
+  //! Remove all recorded durations
+  void Reset();
+
+  //! Get the latency statistics of a stage
+  Statistics GetStatistics(Stage stage) const { return this->Histograms[stage].GetStatistics(); }
+
+  //! Get the latency statistics of all stages, with their name
+  //! Stages that have never been recorded are skipped
+  std::map<std::string, Statistics> GetStatistics() const;
+
+private:
+  std::array<LatencyHistogram, nStages> Histograms;
+};
+
+/**
+ * @brief Timer recording the duration of its scope in a profiler stage.
+ */
+class ScopedTimer
+{
+public:
+  ScopedTimer(Profiler& profiler, Stage stage)
+    : Timings(profiler)
+    , TimedStage(stage)
+    , Start(std::chrono::steady_clock::now())
+  {}
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - this->Start;
+    this->Timings.Record(this->TimedStage, duration.count());
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  Profiler& Timings;
+  Stage TimedStage;
+  std::chrono::steady_clock::time_point Start;
+};
+
+} // end of Profiling namespace
+} // end of LidarSlam namespace
@@ -22,7 +22,11 @@
 #include "LidarSlam/Enums.h"
 #include "LidarSlam/LidarPoint.h"
 #include "LidarSlam/KDTreePCLAdaptor.h"
+#include "LidarSlam/MapFile.h"
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
 #define SetMacro(name,type) void Set##name (type _arg) { name = _arg; }
 #define GetMacro(name,type) type Get##name () const { return name; }
@@ -75,6 +79,23 @@ public:
   using SamplingVG = std::unordered_map<int, Voxel>;
   using RollingVG  = std::unordered_map<int, SamplingVG>;
 
+  //! Function called with the global coordinates and the inner voxels of an outer voxel
+  using VoxelCallback = std::function<void(const Eigen::Array3i&, const SamplingVG&)>;
+
+  // Outer voxels of the grid modified since the last call to TakeChanges
+  struct Changes
+  {
+    //! True if Voxels holds all non empty outer voxels of the grid,
+    //! false if it only holds the modified ones
+    bool Full = false;
+    //! [m] Width of the outer voxels
+    double VoxelWidth = 0.;
+    //! Global coordinates and current points of the outer voxels.
+    //! The outer voxel (i, j, k) is centered on (i, j, k) * VoxelWidth.
+    //! No points means that the voxel has been emptied or has left the grid.
+    std::vector<std::pair<Eigen::Array3i, PointCloud::Ptr>> Voxels;
+  };
+
   //============================================================================
   //   Initialization and parameters setters
   //============================================================================
@@ -88,6 +109,18 @@ public:
   //! Remove all points from all voxels and clear the submap KD-tree
   void Clear();
 
+  //! Copy the parameters of another grid (sizes, resolutions, sampling mode,
+  //! moving objects and decaying thresholds), without its points.
+  void CopyParameters(const RollingGrid& other);
+
+  //! Replace the points and position of the grid by a copy of another grid ones.
+  //! Both grids must have the same parameters. The sub-map KD-tree is cleared.
+  void CopyPoints(const RollingGrid& other);
+
+  //! Exchange the points and position of the grid with another grid ones, without any copy.
+  //! Both grids must have the same parameters. Their sub-map KD-trees are cleared.
+  void SwapPoints(RollingGrid& other);
+
   //! Set grid size (number of voxels in each direction)
   //! NOTE: this may remove some points from the grid if size is decreased
   //! The sub-map KD-tree is cleared during the process.
@@ -128,11 +161,115 @@ public:
   //! Roll the grid so that input bounding box can fit it in rolled map
   void Roll(const Eigen::Array3f& minPoint, const Eigen::Array3f& maxPoint);
 
+  //! Set a function called with each non empty outer voxel leaving the grid
+  //! when it is rolled, before its points are dropped.
+  //! This allows to keep the whole map out of core (see SaveVoxels).
+  void SetRollOutCallback(const VoxelCallback& callback) { this->RollOutCallback = callback; }
+
   //! Add some points to the grid.
   //! If fixed is true, the points added will not be modified afterwards.
   //! If roll is true, the map is rolled first so that all new points to add can fit in rolled map.
   //! If points are added, the sub-map KD-tree is cleared.
-  void Add(const PointCloud::Ptr& pointcloud, bool fixed = false, bool roll = true);
+  //! If validatedPoints is set, the points of the inner voxels which have just
+  //! been seen in more than MinFramesPerVoxel frames (i.e. which are now
+  //! extracted by Get(true)) are appended to it.
+  void Add(const PointCloud::Ptr& pointcloud, bool fixed = false, bool roll = true, PointCloud* validatedPoints = nullptr);
+
+  //! Check if the voxel (of leaf size) containing a point holds a map point
+  bool IsOccupied(const Eigen::Array3f& position) const;
+
+  //! Add several pointclouds to the grid, using nbThreads threads.
+  //! The outer voxels are split between threads, each thread adding all
+  //! pointclouds in the given order to its own voxels : the result is the same
+  //! as adding the pointclouds sequentially, whatever the number of threads.
+  //! With CENTROID sampling, voxels can not be split and a single thread is used.
+  //! If roll is true, the pointclouds are split in consecutive groups whose
+  //! bounding box fits in the grid, and the map is rolled onto each group before
+  //! adding it : the map follows the pointclouds and ends up around the last ones.
+  //! If points are added, the sub-map KD-tree is cleared.
+  void Add(const std::vector<PointCloud::ConstPtr>& pointclouds, bool fixed = false, int nbThreads = 1, bool roll = true);
+
+  //============================================================================
+  //   Native map file
+  //============================================================================
+
+  //! Save all voxels (points and counts) to a native map file (see MapFile).
+  //! Return false if the file could not be written.
+  bool Save(const std::string& path) const;
+
+  //! Save some outer voxels, given by their global coordinates, to a native
+  //! map file with the layout of this grid (leaf size and outer voxel width).
+  //! Return false if the file could not be written.
+  bool SaveVoxels(const std::string& path, const std::vector<std::pair<Eigen::Array3i, const SamplingVG*>>& voxels) const;
+
+  //! Load a native map file saved with Save().
+  //! As when adding points, the map is first rolled to fit the saved map
+  //! bounding box, and only the outer voxels lying in the grid are read.
+  //! If the grid is empty and has the same leaf size and outer voxel width as
+  //! the saved map, voxels are copied as is (keeping their counts). Otherwise,
+  //! the saved points are added to the grid as a new pointcloud.
+  //! If fixed is true, the loaded points will not be modified afterwards.
+  //! Return false if the file could not be read.
+  bool Load(const std::string& path, bool fixed = false);
+
+  //============================================================================
+  //   Out-of-core map paging
+  //============================================================================
+
+  //! Page a fixed map from a native map file, instead of loading it at once.
+  //! The outer voxels of the map are used as tiles : only the tiles around the
+  //! current position are kept in the grid (see UpdatePaging), and the tiles
+  //! ahead of the sensor are loaded asynchronously by a background thread.
+  //! The grid is cleared, and the saved map must have the same leaf size and
+  //! outer voxel width as the grid.
+  //! The paged map should not be modified afterwards, as the evicted tiles are
+  //! read back from the file.
+  //! Return false if the file could not be read or has a different layout.
+  bool EnablePaging(const std::string& path, bool fixed = true);
+
+  //! Stop paging, keeping the currently loaded tiles
+  void DisablePaging();
+
+  //! Check if the map is paged from a map file
+  bool IsPaging() const { return this->Paging != nullptr; }
+
+  //! [m] Half size of the area around the current position whose tiles must be loaded
+  SetMacro(PagingRadius, double)
+  GetMacro(PagingRadius, double)
+
+  //! [s] Tiles around the position predicted after this duration are prefetched
+  SetMacro(PagingLookAhead, double)
+  GetMacro(PagingLookAhead, double)
+
+  //! Max number of points to keep in the grid : the farthest tiles are evicted first.
+  //! The tiles around the current position are always kept.
+  SetMacro(PagingMaxPoints, unsigned int)
+  GetMacro(PagingMaxPoints, unsigned int)
+
+  //! Update the loaded tiles for the given position and velocity :
+  //!  - roll the grid around the current and predicted positions,
+  //!  - add the tiles loaded in background, and load synchronously the missing
+  //!    tiles around the current position,
+  //!  - request the tiles around the predicted position to the background thread,
+  //!  - evict the farthest tiles if the grid holds more than PagingMaxPoints points.
+  //! The sub-map KD-tree is only cleared if the tiles around the current
+  //! position have changed : the prefetched tiles do not trigger a rebuild.
+  //! Return true if the loaded tiles have changed.
+  bool UpdatePaging(const Eigen::Vector3f& position, const Eigen::Vector3f& velocity = Eigen::Vector3f::Zero());
+
+  //============================================================================
+  //   Changes tracking
+  //============================================================================
+
+  //! Record the outer voxels modified by any operation, to be able to get the
+  //! map incrementally (see TakeChanges)
+  void SetTrackChanges(bool track);
+  GetMacro(TrackChanges, bool)
+
+  //! Get the outer voxels modified since the last call, and forget them.
+  //! If all is true, if changes are not tracked or if the grid has been
+  //! cleared since last call, all non empty outer voxels are returned instead.
+  Changes TakeChanges(bool all = false);
 
   //============================================================================
   //   Sub map use
@@ -140,6 +277,7 @@ public:
 
   //! Build a KD-tree from all points in the map
   //! This KD-tree can then be used for fast NN queries in the whole map.
+  //! If the map is paged, only the tiles around the current position are used.
   void BuildSubMapKdTree();
   //! Build a KD-tree from the points laying in the input bounding box
   //! This KD-tree can then be used for fast NN queries.
@@ -217,8 +355,62 @@ private:
   //! If negative, the keypoints are never removed
   double DecayingThreshold = -1;
 
+  //! Map file paging state and background tiles loader (see EnablePaging)
+  struct Pager;
+  std::shared_ptr<Pager> Paging;
+
+  //! [m] Half size of the area around the current position whose tiles must be loaded
+  double PagingRadius = 60.;
+
+  //! [s] Duration used to predict the position whose surrounding tiles are prefetched
+  double PagingLookAhead = 3.;
+
+  //! Max number of points to keep in the grid when paging
+  unsigned int PagingMaxPoints = 2000000;
+
+  //! Function called with the outer voxels leaving the grid when it is rolled
+  VoxelCallback RollOutCallback;
+
+  //! Record the outer voxels modified since the last call to TakeChanges
+  bool TrackChanges = false;
+
+  //! Packed global coordinates of the outer voxels modified since the last call to TakeChanges
+  std::unordered_set<uint64_t> ModifiedVoxels;
+
+  //! True if the grid has been cleared since the last call to TakeChanges
+  bool ChangesReset = true;
+
 private:
 
+  using CloudsIterator = std::vector<PointCloud::ConstPtr>::const_iterator;
+
+  //! Add the pointclouds [begin, end) in order without rolling the map,
+  //! splitting the outer voxels between nbThreads threads : the points are
+  //! first split by outer voxel owner, then each thread adds its own points.
+  //! With CENTROID sampling, a single thread is used.
+  void AddInParallel(CloudsIterator begin, CloudsIterator end, bool fixed, int nbThreads);
+
+  //! Add some points to the given voxels, counting the new voxels in nbPoints.
+  //! If indices is set, only the points of pointcloud with these indices are added.
+  //! If updatedVoxels is set, the 1D indices of the outer voxels whose points have been updated are inserted in it.
+  //! If validatedVoxels is set, the 1D indices (outer, inner) of the inner voxels whose count has
+  //! just exceeded MinFramesPerVoxel are appended to it.
+  //! Return true if some voxel points have been updated.
+  bool AddPoints(const PointCloud& pointcloud, bool fixed, RollingVG& voxels, unsigned int& nbPoints,
+                 const std::vector<int>* indices = nullptr, std::unordered_set<int>* updatedVoxels = nullptr,
+                 std::vector<std::pair<int, int>>* validatedVoxels = nullptr) const;
+
+  //! Record an outer voxel of the grid as modified, if changes are tracked
+  void SetModified(int voxelId1d);
+
+  //! Read the inner voxels of an outer voxel from a map file
+  //! If fixed is true, the points are labelled as fixed.
+  static SamplingVG ReadVoxel(const MapFile& mapFile, const MapFile::VoxelRecord& voxel, bool fixed);
+
+  //! Global coordinates of the outer voxel (0, 0, 0) of the grid
+  //! The outer voxel of global coordinates (i, j, k) is centered on (i, j, k) * VoxelWidth
+  Eigen::Array3i GetVoxelGridOriginCoords() const;
+
   //! Conversion from 3D voxel index to 1D flattened index
   int To1d(const Eigen::Array3i& voxelId3d, int gridSize) const;
 
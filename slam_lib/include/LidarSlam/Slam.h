@@ -79,19 +79,26 @@
 #include "LidarSlam/SpinningSensorKeypointExtractor.h"
 #include "LidarSlam/KeypointsMatcher.h"
 #include "LidarSlam/LocalOptimizer.h"
+#include "LidarSlam/LoopClosureDetector.h"
 #include "LidarSlam/RollingGrid.h"
 #include "LidarSlam/PointCloudStorage.h"
+#include "LidarSlam/Profiling.h"
 #include "LidarSlam/ExternalSensorManagers.h"
 #include "LidarSlam/State.h"
 
 #include <Eigen/Geometry>
 
+#include <future>
 #include <list>
 
 #ifdef USE_G2O
 #include "LidarSlam/PoseGraphOptimizer.h"
 #endif  // USE_G2O
 
+#ifdef USE_GTSAM
+#include "LidarSlam/IncrementalPoseGraph.h"
+#endif  // USE_GTSAM
+
 #define SetMacro(name,type) void Set##name (type _arg) { name = _arg; }
 #define GetMacro(name,type) type Get##name () const { return name; }
 
@@ -176,6 +183,8 @@ public:
 
   // Initialization
   Slam();
+  // Wait for background processes
+  ~Slam();
   // Reset internal state : maps and trajectory are cleared,
   // current pose is set back to origin and the external sensor data are emptied.
   // This keeps parameters unchanged.
@@ -226,6 +235,9 @@ public:
 
   // Get current registered (and optionally undistorted) input points.
   // All frames from all devices are aggregated.
+  // If input downsampling is enabled, the downsampled frames are used.
+  // NOTE: The registered frame is lazily computed on first call for the
+  // current frame, then cached. The returned cloud is never modified afterwards.
   PointCloud::Ptr GetRegisteredFrame();
 
   // Get current number of frames already processed
@@ -236,6 +248,12 @@ public:
   // Get information for each keypoint of the current frame (used/rejected keypoints, ...)
   std::unordered_map<std::string, std::vector<double>> GetDebugArray() const;
 
+  // Get the latency statistics (in ms) of each processing stage, since the last reset.
+  // These are recorded whatever the verbosity level.
+  std::map<std::string, Profiling::Statistics> GetTimingStatistics() const { return this->Timings.GetStatistics(); }
+  // Reset the latency statistics (also done when resetting the log)
+  void ResetTimingStatistics() { this->Timings.Reset(); }
+
   // Update LocalMaps from the beginning of the LogStates
   // By default, clear points in maps after the first timestamp in the LogStates
   // and replace them by the keypoints stored in the LogStates
@@ -244,8 +262,32 @@ public:
 
   // Optimize graph containing lidar states with
   // landmarks' constraints as a postprocess
+  // If IncrementalGraph is enabled, the graph is kept between calls and only
+  // the states and constraints added since the previous call are processed.
+  // Only the states whose optimized pose changed are then updated, and the
+  // states which are not logged anymore are marginalized out of the graph.
   bool OptimizeGraph();
 
+  // Optimize graph in a background thread, frames processing continuing meanwhile.
+  // External constraints and loop closure detection are gathered on the calling
+  // thread, then the loop closure registration, the graph optimization and
+  // the maps rebuild are performed in background on a snapshot of the logged states.
+  // The results are applied at the beginning of the next processed frame :
+  // the states logged since the snapshot are corrected with the correction of
+  // the last optimized state, and only their keypoints are added to the rebuilt maps.
+  // It returns false if the optimization could not be started.
+  bool OptimizeGraphAsync();
+
+  // Check if a background graph optimization is running or waiting to be applied
+  bool IsGraphOptimizationPending() const;
+
+  // Wait for the background graph optimization to end and apply its results.
+  // It returns false if no optimization was pending or if it failed.
+  bool WaitGraphOptimization();
+
+  // Check if the last background graph optimization succeeded and its results were applied
+  bool GetLastGraphOptimizationSuccess() const { return this->LastGraphOptimizationSuccess; }
+
   // Use IMU measurements and optimized poses (using IMU + Lidar SLAM)
   // to update LogStates, maps and the current pose
   bool UpdateTrajectoryAndMapsWithIMU();
@@ -272,6 +314,17 @@ public:
   // Load keypoints maps from disk (and reset SLAM maps)
   void LoadMapsFromPCD(const std::string& filePrefix, bool resetMaps = true);
 
+  // Save keypoints maps to native map files (see MapFile), keeping the voxels
+  // layout and counts. Keypoints maps are rebuilt as in SaveMapsToPCD.
+  void SaveMapsToMapFile(const std::string& filePrefix);
+
+  // Load keypoints maps from native map files (and reset SLAM maps)
+  // Files are memory-mapped : only the parts of the maps fitting in the
+  // rolling grids are read from disk, which is much faster than PCD loading.
+  // If MapPaging is enabled and MapUpdate is NONE, the maps are paged by tiles
+  // around the current pose during localization instead.
+  void LoadMapsFromMapFile(const std::string& filePrefix, bool resetMaps = true);
+
   // Reset trajectory pose in LogStates
   void ResetStatePoses(ExternalSensors::PoseManager& newTrajectoryManager);
 
@@ -300,6 +353,14 @@ public:
   SetMacro(LoggingStorage, PointCloudStorageType)
   GetMacro(LoggingStorage, PointCloudStorageType)
 
+  SetMacro(LoggingAsync, bool)
+  GetMacro(LoggingAsync, bool)
+
+  // Quantization step (in meters) of keypoints coordinates with LIDAR_COMPRESSED storage.
+  // It must be positive, otherwise it is ignored.
+  void SetLoggingPrecision(double precision);
+  double GetLoggingPrecision() const { return this->LoggingCodecParams.PositionPrecision; }
+
   SetMacro(LogOnlyKeyframes, bool)
   GetMacro(LogOnlyKeyframes, bool)
 
@@ -329,6 +390,19 @@ public:
   GetMacro(NbGraphIterations, int)
   SetMacro(NbGraphIterations, int)
 
+  // Use the incremental pose graph (requires GTSAM) : changing it resets the graph
+  GetMacro(IncrementalGraph, bool)
+  void SetIncrementalGraph(bool incremental);
+
+  GetMacro(GraphKeyframesOnly, bool)
+  SetMacro(GraphKeyframesOnly, bool)
+
+  GetMacro(MapUpdateDistanceThreshold, double)
+  SetMacro(MapUpdateDistanceThreshold, double)
+
+  GetMacro(MapUpdateAngleThreshold, double)
+  SetMacro(MapUpdateAngleThreshold, double)
+
   PGOConstraintSetMacro(LOOP_CLOSURE, bool)
   PGOConstraintGetMacro(LOOP_CLOSURE, bool)
 
@@ -348,6 +422,18 @@ public:
   SetMacro(WorldFrameId, std::string const&)
   GetMacro(WorldFrameId, std::string)
 
+  // ---------------------------------------------------------------------------
+  //   Input frames preprocessing
+  // ---------------------------------------------------------------------------
+
+  // [m] Leaf size of the voxel downsampling applied once to the input frames.
+  // The downsampled frames are used by the consumers which do not need full
+  // resolution (registered frame, overlap estimation, camera constraint), while
+  // keypoints are still extracted from the raw frames.
+  // If not positive (default), input frames are not downsampled.
+  GetMacro(InputDownsamplingLeafSize, double)
+  SetMacro(InputDownsamplingLeafSize, double)
+
   // ---------------------------------------------------------------------------
   //   Keypoints extraction
   // ---------------------------------------------------------------------------
@@ -608,6 +694,24 @@ public:
   void SetVoxelGridResolution(double resolution);
   void SetVoxelGridMinFramesPerVoxel(unsigned int minFrames);
 
+  // Out-of-core maps paging parameters (see RollingGrid::EnablePaging)
+  // They must be set before loading the maps.
+  GetMacro(MapPaging, bool)
+  SetMacro(MapPaging, bool)
+  double GetMapPagingRadius() const;
+  void SetMapPagingRadius(double radius);
+  double GetMapPagingLookAhead() const;
+  void SetMapPagingLookAhead(double duration);
+  unsigned int GetMapPagingMaxPoints() const;
+  void SetMapPagingMaxPoints(unsigned int maxPoints);
+
+  // Incremental maps extraction (see RollingGrid::TakeChanges)
+  // If enabled, the outer voxels of the maps modified since last call to
+  // GetMapChanges are recorded.
+  bool GetMapChangesTracking() const;
+  void SetMapChangesTracking(bool track);
+  RollingGrid::Changes GetMapChanges(Keypoint k, bool all = false);
+
   // ---------------------------------------------------------------------------
   //   Loop Closure parameters
   // ---------------------------------------------------------------------------
@@ -632,6 +736,20 @@ public:
   GetMacro(LCRevisitedWindowEndRange, int)
   SetMacro(LCRevisitedWindowEndRange, int)
 
+  // Get/Set automatic loop closure detection parameters
+  // (used if ExtDetectLoopClosure is disabled)
+  unsigned int GetLoopDetectionNbCandidates() const { return this->LoopDetector.GetNbCandidates(); }
+  void SetLoopDetectionNbCandidates(unsigned int nb) { this->LoopDetector.SetNbCandidates(nb); }
+
+  unsigned int GetLoopDetectionMinIndexGap() const { return this->LoopDetector.GetMinIndexGap(); }
+  void SetLoopDetectionMinIndexGap(unsigned int gap) { this->LoopDetector.SetMinIndexGap(gap); }
+
+  double GetLoopDetectionMaxDistance() const { return this->LoopDetector.GetMaxDistance(); }
+  void SetLoopDetectionMaxDistance(double dist) { this->LoopDetector.SetMaxDistance(dist); }
+
+  double GetLoopDetectionMaxRadius() const { return this->LoopDetector.GetMaxRadius(); }
+  void SetLoopDetectionMaxRadius(double radius) { this->LoopDetector.SetMaxRadius(radius); }
+
   // Get/Set Loop Closure registration parameters
   GetMacro(EnableLoopClosureOffset, bool)
   SetMacro(EnableLoopClosureOffset, bool)
@@ -682,6 +800,9 @@ public:
   GetMacro(OverlapSamplingRatio, float)
   void SetOverlapSamplingRatio(float _arg);
 
+  GetMacro(OverlapEstimator, OverlapMode)
+  SetMacro(OverlapEstimator, OverlapMode)
+
   GetMacro(OverlapEstimation, float)
 
   // Matches
@@ -742,6 +863,15 @@ private:
   // This reduces about 5 times the memory consumption, but slows down logging (and PGO).
   PointCloudStorageType LoggingStorage = PointCloudStorageType::PCL_CLOUD;
 
+  // Wether to compress/write logged keypoints in a background thread.
+  // The keypoints are kept uncompressed in RAM until this is done,
+  // removing the logging overhead from the SLAM thread.
+  bool LoggingAsync = false;
+
+  // Parameters of the LIDAR_COMPRESSED storage codec.
+  // The number of threads to use for encoding/decoding follows NbThreads.
+  Codec::Parameters LoggingCodecParams;
+
   bool LogOnlyKeyframes = true;
 
   // Number of frames that have been processed by SLAM (number of poses in trajectory)
@@ -819,7 +949,15 @@ private:
   // Current frames (all raw input frames)
   std::vector<PointCloud::Ptr> CurrentFrames;
 
+  // Current frames, downsampled with InputDownsamplingLeafSize.
+  // If input downsampling is disabled, these are the raw input frames.
+  std::vector<PointCloud::Ptr> CurrentDownsampledFrames;
+
+  // [m] Leaf size of the voxel downsampling applied to the input frames
+  double InputDownsamplingLeafSize = 0.;
+
   // Current aggregated points from all input frames, in WORLD coordinates (with undistortion if enabled)
+  // Lazily computed by GetRegisteredFrame(), null until first requested for the current frame
   PointCloud::Ptr RegisteredFrame;
 
   // Raw extracted keypoints, in BASE coordinates (no undistortion)
@@ -851,6 +989,11 @@ private:
   // from current scanned points depending on the initial map reliability.
   MappingMode MapUpdate = MappingMode::UPDATE;
 
+  // Page the maps loaded from native map files by tiles instead of loading them at once.
+  // This is only used in MappingMode::NONE : only the tiles around the current
+  // pose are kept in memory, so that localization does not depend on the map size.
+  bool MapPaging = false;
+
   // How to downsample the points in the keypoints' maps
   // This mode parameter allows to choose how to select the remaining point in each voxel.
   // It can be taking the first/last acquired point, taking the max intensity point,
@@ -886,6 +1029,13 @@ private:
   // Boolean to enable the registration between two sub maps instead of registering a single frame on a sub map.
   bool LoopClosureICPWithSubmap = false;
 
+  // Place recognition index of the logged keyframes, used to detect
+  // loop closures automatically when ExtDetectLoopClosure is disabled.
+  LoopClosureDetector LoopDetector;
+
+  // Latency histograms of the processing stages
+  Profiling::Profiler Timings;
+
   // ---------------------------------------------------------------------------
   //   Optimization data
   // ---------------------------------------------------------------------------
@@ -893,7 +1043,6 @@ private:
   //! Matching results
   std::map<Keypoint, KeypointsMatcher::MatchingResults> EgoMotionMatchingResults;
   std::map<Keypoint, KeypointsMatcher::MatchingResults> LocalizationMatchingResults;
-  std::map<Keypoint, KeypointsMatcher::MatchingResults> LoopClosureMatchingResults;
 
   // Optimization results
   // Variance-Covariance matrix that estimates the localization error about the
@@ -1074,9 +1223,94 @@ private:
   float CovarianceScale = 1.f;
   int NbGraphIterations = 100;
 
+  // Keep the pose graph between optimizations and update it incrementally with iSAM2,
+  // instead of rebuilding and optimizing the whole graph with g2o at each call
+  bool IncrementalGraph = false;
+
+  // Use only the keyframes as pose graph vertices.
+  // The other logged states keep their pose relatively to their bracketing
+  // keyframes, and are recomposed from the optimized keyframes poses.
+  // Only the keyframes are used to build the maps, so this reduces the graph
+  // size and optimization time without modifying the maps.
+  // WARNING : external sensors constraints are only added on keyframes.
+  bool GraphKeyframesOnly = false;
+
+  // Min motion of a keyframe after a pose graph optimization to update the maps :
+  // the keyframes preceding the first one which moved more are not added again to the maps.
+  double MapUpdateDistanceThreshold = 0.02;  ///< [m]
+  double MapUpdateAngleThreshold = 0.1;      ///< [°]
+
+  #ifdef USE_GTSAM
+  // Incremental pose graph, containing all states logged since its last reset
+  IncrementalPoseGraph IncrementalGraphOptimizer;
+  // Time of the last state whose external sensors constraints have been looked for,
+  // for GPS and for each landmark
+  double IncrementalGraphGpsTime = -1.;
+  std::unordered_map<int, double> IncrementalGraphLmTimes;
+  #endif  // USE_GTSAM
+
   // Booleans to decide whether to use a pose graph constraint for the optimization
   std::map<PGOConstraint, bool> UsePGOConstraints = {{LOOP_CLOSURE, true}, {LANDMARK, true}, {PGO_GPS, true}};
 
+  // Parameters used to build maps and to register keypoints onto them.
+  // The background pose graph optimization works on a snapshot of them,
+  // as they can be modified by the user while frames are processed.
+  struct ParametersSnapshot
+  {
+    // Maps holding the parameters of LocalMaps (resolutions, sampling mode...).
+    // They are the LocalMaps themselves, or empty copies of them in a snapshot.
+    Maps Grids;
+    std::vector<Keypoint> UsableKeypoints;
+    int NbThreads = 1;
+    bool TwoDMode = false;
+    unsigned int MinNbMatchedKeypoints = 20;
+    // Map update thresholds (see UpdateMapsFromOptimized)
+    double MapUpdateDistanceThreshold = 0.02;  ///< [m]
+    double MapUpdateAngleThreshold = 0.1;      ///< [°]
+    // Loop closure registration parameters
+    Optimization::Parameters LoopClosureParams;
+    int LCQueryWindowStartRange = -50;
+    int LCQueryWindowEndRange = 50;
+    int LCRevisitedWindowStartRange = -50;
+    int LCRevisitedWindowEndRange = 50;
+    bool EnableLoopClosureOffset = false;
+    bool LoopClosureICPWithSubmap = false;
+    float CovarianceScale = 1.f;
+  };
+
+  // Get the current parameters. If copyGrids is true, the grids are copied
+  // (without their points) so that the snapshot does not depend on LocalMaps anymore.
+  ParametersSnapshot GetParametersSnapshot(bool copyGrids = false) const;
+
+  // Data of a pose graph optimization, which can be processed in background
+  struct GraphOptimizationJob
+  {
+    // Snapshot of the parameters, used during processing
+    ParametersSnapshot Params;
+    #ifdef USE_G2O
+    PoseGraphOptimizer Graph;
+    #endif
+    // Snapshot of the logged states, optimized in place
+    std::list<LidarState> States;
+    // Snapshot states before optimization
+    std::list<LidarState> InitialStates;
+    // Loop closure detected frames, to register during processing
+    bool LoopClosureDetected = false;
+    unsigned int LoopClosureQueryIdx = 0;
+    std::vector<LoopClosureDetector::Candidate> LoopClosureCandidates;
+    // True if at least one constraint has been added to the graph
+    bool ExternalConstraint = false;
+    // Snapshot of the maps, updated with the optimized states (background mode only)
+    Maps RebuiltMaps;
+  };
+
+  // Background pose graph optimization, and its result (success or not).
+  // The result is valid until the optimization is applied.
+  std::shared_ptr<GraphOptimizationJob> PendingGraphOptimization;
+  std::future<bool> GraphOptimizationResult;
+  // True if the last background optimization succeeded
+  bool LastGraphOptimizationSuccess = false;
+
   // ---------------------------------------------------------------------------
   //   Confidence estimation
   // ---------------------------------------------------------------------------
@@ -1115,6 +1349,10 @@ private:
   // If 0, overlap won't be computed.
   float OverlapSamplingRatio = 0.f;
 
+  // How to estimate the overlap (see OverlapMode).
+  // The sampling ratio is not used in MATCHING mode, but still enables the estimation.
+  OverlapMode OverlapEstimator = OverlapMode::LCP;
+
   // Motion limitations
   // Local velocity thresholds in BASE
   Eigen::Array2f VelocityLimits     = {FLT_MAX, FLT_MAX};
@@ -1162,45 +1400,120 @@ private:
   // Log current frame processing results : pose, covariance and keypoints.
   void LogCurrentFrameState();
 
+  // ---------------------------------------------------------------------------
+  //   Pose graph optimization helpers
+  // ---------------------------------------------------------------------------
+
+  #ifdef USE_G2O
+  // Init the graph with a copy of the logged states and the external constraints,
+  // and detect the loop closure frames. It must be called from frames processing thread.
+  bool InitGraphOptimization(GraphOptimizationJob& job);
+
+  // Register the detected loop closure and optimize the graph.
+  // It only works on the job data, and can therefore run in background.
+  bool ProcessGraphOptimization(GraphOptimizationJob& job);
+  #endif  // USE_G2O
+
+  // Update the logged states, current pose and maps with a background optimization results
+  void ApplyGraphOptimization(GraphOptimizationJob& job);
+
+  // Get a copy of the logged states to use as pose graph vertices
+  // (only the keyframes if GraphKeyframesOnly is enabled)
+  std::list<LidarState> GetGraphStates() const;
+
+  // Get the graph vertex state nearest to a logged state : the state itself,
+  // or the next keyframe (the previous one if none) if GraphKeyframesOnly is enabled
+  std::list<LidarState>::iterator GetGraphState(std::list<LidarState>::iterator itState);
+
+  // Update the states with the optimized poses of a subset of them (the graph vertices).
+  // States are matched by index and sorted by increasing index.
+  // The other states keep their pose relatively to their bracketing optimized states :
+  // the poses recomposed from each one of these are interpolated in time.
+  // The states more recent than the last optimized one follow its correction.
+  void UpdateStatesFromOptimized(std::list<LidarState>& states, const std::list<LidarState>& optimizedStates) const;
+
+  // Update the maps containing the keypoints of the initial states with the optimized states.
+  // As the keyframes points are merged in the maps voxels, they can not be removed
+  // individually : the points acquired since the first keyframe which moved more than
+  // the map update thresholds are removed, and the following keyframes are added back.
+  // The points older than the first state are never removed, as they can not be restored.
+  void UpdateMapsFromOptimized(Maps& maps, const ParametersSnapshot& params,
+                               const std::list<LidarState>& initialStates,
+                               const std::list<LidarState>& optimizedStates);
+
+  #ifdef USE_GTSAM
+  // Add the new logged states and their constraints to the incremental graph,
+  // update it, then the logged states, maps and current pose
+  bool OptimizeGraphIncremental();
+  #endif  // USE_GTSAM
+
+  // Remove all states and constraints from the incremental graph
+  void ResetIncrementalGraph();
+
   // ---------------------------------------------------------------------------
   //   Loop Closure usage
   // ---------------------------------------------------------------------------
 
-  // If external detection is enabled, check whether the inputs of loop closure frame indices are stored in the LogStates
-  // if not, detect automatically a revisited frame idx for the current frame (TBA)
-  bool DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryState, std::list<LidarState>::iterator& itRevisitedState);
+  // Get a query frame and its revisited frame candidates, sorted from the most to the least likely.
+  // If external detection is enabled, the input loop closure frame indices are used (replaced by
+  // their neighbors if they are not stored in the LogStates), with an unknown yaw (NaN).
+  // Otherwise, the candidates are detected automatically for the last keyframe, with their estimated yaw.
+  // The returned frames are the ones used in the pose graph (see GetGraphState).
+  bool DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryState, std::vector<LoopClosureDetector::Candidate>& candidates);
 
   // Compute the transform between a query frame and the revisited frame
   // by registering query frame keypoints onto keypoints of the submap around the revisited frame.
   // revisitedFrameIdx is the frame index where the query frame meets a loop.
-  bool LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState,
-                               std::list<LidarState>::iterator& itRevisitedState,
+  // If yaw (heading of the query frame relatively to the revisited frame) is known, the registration
+  // starts from the revisited pose rotated by this yaw. Otherwise (NaN), it starts from the query pose.
+  // The states are the logged states, or a snapshot of them when run in background.
+  bool LoopClosureRegistration(const ParametersSnapshot& params,
+                               const std::list<LidarState>& states,
+                               std::list<LidarState>::const_iterator itQueryState,
+                               std::list<LidarState>::const_iterator itRevisitedState,
+                               float yaw,
                                Eigen::Isometry3d& loopClosureTransform,
                                Eigen::Matrix6d& loopClosureCovariance);
 
+  // Register the query frame onto its loop closure candidates, in order, until one registration succeeds.
+  // revisitedIdx is set to the index of the registered candidate.
+  bool RegisterLoopClosureCandidates(const ParametersSnapshot& params,
+                                     const std::list<LidarState>& states,
+                                     unsigned int queryIdx,
+                                     const std::vector<LoopClosureDetector::Candidate>& candidates,
+                                     unsigned int& revisitedIdx,
+                                     Eigen::Isometry3d& loopClosureTransform,
+                                     Eigen::Matrix6d& loopClosureCovariance);
+
   // ---------------------------------------------------------------------------
   //   Map helpers
   // ---------------------------------------------------------------------------
 
-  // Init sub maps with same parameters of LocalMaps
-  void InitSubMaps(Maps& maps);
+  // Init empty sub maps with same parameters of the snapshot grids (resolutions, sampling mode...)
+  void InitSubMaps(Maps& maps, const ParametersSnapshot& params);
 
   // Aggregate logged keypoints of frames between # [windowStartIdx, windowStartEndIdx]
+  // from the states list (LogStates or a snapshot of it).
   // Default arguments lead to the aggregation of all available logged keypoints of keyframes.
   // It is used to recompute the current SLAM maps from the beginning using the new trajectory (after PGO)
   // and to build sub maps in the loop closure context
   // Keypoints are aggregated in world coordinates by default
   // or in base coordinates of frame #idxFrame when idxFrame is not negative
-  void BuildMaps(Maps& maps, int windowStartIdx = -1, int windowEndIdx = -1, int idxFrame = -1);
+  // The keypoints are added to the maps using NbThreads threads, except with
+  // CENTROID sampling, whose voxels updates are not independent : a single thread is used.
+  void BuildMaps(Maps& maps, const std::list<LidarState>& states, const ParametersSnapshot& params,
+                 int windowStartIdx = -1, int windowEndIdx = -1, int idxFrame = -1);
 
   // ICP-LM Optimization process to estimate pose
   // Compute the pose of the sourceKeypoints by registering
   // sourcekeypoints on targetkeypoints
   LocalOptimizer::RegistrationError EstimatePose(const std::map<Keypoint, PointCloud::Ptr>& sourceKeypoints,
                                                  const Maps& targetKeypoints,
+                                                 const ParametersSnapshot& snapshot,
                                                  Optimization::Parameters& params,
                                                  Eigen::Isometry3d& posePrior,
-                                                 std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults);
+                                                 std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults,
+                                                 unsigned int& totalMatchedKeypoints);
 
   // ---------------------------------------------------------------------------
   //   Undistortion helpers
@@ -27,8 +27,10 @@
 #include <iostream>
 #include <iomanip>
 #include <math.h>
+#include <limits>
 #include <numeric>
 #include <cctype>
+#include <unordered_set>
 
 //==============================================================================
 //   Usefull macros or typedefs
@@ -374,6 +376,69 @@ inline void CopyPointCloudMetadata(const pcl::PointCloud<PointT>& from, pcl::Poi
   to.sensor_origin_ = from.sensor_origin_;
 }
 
+//------------------------------------------------------------------------------
+/*!
+ * @brief Downsample a pointcloud, keeping the first point of each voxel
+ * @param[in] cloud The pointcloud to downsample
+ * @param[in] leafSize [m] Size of the voxels
+ * @param[in] nbThreads Max number of threads to use
+ * @return The downsampled pointcloud, in input points order
+ *
+ * Points with non finite coordinates are dropped.
+ * The voxels are hashed and split between threads, so that each thread selects
+ * the points of its own voxels. The first point of each voxel is kept (and not
+ * a centroid), so that all point fields (time, laser_id, ...) remain valid.
+ */
+template<typename PointT>
+typename pcl::PointCloud<PointT>::Ptr VoxelDownsample(const pcl::PointCloud<PointT>& cloud, double leafSize, int nbThreads = 1)
+{
+  const int nbPoints = cloud.size();
+  nbThreads = std::max(nbThreads, 1);
+
+  // Compute the voxel of each point, packed in 21 bits per axis.
+  // Packed keys use 63 bits, so the max key marks the non finite points.
+  constexpr uint64_t InvalidKey = std::numeric_limits<uint64_t>::max();
+  std::vector<uint64_t> keys(nbPoints);
+  #pragma omp parallel for num_threads(nbThreads)
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    if (!cloud[i].getArray3fMap().allFinite())
+    {
+      keys[i] = InvalidKey;
+      continue;
+    }
+    Eigen::Array3i voxel = (cloud[i].getArray3fMap().template cast<double>() / leafSize).floor().template cast<int>();
+    keys[i] = (static_cast<uint64_t>(voxel.x() & 0x1FFFFF) << 42) |
+              (static_cast<uint64_t>(voxel.y() & 0x1FFFFF) << 21) |
+               static_cast<uint64_t>(voxel.z() & 0x1FFFFF);
+  }
+
+  // Each thread keeps the first point of the voxels it owns
+  std::vector<uint8_t> keep(nbPoints, 0);
+  #pragma omp parallel for num_threads(nbThreads) schedule(static, 1)
+  for (int part = 0; part < nbThreads; ++part)
+  {
+    std::unordered_set<uint64_t> seen;
+    for (int i = 0; i < nbPoints; ++i)
+    {
+      if (keys[i] != InvalidKey &&
+          static_cast<int>(((keys[i] * 0x9E3779B97F4A7C15ULL) >> 32) % nbThreads) == part && seen.insert(keys[i]).second)
+        keep[i] = 1;
+    }
+  }
+
+  typename pcl::PointCloud<PointT>::Ptr downsampled(new pcl::PointCloud<PointT>);
+  CopyPointCloudMetadata(cloud, *downsampled);
+  downsampled->is_dense = true;
+  downsampled->reserve(nbPoints);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    if (keep[i])
+      downsampled->push_back(cloud[i]);
+  }
+  return downsampled;
+}
+
 //------------------------------------------------------------------------------
 /*!
  * @brief Build and return a PCL header
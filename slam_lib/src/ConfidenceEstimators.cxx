@@ -34,35 +34,118 @@ float LCPEstimator(PointCloud::ConstPtr cloud,
   if (nbPoints == 0 || maps.empty())
     return -1.;
 
+  // Gather the maps to look for neighbors in, skipping the ones with an empty KD-tree.
+  // We use a Gaussian like estimation for each point fitted in target leaf space
+  // to check the probability that one cloud point has a neighbor in the target :
+  // Probability = 1 if the two points are superimposed
+  // Probability < 0.011 if the distance is g.t. the leaf size
+  // The Gaussian factor -1 / (2 * (leafSize / 3)^2) is computed once per map.
+  std::vector<const RollingGrid::KDTree*> kdTrees;
+  std::vector<float> gaussianFactors;
+  for (const auto& map : maps)
+  {
+    if (!map.second->IsSubMapKdTreeValid())
+      continue;
+    kdTrees.push_back(&map.second->GetSubMapKdTree());
+    gaussianFactors.push_back(-1.f / (2.f * std::pow(map.second->GetLeafSize() / 3.f, 2)));
+  }
+  int nbMaps = kdTrees.size();
+  if (nbMaps == 0)
+    return -1.;
+
+  // A point is considered superimposed on a map point above this probability :
+  // the other maps are not searched, as they could not increase its contribution
+  // by more than 1 - MaxProba.
+  constexpr float MaxProba = 0.99;
+
   // Iterate on all points of input cloud to process
   float lcp = 0.;
-  #pragma omp parallel for num_threads(nbThreads) reduction(+:lcp)
-  for (int n = 0; n < nbPoints; ++n)
+  #pragma omp parallel num_threads(nbThreads)
   {
-    // Compute the LCP contribution of the current point
-    const auto& point = cloud->at(n / subsamplingRatio);
-    float bestProba = 0.;
-    for (const auto& map : maps)
+    // Map in which the previous point of this thread had its best neighbor.
+    // Successive points usually lie on the same structure, so this map is
+    // searched first to early stop the search as often as possible.
+    int cachedMap = 0;
+
+    #pragma omp for reduction(+:lcp)
+    for (int n = 0; n < nbPoints; ++n)
     {
-      // Get nearest neighbor
-      int nnIndex;
-      float nnSqDist;
-      if (map.second->GetSubMapKdTree().KnnSearch(point.data, 1, &nnIndex, &nnSqDist))
+      // Compute the LCP contribution of the current point
+      const auto& point = cloud->at(n / subsamplingRatio);
+      float bestProba = 0.;
+      int bestMap = cachedMap;
+      for (int i = 0; i < nbMaps && bestProba < MaxProba; ++i)
       {
-        // We use a Gaussian like estimation for each point fitted in target leaf space
-        // to check the probability that one cloud point has a neighbor in the target
-        // Probability = 1 if the two points are superimposed
-        // Probability < 0.011 if the distance is g.t. the leaf size
-        float sqLCPThreshold = std::pow(map.second->GetLeafSize() / 3.f, 2);
-        float currentProba = std::exp( -nnSqDist / (2.f * sqLCPThreshold) );
-        if (currentProba > bestProba)
-          bestProba = currentProba;
+        // Get nearest neighbor in the map
+        int m = (cachedMap + i) % nbMaps;
+        int nnIndex;
+        float nnSqDist;
+        if (kdTrees[m]->KnnSearch(point.data, 1, &nnIndex, &nnSqDist))
+        {
+          float currentProba = std::exp(gaussianFactors[m] * nnSqDist);
+          if (currentProba > bestProba)
+          {
+            bestProba = currentProba;
+            bestMap = m;
+          }
+        }
       }
+      cachedMap = bestMap;
+      lcp += bestProba;
     }
-    lcp += bestProba;
   }
   return lcp / nbPoints;
 }
 
+//-----------------------------------------------------------------------------
+float MatchingEstimator(const std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults)
+{
+  unsigned int nbMatches = 0;
+  unsigned int nbKeypoints = 0;
+  for (const auto& kv : matchingResults)
+  {
+    nbMatches += kv.second.NbMatches();
+    nbKeypoints += kv.second.Rejections.size();
+  }
+  if (nbKeypoints == 0)
+    return -1.;
+  return static_cast<float>(nbMatches) / nbKeypoints;
+}
+
+//-----------------------------------------------------------------------------
+float VoxelOccupancyEstimator(const std::map<Keypoint, PointCloud::Ptr>& keypoints,
+                              const Eigen::Isometry3d& pose,
+                              const std::map<Keypoint, std::shared_ptr<RollingGrid>>& maps,
+                              float subsamplingRatio,
+                              int nbThreads)
+{
+  const Eigen::Isometry3f poseF = pose.cast<float>();
+  int nbOccupied = 0;
+  int nbPoints = 0;
+  for (const auto& map : maps)
+  {
+    auto itKpts = keypoints.find(map.first);
+    if (itKpts == keypoints.end() || !itKpts->second)
+      continue;
+    const PointCloud& cloud = *itKpts->second;
+    const RollingGrid& grid = *map.second;
+
+    // Number of points to process
+    int nbMapPoints = cloud.size() * subsamplingRatio;
+    #pragma omp parallel for num_threads(nbThreads) reduction(+:nbOccupied)
+    for (int n = 0; n < nbMapPoints; ++n)
+    {
+      const auto& point = cloud[n / subsamplingRatio];
+      Eigen::Array3f worldPoint = (poseF * point.getVector3fMap()).array();
+      if (grid.IsOccupied(worldPoint))
+        ++nbOccupied;
+    }
+    nbPoints += nbMapPoints;
+  }
+  if (nbPoints == 0)
+    return -1.;
+  return static_cast<float>(nbOccupied) / nbPoints;
+}
+
 } // end of Confidence namespace
 } // end of LidarSlam namespace
\ No newline at end of file
@@ -0,0 +1,364 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlam/IncrementalPoseGraph.h"
+#include "LidarSlam/CeresCostFunctions.h"
+#include "LidarSlam/Utilities.h"
+
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/nonlinear/NonlinearFactor.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+
+#include <algorithm>
+
+namespace LidarSlam
+{
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Graph key of a SLAM state
+gtsam::Key StateKey(unsigned int index)
+{
+  return gtsam::Symbol('x', index);
+}
+
+//------------------------------------------------------------------------------
+// Mark the frontal keys of the cliques depending on a key : they must be
+// re-eliminated with it to make it a leaf of the Bayes tree
+// (see gtsam IncrementalFixedLagSmoother)
+void MarkAffectedKeys(gtsam::Key key, const gtsam::ISAM2Clique::shared_ptr& clique, gtsam::KeySet& affectedKeys)
+{
+  const auto& conditional = clique->conditional();
+  if (std::find(conditional->beginParents(), conditional->endParents(), key) == conditional->endParents())
+    return;
+  for (gtsam::Key frontal : conditional->frontals())
+    affectedKeys.insert(frontal);
+  for (const auto& child : clique->children)
+    MarkAffectedKeys(key, child, affectedKeys);
+}
+
+//------------------------------------------------------------------------------
+// Constraint between a point expressed in the base frame of a pose
+// and its known position in world frame.
+// It is used for the GPS antenna position and the position-only landmarks.
+class PointPositionFactor : public gtsam::NoiseModelFactor1<gtsam::Pose3>
+{
+public:
+  PointPositionFactor(gtsam::Key key, const Eigen::Vector3d& basePoint, const Eigen::Vector3d& worldPoint,
+                      const gtsam::SharedNoiseModel& model)
+    : gtsam::NoiseModelFactor1<gtsam::Pose3>(model, key)
+    , BasePoint(basePoint)
+    , WorldPoint(worldPoint)
+  {}
+
+  gtsam::Vector evaluateError(const gtsam::Pose3& pose, boost::optional<gtsam::Matrix&> H = boost::none) const override
+  {
+    gtsam::Point3 worldPoint = pose.transformFrom(gtsam::Point3(this->BasePoint), H);
+    return gtsam::Vector3(worldPoint.x() - this->WorldPoint.x(),
+                          worldPoint.y() - this->WorldPoint.y(),
+                          worldPoint.z() - this->WorldPoint.z());
+  }
+
+private:
+  Eigen::Vector3d BasePoint;
+  Eigen::Vector3d WorldPoint;
+};
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+IncrementalPoseGraph::IncrementalPoseGraph()
+{
+  this->Reset();
+}
+
+//------------------------------------------------------------------------------
+void IncrementalPoseGraph::Reset()
+{
+  gtsam::ISAM2Params parameters;
+  parameters.relinearizeThreshold = 0.1;
+  parameters.relinearizeSkip = 1;
+  this->Isam = gtsam::ISAM2(parameters);
+  this->NewFactors = gtsam::NonlinearFactorGraph();
+  this->NewValues.clear();
+  this->Estimate.clear();
+  this->StatesIndices.clear();
+  this->LastIndex = 0;
+  this->LastPose = Eigen::Isometry3d::Identity();
+  this->LoopClosures.clear();
+  this->MarginalizationIndex = 0;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::HasState(unsigned int index) const
+{
+  return this->StatesIndices.count(index);
+}
+
+//------------------------------------------------------------------------------
+unsigned int IncrementalPoseGraph::AddLidarStates(const std::list<LidarState>& states)
+{
+  unsigned int nbAddedStates = 0;
+  for (const auto& state : states)
+  {
+    // Skip the states already in the graph
+    if (!this->StatesIndices.empty() && state.Index <= this->LastIndex)
+      continue;
+
+    gtsam::Key key = StateKey(state.Index);
+    this->NewValues.insert(key, gtsam::Pose3(state.Isometry.matrix()));
+
+    // The first state is anchored with a prior, tight if it is fixed.
+    // Otherwise, the prior is loose to let external constraints move it.
+    if (this->StatesIndices.empty())
+    {
+      double sigma = this->FixFirst ? 1e-6 : 1e2;
+      this->NewFactors.emplace_shared<gtsam::PriorFactor<gtsam::Pose3>>(key, gtsam::Pose3(state.Isometry.matrix()),
+                                                                          gtsam::noiseModel::Isotropic::Sigma(6, sigma));
+    }
+    // Add a constraint with the relative transform from the last added state
+    else
+    {
+      Eigen::Isometry3d lastFrameInv = this->LastPose.inverse();
+      Eigen::Isometry3d Trelative = lastFrameInv * state.Isometry;
+      // Rotate covariance
+      // Lidar Slam gives the covariance expressed in the map frame
+      // We want the covariance expressed in the last frame to be consistent with supplied relative transform
+      Eigen::Vector6d xyzrpy = Utils::IsometryToXYZRPY(state.Isometry);
+      Eigen::Matrix6d covariance = CeresTools::RotateCovariance(xyzrpy, state.Covariance, lastFrameInv, true); // new = prevState^-1 * init
+      auto noise = gtsam::noiseModel::Gaussian::Covariance(ToPose3Covariance(covariance));
+      this->NewFactors.emplace_shared<gtsam::BetweenFactor<gtsam::Pose3>>(StateKey(this->LastIndex), key,
+                                                                            gtsam::Pose3(Trelative.matrix()),
+                                                                            this->Robustify(noise));
+    }
+
+    this->StatesIndices.insert(state.Index);
+    this->LastIndex = state.Index;
+    this->LastPose = state.Isometry;
+    ++nbAddedStates;
+  }
+  if (this->Verbose)
+    PRINT_INFO(nbAddedStates << " lidar states added to the graph");
+  return nbAddedStates;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::HasLoopClosure(unsigned int queryFrameIdx, unsigned int revisitedFrameIdx) const
+{
+  return this->LoopClosures.count({queryFrameIdx, revisitedFrameIdx});
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::AddLoopClosureConstraint(unsigned int queryFrameIdx, unsigned int revisitedFrameIdx,
+                                                    const Eigen::Isometry3d& loopClosureTransform,
+                                                    const Eigen::Matrix6d& loopClosureCovariance)
+{
+  if (!this->HasState(queryFrameIdx) || !this->HasState(revisitedFrameIdx))
+  {
+    PRINT_ERROR("Loop closure constraint could not be added to the graph : state not found");
+    return false;
+  }
+  if (!this->LoopClosures.insert({queryFrameIdx, revisitedFrameIdx}).second)
+    return false;
+
+  auto noise = gtsam::noiseModel::Gaussian::Covariance(ToPose3Covariance(loopClosureCovariance));
+  this->NewFactors.emplace_shared<gtsam::BetweenFactor<gtsam::Pose3>>(StateKey(revisitedFrameIdx), StateKey(queryFrameIdx),
+                                                                        gtsam::Pose3(loopClosureTransform.matrix()),
+                                                                        this->Robustify(noise));
+  if (this->Verbose)
+    PRINT_INFO("Add Loop closure constraint between state #" << revisitedFrameIdx
+               << " and state #" << queryFrameIdx << " to the graph");
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::AddLandmarkConstraint(unsigned int lidarIdx, const Eigen::Isometry3d& detectorCalibration,
+                                                 const Eigen::Isometry3d& lmPose, const ExternalSensors::LandmarkMeasurement& lm,
+                                                 bool onlyPosition)
+{
+  if (!this->HasState(lidarIdx))
+  {
+    PRINT_ERROR("Landmark constraint could not be added to the graph : state #" << lidarIdx << " not found");
+    return false;
+  }
+
+  // Landmark pose in base frame
+  Eigen::Isometry3d baseToLm = detectorCalibration * lm.TransfoRelative;
+  if (onlyPosition)
+  {
+    auto noise = gtsam::noiseModel::Gaussian::Covariance(lm.Covariance.topLeftCorner<3, 3>());
+    this->NewFactors.emplace_shared<PointPositionFactor>(StateKey(lidarIdx), baseToLm.translation(), lmPose.translation(),
+                                                         this->Robustify(noise));
+  }
+  else
+  {
+    // The landmark absolute pose gives directly the base pose
+    Eigen::Isometry3d basePose = lmPose * baseToLm.inverse();
+    auto noise = gtsam::noiseModel::Gaussian::Covariance(ToPose3Covariance(lm.Covariance));
+    this->NewFactors.emplace_shared<gtsam::PriorFactor<gtsam::Pose3>>(StateKey(lidarIdx), gtsam::Pose3(basePose.matrix()),
+                                                                        this->Robustify(noise));
+  }
+  if (this->Verbose)
+    PRINT_INFO("Add landmark constraint for state #" << lidarIdx);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::AddGpsConstraint(unsigned int lidarIdx, const Eigen::Isometry3d& gpsCalibration,
+                                            const ExternalSensors::GpsMeasurement& gpsMeas)
+{
+  if (!this->HasState(lidarIdx))
+  {
+    PRINT_ERROR("GPS constraint could not be added to the graph : state #" << lidarIdx << " not found");
+    return false;
+  }
+
+  // We want to merge the GPS antenna position of this SLAM pose to the GPS point
+  auto noise = gtsam::noiseModel::Gaussian::Covariance(gpsMeas.Covariance);
+  this->NewFactors.emplace_shared<PointPositionFactor>(StateKey(lidarIdx), gpsCalibration.translation(), gpsMeas.Position, noise);
+  if (this->Verbose)
+    PRINT_INFO("Add GPS constraint for state #" << lidarIdx);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::Process(std::vector<unsigned int>& updatedIndices)
+{
+  updatedIndices.clear();
+  if (this->StatesIndices.empty())
+  {
+    PRINT_ERROR("The graph is empty, it can not be optimized");
+    return false;
+  }
+
+  // The marginalized states must be eliminated first, to be leaves of the
+  // Bayes tree : the cliques depending on them are re-eliminated.
+  gtsam::FastList<gtsam::Key> marginalizedKeys = this->GetStatesToMarginalize();
+  boost::optional<gtsam::FastMap<gtsam::Key, int>> constrainedKeys;
+  gtsam::FastList<gtsam::Key> affectedKeys;
+  if (!marginalizedKeys.empty())
+  {
+    constrainedKeys = gtsam::FastMap<gtsam::Key, int>();
+    for (unsigned int index : this->StatesIndices)
+      (*constrainedKeys)[StateKey(index)] = 1;
+    gtsam::KeySet affected;
+    for (gtsam::Key key : marginalizedKeys)
+    {
+      (*constrainedKeys)[key] = 0;
+      for (const auto& child : this->Isam[key]->children)
+        MarkAffectedKeys(key, child, affected);
+    }
+    affectedKeys.insert(affectedKeys.end(), affected.begin(), affected.end());
+  }
+
+  if (this->Verbose)
+  {
+    PRINT_INFO("Incremental graph update with:\n"
+               << "\t" << this->NewValues.size() << " new states\n"
+               << "\t" << this->NewFactors.size() << " new constraints\n"
+               << "\t" << marginalizedKeys.size() << " marginalized states\n");
+  }
+
+  // Update the solution with the new factors and values.
+  // Only the cliques of the Bayes tree affected by these are recomputed.
+  try
+  {
+    this->Isam.update(this->NewFactors, this->NewValues, gtsam::FactorIndices(), constrainedKeys, boost::none, affectedKeys);
+    if (!marginalizedKeys.empty())
+      this->Isam.marginalizeLeaves(marginalizedKeys);
+    for (int i = 1; i < this->NbUpdates; ++i)
+      this->Isam.update();
+  }
+  catch (const std::exception& e)
+  {
+    // The iSAM2 state is not reliable anymore : the graph is restarted
+    // from scratch on next processing
+    PRINT_ERROR("Incremental pose graph optimization failed : " << e.what());
+    this->Reset();
+    return false;
+  }
+  this->NewFactors = gtsam::NonlinearFactorGraph();
+  this->NewValues.clear();
+  for (gtsam::Key key : marginalizedKeys)
+    this->StatesIndices.erase(gtsam::Symbol(key).index());
+  for (auto it = this->LoopClosures.begin(); it != this->LoopClosures.end();)
+    it = this->HasState(it->first) && this->HasState(it->second) ? std::next(it) : this->LoopClosures.erase(it);
+
+  // Report the states whose optimized pose has changed
+  gtsam::Values estimate = this->Isam.calculateEstimate();
+  for (unsigned int index : this->StatesIndices)
+  {
+    gtsam::Key key = StateKey(index);
+    if (!this->Estimate.exists(key) ||
+        !estimate.at<gtsam::Pose3>(key).equals(this->Estimate.at<gtsam::Pose3>(key), this->PoseTolerance))
+      updatedIndices.push_back(index);
+  }
+  this->Estimate = std::move(estimate);
+  this->LastPose = Eigen::Isometry3d(this->Estimate.at<gtsam::Pose3>(StateKey(this->LastIndex)).matrix());
+
+  if (this->Verbose)
+    PRINT_INFO("Incremental graph contains " << this->StatesIndices.size() << " states, "
+               << updatedIndices.size() << " of them have been updated");
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool IncrementalPoseGraph::GetPose(unsigned int index, Eigen::Isometry3d& pose) const
+{
+  gtsam::Key key = StateKey(index);
+  if (!this->Estimate.exists(key))
+    return false;
+  pose = Eigen::Isometry3d(this->Estimate.at<gtsam::Pose3>(key).matrix());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+gtsam::FastList<gtsam::Key> IncrementalPoseGraph::GetStatesToMarginalize() const
+{
+  gtsam::FastList<gtsam::Key> keys;
+  gtsam::KeySet newFactorsKeys = this->NewFactors.keys();
+  for (unsigned int index : this->StatesIndices)
+  {
+    if (index >= this->MarginalizationIndex || index == this->LastIndex)
+      break;
+    gtsam::Key key = StateKey(index);
+    if (this->Isam.valueExists(key) && !newFactorsKeys.count(key))
+      keys.push_back(key);
+  }
+  // Marginalize by batches
+  if (keys.size() < this->MarginalizationRatio * this->StatesIndices.size())
+    keys.clear();
+  return keys;
+}
+
+//------------------------------------------------------------------------------
+Eigen::Matrix6d IncrementalPoseGraph::ToPose3Covariance(const Eigen::Matrix6d& covariance)
+{
+  Eigen::Matrix6d pose3Covariance;
+  pose3Covariance << covariance.bottomRightCorner<3, 3>(), covariance.bottomLeftCorner<3, 3>(),
+                     covariance.topRightCorner<3, 3>(),    covariance.topLeftCorner<3, 3>();
+  return pose3Covariance;
+}
+
+//------------------------------------------------------------------------------
+gtsam::SharedNoiseModel IncrementalPoseGraph::Robustify(const gtsam::SharedNoiseModel& model) const
+{
+  return gtsam::noiseModel::Robust::Create(gtsam::noiseModel::mEstimator::Huber::Create(this->SaturationDistance), model);
+}
+
+} // end of LidarSlam namespace
@@ -0,0 +1,319 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlam/LoopClosureDetector.h"
+#include "LidarSlam/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace LidarSlam
+{
+
+//==============================================================================
+//   Parameters
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::SetNbRings(unsigned int nbRings)
+{
+  if (nbRings == this->NbRings)
+    return;
+  this->NbRings = std::max(1u, nbRings);
+  this->Clear();
+}
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::SetNbSectors(unsigned int nbSectors)
+{
+  if (nbSectors == this->NbSectors)
+    return;
+  this->NbSectors = std::max(1u, nbSectors);
+  this->Clear();
+}
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::SetMaxRadius(double radius)
+{
+  if (radius == this->MaxRadius)
+    return;
+  this->MaxRadius = radius;
+  this->Clear();
+}
+
+//==============================================================================
+//   Index management
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::Clear()
+{
+  this->Entries.clear();
+  this->BuildTree();
+}
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::AddFrame(unsigned int index, const std::vector<PointCloud::ConstPtr>& clouds)
+{
+  if (!this->Entries.empty() && index <= this->Entries.back().Index)
+  {
+    PRINT_WARNING("Frame #" << index << " is older than the last indexed frame : it is not added to loop closure index.");
+    return;
+  }
+
+  Entry entry;
+  entry.Index = index;
+  entry.Desc = this->ComputeDescriptor(clouds);
+  entry.RingKey = entry.Desc.rowwise().mean();
+  entry.SectorKey = entry.Desc.colwise().mean().transpose();
+  this->Entries.emplace_back(std::move(entry));
+
+  // Index the new frames in the KD-tree by batches
+  if (this->Entries.size() >= this->TreeKeys.Indices.size() + this->TreeRebuildBatch)
+    this->BuildTree();
+}
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::RemoveBefore(unsigned int index)
+{
+  while (!this->Entries.empty() && this->Entries.front().Index < index)
+    this->Entries.pop_front();
+
+  // Rebuild the KD-tree once it mostly contains removed frames
+  if (this->TreeKeys.Indices.size() > 2 * this->Entries.size() + this->TreeRebuildBatch)
+    this->BuildTree();
+}
+
+//------------------------------------------------------------------------------
+void LoopClosureDetector::BuildTree()
+{
+  const int nbEntries = this->Entries.size();
+  this->TreeKeys.Keys.resize(this->NbRings, nbEntries);
+  this->TreeKeys.Indices.resize(nbEntries);
+  for (int i = 0; i < nbEntries; ++i)
+  {
+    this->TreeKeys.Keys.col(i) = this->Entries[i].RingKey;
+    this->TreeKeys.Indices[i] = this->Entries[i].Index;
+  }
+  if (!nbEntries)
+  {
+    this->Tree.reset();
+    return;
+  }
+  this->Tree = std::make_unique<RingKeysTree>(this->NbRings, this->TreeKeys, nanoflann::KDTreeSingleIndexAdaptorParams(16));
+  this->Tree->buildIndex();
+}
+
+//------------------------------------------------------------------------------
+std::vector<LoopClosureDetector::Candidate> LoopClosureDetector::FindCandidates(unsigned int queryIndex) const
+{
+  std::vector<Candidate> candidates;
+  const Entry* query = this->FindEntry(queryIndex);
+  if (!query || queryIndex < this->MinIndexGap)
+    return candidates;
+
+  // Select the revisited frames with the nearest ring keys.
+  // The frames too recent or removed from the index are skipped : if the
+  // nearest neighbors found in the KD-tree are such frames, the search is extended.
+  unsigned int minIndex = this->Entries.front().Index;
+  unsigned int maxIndex = queryIndex - this->MinIndexGap;
+  std::vector<std::pair<float, const Entry*>> nearest;
+  const int treeSize = this->TreeKeys.Indices.size();
+  if (this->Tree && this->NbCandidates)
+  {
+    int nbNeighbors = std::min(static_cast<int>(this->NbCandidates), treeSize);
+    std::vector<int> knnIndices;
+    std::vector<float> knnSqDistances;
+    while (true)
+    {
+      knnIndices.resize(nbNeighbors);
+      knnSqDistances.resize(nbNeighbors);
+      int nbFound = this->Tree->knnSearch(query->RingKey.data(), nbNeighbors, knnIndices.data(), knnSqDistances.data());
+      nearest.clear();
+      for (int i = 0; i < nbFound && nearest.size() < this->NbCandidates; ++i)
+      {
+        unsigned int index = this->TreeKeys.Indices[knnIndices[i]];
+        if (index >= minIndex && index <= maxIndex)
+          nearest.emplace_back(knnSqDistances[i], this->FindEntry(index));
+      }
+      if (nearest.size() >= this->NbCandidates || nbNeighbors >= treeSize)
+        break;
+      nbNeighbors = std::min(2 * nbNeighbors, treeSize);
+    }
+  }
+
+  // Compare linearly the frames added since the last KD-tree build
+  // (less than TreeRebuildBatch), and keep the nearest ones overall
+  auto itEntry = this->Entries.begin();
+  if (treeSize)
+    itEntry = std::upper_bound(this->Entries.begin(), this->Entries.end(), this->TreeKeys.Indices.back(),
+                               [](unsigned int idx, const Entry& e) { return idx < e.Index; });
+  for (; itEntry != this->Entries.end() && itEntry->Index <= maxIndex; ++itEntry)
+    nearest.emplace_back((itEntry->RingKey - query->RingKey).squaredNorm(), &(*itEntry));
+  if (nearest.size() > this->NbCandidates)
+  {
+    std::partial_sort(nearest.begin(), nearest.begin() + this->NbCandidates, nearest.end(),
+                      [](const std::pair<float, const Entry*>& a, const std::pair<float, const Entry*>& b)
+                      { return a.first < b.first; });
+    nearest.resize(this->NbCandidates);
+  }
+
+  // Compare the full descriptors of the nearest frames
+  for (const auto& near : nearest)
+  {
+    const Entry& entry = *near.second;
+    int shift = this->EstimateShift(query->SectorKey, entry.SectorKey);
+    float bestDistance = std::numeric_limits<float>::max();
+    int bestShift = shift;
+    for (int s = shift - this->ShiftSearchRadius; s <= shift + this->ShiftSearchRadius; ++s)
+    {
+      float distance = this->ShiftedDistance(query->Desc, entry.Desc, s);
+      if (distance < bestDistance)
+      {
+        bestDistance = distance;
+        bestShift = s;
+      }
+    }
+    if (bestDistance > this->MaxDistance)
+      continue;
+    // Sector j of query frame matches sector j + shift of revisited frame
+    float yaw = std::remainder(2. * M_PI * bestShift / this->NbSectors, 2. * M_PI);
+    candidates.push_back({entry.Index, bestDistance, yaw});
+  }
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.Distance < b.Distance; });
+  return candidates;
+}
+
+//------------------------------------------------------------------------------
+const LoopClosureDetector::Entry* LoopClosureDetector::FindEntry(unsigned int index) const
+{
+  auto it = std::lower_bound(this->Entries.begin(), this->Entries.end(), index,
+                             [](const Entry& e, unsigned int idx) { return e.Index < idx; });
+  if (it == this->Entries.end() || it->Index != index)
+    return nullptr;
+  return &(*it);
+}
+
+//==============================================================================
+//   Descriptor helpers
+//==============================================================================
+
+//------------------------------------------------------------------------------
+LoopClosureDetector::Descriptor LoopClosureDetector::ComputeDescriptor(const std::vector<PointCloud::ConstPtr>& clouds) const
+{
+  Descriptor desc = Descriptor::Zero(this->NbRings, this->NbSectors);
+
+  // Heights are relative to the lowest point of the frame, so that the
+  // descriptor does not depend on the sensor mounting height
+  const float maxSqRadius = this->MaxRadius * this->MaxRadius;
+  float zMin = std::numeric_limits<float>::max();
+  for (const auto& cloud : clouds)
+    for (const Point& p : *cloud)
+      if (p.x * p.x + p.y * p.y < maxSqRadius)
+        zMin = std::min(zMin, p.z);
+
+  // Empty bins are set to 0, so shift heights by a small offset to
+  // distinguish them from bins containing only the lowest points.
+  constexpr float EMPTY_OFFSET = 1e-3;
+  const float ringResolution = this->MaxRadius / this->NbRings;
+  const float sectorResolution = 2. * M_PI / this->NbSectors;
+  for (const auto& cloud : clouds)
+  {
+    for (const Point& p : *cloud)
+    {
+      float sqRadius = p.x * p.x + p.y * p.y;
+      if (sqRadius >= maxSqRadius)
+        continue;
+      int ring = std::min(static_cast<int>(std::sqrt(sqRadius) / ringResolution), static_cast<int>(this->NbRings) - 1);
+      int sector = static_cast<int>((std::atan2(p.y, p.x) + M_PI) / sectorResolution);
+      sector = std::min(std::max(sector, 0), static_cast<int>(this->NbSectors) - 1);
+      desc(ring, sector) = std::max(desc(ring, sector), p.z - zMin + EMPTY_OFFSET);
+    }
+  }
+  return desc;
+}
+
+//------------------------------------------------------------------------------
+float LoopClosureDetector::Distance(const Descriptor& d1, const Descriptor& d2, int* bestShift) const
+{
+  float bestDistance = std::numeric_limits<float>::max();
+  int shift = 0;
+  for (int s = 0; s < d2.cols(); ++s)
+  {
+    float distance = this->ShiftedDistance(d1, d2, s);
+    if (distance < bestDistance)
+    {
+      bestDistance = distance;
+      shift = s;
+    }
+  }
+  if (bestShift)
+    *bestShift = shift;
+  return bestDistance;
+}
+
+//------------------------------------------------------------------------------
+float LoopClosureDetector::ShiftedDistance(const Descriptor& d1, const Descriptor& d2, int shift) const
+{
+  const int nbSectors = d1.cols();
+  if (nbSectors != d2.cols() || d1.rows() != d2.rows())
+    return 1.;
+  shift = ((shift % nbSectors) + nbSectors) % nbSectors;
+
+  // Mean cosine similarity of the non empty sectors pairs
+  float similarity = 0.;
+  int nbSectorPairs = 0;
+  for (int j = 0; j < nbSectors; ++j)
+  {
+    auto c1 = d1.col(j);
+    auto c2 = d2.col((j + shift) % nbSectors);
+    float norms = c1.norm() * c2.norm();
+    if (norms <= 0.)
+      continue;
+    similarity += c1.dot(c2) / norms;
+    ++nbSectorPairs;
+  }
+  return nbSectorPairs ? 1. - similarity / nbSectorPairs : 1.;
+}
+
+//------------------------------------------------------------------------------
+int LoopClosureDetector::EstimateShift(const Eigen::VectorXf& sectorKey1, const Eigen::VectorXf& sectorKey2) const
+{
+  const int nbSectors = sectorKey1.size();
+  float bestError = std::numeric_limits<float>::max();
+  int bestShift = 0;
+  for (int s = 0; s < nbSectors; ++s)
+  {
+    float error = 0.;
+    for (int j = 0; j < nbSectors; ++j)
+    {
+      float diff = sectorKey1(j) - sectorKey2((j + s) % nbSectors);
+      error += diff * diff;
+    }
+    if (error < bestError)
+    {
+      bestError = error;
+      bestShift = s;
+    }
+  }
+  return bestShift;
+}
+
+} // end of LidarSlam namespace
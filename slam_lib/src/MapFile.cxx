@@ -0,0 +1,201 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlam/MapFile.h"
+#include "LidarSlam/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace LidarSlam
+{
+
+namespace
+{
+constexpr char FileMagic[8] = "SLAMMAP";
+}
+
+constexpr uint32_t MapFile::FormatVersion;
+
+//------------------------------------------------------------------------------
+bool MapFile::Write(const std::string& path, Header header,
+                    const std::vector<VoxelRecord>& voxels,
+                    const std::vector<PointRecord>& points)
+{
+  // Fill the file layout : header, index, then points.
+  // All sections are 8 bytes aligned, so that records can be read in place.
+  std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+  header.Version = FormatVersion;
+  header.PointRecordSize = sizeof(PointRecord);
+  header.NbVoxels = voxels.size();
+  header.NbPoints = points.size();
+  header.IndexOffset = sizeof(Header);
+  header.PointsOffset = header.IndexOffset + voxels.size() * sizeof(VoxelRecord);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    PRINT_ERROR("Unable to open map file " << path << " for writing.");
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  file.write(reinterpret_cast<const char*>(voxels.data()), voxels.size() * sizeof(VoxelRecord));
+  file.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(PointRecord));
+  if (!file)
+  {
+    PRINT_ERROR("Unable to write map file " << path << ".");
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool MapFile::Open(const std::string& path)
+{
+  this->Close();
+  try
+  {
+    boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+    this->Region.reset(new boost::interprocess::mapped_region(mapping, boost::interprocess::read_only));
+  }
+  catch (const std::exception& e)
+  {
+    PRINT_ERROR("Unable to map file " << path << " (" << e.what() << ").");
+    this->Region.reset();
+    return false;
+  }
+
+  // Check header
+  const uint8_t* base = static_cast<const uint8_t*>(this->Region->get_address());
+  size_t fileSize = this->Region->get_size();
+  const Header* header = reinterpret_cast<const Header*>(base);
+  if (fileSize < sizeof(Header) || std::memcmp(header->Magic, FileMagic, sizeof(FileMagic)))
+  {
+    PRINT_ERROR(path << " is not a SLAM map file.");
+    this->Region.reset();
+    return false;
+  }
+  if (header->Version != FormatVersion || header->PointRecordSize != sizeof(PointRecord))
+  {
+    PRINT_ERROR("Unsupported version of SLAM map file " << path << " (version " << header->Version << ").");
+    this->Region.reset();
+    return false;
+  }
+  // Check sections fit in file, without overflowing sizes computation.
+  // Sections must be aligned to be read in place.
+  if (header->IndexOffset < sizeof(Header) || header->IndexOffset % alignof(VoxelRecord) ||
+      header->PointsOffset % alignof(PointRecord) ||
+      header->IndexOffset > header->PointsOffset || header->PointsOffset > fileSize ||
+      header->NbVoxels > (header->PointsOffset - header->IndexOffset) / sizeof(VoxelRecord) ||
+      header->NbPoints > (fileSize - header->PointsOffset) / sizeof(PointRecord))
+  {
+    PRINT_ERROR("SLAM map file " << path << " is truncated.");
+    this->Region.reset();
+    return false;
+  }
+
+  // Check index : voxels must be sorted without duplicates, and their points
+  // must be in the points section
+  const VoxelRecord* voxels = reinterpret_cast<const VoxelRecord*>(base + header->IndexOffset);
+  for (uint64_t i = 0; i < header->NbVoxels; ++i)
+  {
+    const VoxelRecord& voxel = voxels[i];
+    if (voxel.FirstPoint > header->NbPoints || voxel.NbPoints > header->NbPoints - voxel.FirstPoint ||
+        (i > 0 && !(voxels[i - 1] < voxel)))
+    {
+      PRINT_ERROR("SLAM map file " << path << " has an invalid index (outer voxel #" << i << ").");
+      this->Region.reset();
+      return false;
+    }
+  }
+
+  this->Path = path;
+  this->FileHeader = header;
+  this->Voxels = voxels;
+  this->Points = reinterpret_cast<const PointRecord*>(base + header->PointsOffset);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void MapFile::Close()
+{
+  this->Region.reset();
+  this->Path.clear();
+  this->FileHeader = nullptr;
+  this->Voxels = nullptr;
+  this->Points = nullptr;
+}
+
+//------------------------------------------------------------------------------
+const MapFile::VoxelRecord* MapFile::FindVoxel(const Eigen::Array3i& coords) const
+{
+  if (!this->IsOpen())
+    return nullptr;
+  const VoxelRecord* end = this->Voxels + this->FileHeader->NbVoxels;
+  VoxelRecord key{coords.x(), coords.y(), coords.z(), 0, 0};
+  const VoxelRecord* it = std::lower_bound(this->Voxels, end, key);
+  if (it == end || key < *it)
+    return nullptr;
+  return it;
+}
+
+//------------------------------------------------------------------------------
+std::vector<const MapFile::VoxelRecord*> MapFile::FindVoxels(const Eigen::Array3i& minCoords, const Eigen::Array3i& maxCoords) const
+{
+  std::vector<const VoxelRecord*> voxels;
+  if (!this->IsOpen() || (minCoords > maxCoords).any())
+    return voxels;
+  const VoxelRecord* begin = this->Voxels;
+  const VoxelRecord* end = this->Voxels + this->FileHeader->NbVoxels;
+  auto isInside = [&](const VoxelRecord& v)
+  {
+    return minCoords.x() <= v.X && v.X <= maxCoords.x() &&
+           minCoords.y() <= v.Y && v.Y <= maxCoords.y() &&
+           minCoords.z() <= v.Z && v.Z <= maxCoords.z();
+  };
+
+  // Only the voxels with z in range are candidates
+  begin = std::lower_bound(begin, end, VoxelRecord{std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min(), minCoords.z(), 0, 0});
+  end   = std::upper_bound(begin, end, VoxelRecord{std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(), maxCoords.z(), 0, 0});
+
+  // If there are few candidates compared to the number of (y, z) rows of the
+  // box, scan them all. Otherwise, binary search the beginning of each row.
+  double nbRows = double(maxCoords.y() - minCoords.y() + 1) * (maxCoords.z() - minCoords.z() + 1);
+  if (nbRows * std::log2(std::max<double>(end - begin, 2.)) > end - begin)
+  {
+    for (const VoxelRecord* it = begin; it != end; ++it)
+      if (isInside(*it))
+        voxels.push_back(it);
+    return voxels;
+  }
+  for (int z = minCoords.z(); z <= maxCoords.z(); ++z)
+  {
+    for (int y = minCoords.y(); y <= maxCoords.y(); ++y)
+    {
+      const VoxelRecord* it = std::lower_bound(begin, end, VoxelRecord{minCoords.x(), y, z, 0, 0});
+      for (; it != end && it->Z == z && it->Y == y && it->X <= maxCoords.x(); ++it)
+        voxels.push_back(it);
+      begin = it;
+    }
+  }
+  return voxels;
+}
+
+} // end of LidarSlam namespace
@@ -0,0 +1,375 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlam/PointCloudCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace LidarSlam
+{
+namespace Codec
+{
+
+namespace
+{
+// Identifier and version of the binary format
+constexpr char MAGIC[4] = {'L', 'P', 'C', '1'};
+
+//-----------------------------------------------------------------------------
+// Binary buffer writer
+//-----------------------------------------------------------------------------
+struct Writer
+{
+  std::vector<uint8_t> Buffer;
+
+  void Bytes(const void* data, size_t size)
+  {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    this->Buffer.insert(this->Buffer.end(), bytes, bytes + size);
+  }
+
+  template<typename T>
+  void Raw(T value) { this->Bytes(&value, sizeof(T)); }
+
+  // LEB128 variable length unsigned integer : 7 bits per byte
+  void Varint(uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      this->Buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    this->Buffer.push_back(static_cast<uint8_t>(value));
+  }
+
+  // Zigzag mapping of signed integers, so that small negative values stay small
+  void SignedVarint(int64_t value) { this->Varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+};
+
+//-----------------------------------------------------------------------------
+// Bounds-checked binary buffer reader
+//-----------------------------------------------------------------------------
+struct Reader
+{
+  const uint8_t* Data;
+  const uint8_t* End;
+  bool Valid = true;
+
+  Reader(const uint8_t* data, size_t size) : Data(data), End(data + size) {}
+
+  bool Bytes(void* data, size_t size)
+  {
+    if (!this->Valid || static_cast<size_t>(this->End - this->Data) < size)
+      return this->Valid = false;
+    std::memcpy(data, this->Data, size);
+    this->Data += size;
+    return true;
+  }
+
+  template<typename T>
+  T Raw()
+  {
+    T value = T();
+    this->Bytes(&value, sizeof(T));
+    return value;
+  }
+
+  uint64_t Varint()
+  {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+      if (this->Data == this->End)
+        break;
+      uint8_t byte = *this->Data++;
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    this->Valid = false;
+    return 0;
+  }
+
+  int64_t SignedVarint()
+  {
+    uint64_t value = this->Varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+};
+
+//-----------------------------------------------------------------------------
+inline int64_t Quantize(double value, double precision)
+{
+  // Non finite values, or values out of the integers range,
+  // can not be quantized : they are replaced by 0
+  double quantized = value / precision;
+  return std::abs(quantized) < 9e18 ? std::llround(quantized) : 0;
+}
+
+//-----------------------------------------------------------------------------
+inline uint32_t FloatBits(float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  return bits;
+}
+
+//-----------------------------------------------------------------------------
+inline float BitsFloat(uint32_t bits)
+{
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+// Run-length encode a 8 bits field of the points of a block
+template<typename Getter>
+void EncodeRuns(Writer& writer, const PointCloud& cloud, size_t begin, size_t end, Getter get)
+{
+  size_t i = begin;
+  while (i < end)
+  {
+    uint8_t value = get(cloud[i]);
+    size_t run = 1;
+    while (i + run < end && get(cloud[i + run]) == value)
+      ++run;
+    writer.Raw<uint8_t>(value);
+    writer.Varint(run);
+    i += run;
+  }
+}
+
+//-----------------------------------------------------------------------------
+template<typename Setter>
+bool DecodeRuns(Reader& reader, PointCloud& cloud, size_t begin, size_t end, Setter set)
+{
+  size_t i = begin;
+  while (i < end && reader.Valid)
+  {
+    uint8_t value = reader.Raw<uint8_t>();
+    uint64_t run = reader.Varint();
+    if (run == 0 || run > end - i)
+      return false;
+    for (size_t j = 0; j < run; ++j)
+      set(cloud[i + j], value);
+    i += run;
+  }
+  return reader.Valid;
+}
+
+//-----------------------------------------------------------------------------
+void EncodeBlock(const PointCloud& cloud, size_t begin, size_t end,
+                 double positionPrecision, double timePrecision, Writer& writer)
+{
+  // Time is relative to the first point of the block
+  double startTime = cloud[begin].time;
+  writer.Raw<double>(startTime);
+
+  // Delta code quantized coordinates/time, intensity bits and laser ids
+  int64_t prevX = 0, prevY = 0, prevZ = 0, prevT = 0;
+  uint32_t prevIntensity = 0;
+  int64_t prevLaserId = 0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    const Point& p = cloud[i];
+    int64_t x = Quantize(p.x, positionPrecision);
+    int64_t y = Quantize(p.y, positionPrecision);
+    int64_t z = Quantize(p.z, positionPrecision);
+    int64_t t = Quantize(p.time - startTime, timePrecision);
+    uint32_t intensity = FloatBits(p.intensity);
+    writer.SignedVarint(x - prevX);
+    writer.SignedVarint(y - prevY);
+    writer.SignedVarint(z - prevZ);
+    writer.SignedVarint(t - prevT);
+    // XOR with previous value keeps common sign/exponent bits null
+    writer.Varint(intensity ^ prevIntensity);
+    writer.SignedVarint(p.laser_id - prevLaserId);
+    prevX = x; prevY = y; prevZ = z; prevT = t;
+    prevIntensity = intensity;
+    prevLaserId = p.laser_id;
+  }
+
+  // Device ids and labels are mostly constant
+  EncodeRuns(writer, cloud, begin, end, [](const Point& p) { return p.device_id; });
+  EncodeRuns(writer, cloud, begin, end, [](const Point& p) { return p.label; });
+}
+
+//-----------------------------------------------------------------------------
+bool DecodeBlock(Reader& reader, size_t begin, size_t end,
+                 double positionPrecision, double timePrecision, PointCloud& cloud)
+{
+  double startTime = reader.Raw<double>();
+
+  int64_t x = 0, y = 0, z = 0, t = 0;
+  uint32_t intensity = 0;
+  int64_t laserId = 0;
+  for (size_t i = begin; i < end && reader.Valid; ++i)
+  {
+    x += reader.SignedVarint();
+    y += reader.SignedVarint();
+    z += reader.SignedVarint();
+    t += reader.SignedVarint();
+    intensity ^= static_cast<uint32_t>(reader.Varint());
+    laserId += reader.SignedVarint();
+    Point& p = cloud[i];
+    p.x = x * positionPrecision;
+    p.y = y * positionPrecision;
+    p.z = z * positionPrecision;
+    p.time = startTime + t * timePrecision;
+    p.intensity = BitsFloat(intensity);
+    p.laser_id = static_cast<std::uint16_t>(laserId);
+  }
+
+  return DecodeRuns(reader, cloud, begin, end, [](Point& p, uint8_t v) { p.device_id = v; }) &&
+         DecodeRuns(reader, cloud, begin, end, [](Point& p, uint8_t v) { p.label = v; });
+}
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+std::vector<uint8_t> Encode(const PointCloud& cloud, const Parameters& params)
+{
+  const size_t nbPoints = cloud.size();
+  const size_t blockSize = std::max(params.BlockSize, 1u);
+  const int nbBlocks = (nbPoints + blockSize - 1) / blockSize;
+
+  // Invalid precisions are replaced by the default ones
+  const double positionPrecision = Parameters::IsPrecisionValid(params.PositionPrecision) ? params.PositionPrecision
+                                                                                          : Parameters().PositionPrecision;
+  const double timePrecision = Parameters::IsPrecisionValid(params.TimePrecision) ? params.TimePrecision
+                                                                                  : Parameters().TimePrecision;
+
+  // Encode blocks independently
+  std::vector<Writer> blocks(nbBlocks);
+  #pragma omp parallel for num_threads(params.NbThreads) schedule(static)
+  for (int b = 0; b < nbBlocks; ++b)
+  {
+    size_t begin = b * blockSize;
+    size_t end = std::min(begin + blockSize, nbPoints);
+    EncodeBlock(cloud, begin, end, positionPrecision, timePrecision, blocks[b]);
+  }
+
+  // Write header
+  Writer writer;
+  writer.Bytes(MAGIC, sizeof(MAGIC));
+  writer.Varint(nbPoints);
+  writer.Varint(blockSize);
+  writer.Varint(cloud.width);
+  writer.Varint(cloud.height);
+  writer.Raw<uint8_t>(cloud.is_dense);
+  writer.Raw<double>(positionPrecision);
+  writer.Raw<double>(timePrecision);
+  writer.Varint(cloud.header.seq);
+  writer.Raw<uint64_t>(cloud.header.stamp);
+  writer.Varint(cloud.header.frame_id.size());
+  writer.Bytes(cloud.header.frame_id.data(), cloud.header.frame_id.size());
+
+  // Write blocks sizes, then blocks data
+  size_t totalSize = writer.Buffer.size() + 10 * nbBlocks;
+  for (const Writer& block : blocks)
+  {
+    writer.Varint(block.Buffer.size());
+    totalSize += block.Buffer.size();
+  }
+  writer.Buffer.reserve(totalSize);
+  for (const Writer& block : blocks)
+    writer.Bytes(block.Buffer.data(), block.Buffer.size());
+
+  writer.Buffer.shrink_to_fit();
+  return std::move(writer.Buffer);
+}
+
+//-----------------------------------------------------------------------------
+bool Decode(const std::vector<uint8_t>& data, PointCloud& cloud, int nbThreads)
+{
+  cloud.clear();
+  Reader reader(data.data(), data.size());
+
+  // Read header
+  char magic[sizeof(MAGIC)];
+  if (!reader.Bytes(magic, sizeof(MAGIC)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    return false;
+  const uint64_t nbPoints = reader.Varint();
+  const uint64_t blockSize = reader.Varint();
+  const uint32_t width = reader.Varint();
+  const uint32_t height = reader.Varint();
+  const bool isDense = reader.Raw<uint8_t>();
+  const double positionPrecision = reader.Raw<double>();
+  const double timePrecision = reader.Raw<double>();
+  pcl::PCLHeader header;
+  header.seq = reader.Varint();
+  header.stamp = reader.Raw<uint64_t>();
+  const uint64_t frameIdSize = reader.Varint();
+  // Each encoded point takes at least 6 bytes.
+  // The block size is encoded from an unsigned int : bounding it also makes sure
+  // the number of blocks computation does not overflow.
+  if (!reader.Valid || blockSize == 0 || nbPoints > data.size() / 6 ||
+      blockSize > std::numeric_limits<unsigned int>::max() ||
+      !Parameters::IsPrecisionValid(positionPrecision) || !Parameters::IsPrecisionValid(timePrecision) ||
+      frameIdSize > static_cast<size_t>(reader.End - reader.Data))
+    return false;
+  header.frame_id.resize(frameIdSize);
+  reader.Bytes(&header.frame_id[0], frameIdSize);
+
+  // Read blocks positions
+  const int nbBlocks = (nbPoints + blockSize - 1) / blockSize;
+  std::vector<const uint8_t*> blocksStart(nbBlocks);
+  std::vector<size_t> blocksSize(nbBlocks);
+  for (int b = 0; b < nbBlocks && reader.Valid; ++b)
+    blocksSize[b] = reader.Varint();
+  const uint8_t* blockStart = reader.Data;
+  for (int b = 0; b < nbBlocks; ++b)
+  {
+    if (!reader.Valid || blocksSize[b] > static_cast<size_t>(reader.End - blockStart))
+      return false;
+    blocksStart[b] = blockStart;
+    blockStart += blocksSize[b];
+  }
+
+  // Decode blocks in parallel, directly into the output cloud
+  cloud.resize(nbPoints);
+  int valid = 1;
+  #pragma omp parallel for num_threads(nbThreads) schedule(static) reduction(&&:valid)
+  for (int b = 0; b < nbBlocks; ++b)
+  {
+    Reader blockReader(blocksStart[b], blocksSize[b]);
+    size_t begin = b * blockSize;
+    size_t end = std::min<size_t>(begin + blockSize, nbPoints);
+    valid = DecodeBlock(blockReader, begin, end, positionPrecision, timePrecision, cloud) && valid;
+  }
+  if (!valid)
+  {
+    cloud.clear();
+    return false;
+  }
+
+  cloud.header = header;
+  cloud.is_dense = isDense;
+  if (static_cast<uint64_t>(width) * height == nbPoints)
+  {
+    cloud.width = width;
+    cloud.height = height;
+  }
+  return true;
+}
+
+} // end of Codec namespace
+} // end of LidarSlam namespace
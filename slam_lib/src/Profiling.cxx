@@ -0,0 +1,147 @@
+//==============================================================================
+// Copyright 2019-2020 Kitware, Inc., Kitware SAS
+// Creation date: 2026-10-18
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//==============================================================================
+
+#include "LidarSlam/Profiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace LidarSlam
+{
+namespace Profiling
+{
+
+//==============================================================================
+//   LatencyHistogram
+//==============================================================================
+
+constexpr int LatencyHistogram::SubBucketBits;
+constexpr uint64_t LatencyHistogram::SubBucketHalfCount;
+constexpr int LatencyHistogram::MaxValueBits;
+constexpr int LatencyHistogram::NbBuckets;
+
+//------------------------------------------------------------------------------
+void LatencyHistogram::Record(double duration)
+{
+  // Convert to µs, clamping to the recordable range
+  constexpr uint64_t maxValue = (uint64_t(1) << MaxValueBits) - 1;
+  double us = std::round(std::max(duration, 0.) * 1e6);
+  uint64_t value = us < maxValue ? static_cast<uint64_t>(us) : maxValue;
+
+  this->Counts[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  this->Count.fetch_add(1, std::memory_order_relaxed);
+  this->Sum.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = this->Max.load(std::memory_order_relaxed);
+  while (value > max && !this->Max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+void LatencyHistogram::Reset()
+{
+  for (auto& count : this->Counts)
+    count.store(0, std::memory_order_relaxed);
+  this->Count.store(0, std::memory_order_relaxed);
+  this->Sum.store(0, std::memory_order_relaxed);
+  this->Max.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+Statistics LatencyHistogram::GetStatistics() const
+{
+  Statistics stats;
+  stats.Count = this->Count.load(std::memory_order_relaxed);
+  if (!stats.Count)
+    return stats;
+
+  // Durations are stored in µs, statistics are given in ms
+  double max = this->Max.load(std::memory_order_relaxed);
+  stats.Mean = 1e-3 * this->Sum.load(std::memory_order_relaxed) / stats.Count;
+  stats.Max  = 1e-3 * max;
+  stats.P50  = 1e-3 * std::min<double>(this->Percentile(0.50, stats.Count), max);
+  stats.P95  = 1e-3 * std::min<double>(this->Percentile(0.95, stats.Count), max);
+  stats.P99  = 1e-3 * std::min<double>(this->Percentile(0.99, stats.Count), max);
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+int LatencyHistogram::BucketIndex(uint64_t value)
+{
+  // Values below 2 * SubBucketHalfCount are stored exactly
+  if (value < 2 * SubBucketHalfCount)
+    return static_cast<int>(value);
+
+  // Other values are stored in the range of their most significant bit,
+  // with SubBucketBits significant bits
+  int msb = 0;
+  while (value >> (msb + 1))
+    ++msb;
+  int shift = msb - (SubBucketBits - 1);
+  return shift * SubBucketHalfCount + static_cast<int>(value >> shift);
+}
+
+//------------------------------------------------------------------------------
+uint64_t LatencyHistogram::BucketUpperBound(int index)
+{
+  if (index < static_cast<int>(2 * SubBucketHalfCount))
+    return index;
+  int shift = index / SubBucketHalfCount - 1;
+  uint64_t subBucket = index - shift * SubBucketHalfCount;
+  return ((subBucket + 1) << shift) - 1;
+}
+
+//------------------------------------------------------------------------------
+uint64_t LatencyHistogram::Percentile(double percentile, uint64_t count) const
+{
+  // Rank of the requested value among the sorted recorded values
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(percentile * count));
+  uint64_t cumulatedCount = 0;
+  for (int i = 0; i < NbBuckets; ++i)
+  {
+    cumulatedCount += this->Counts[i].load(std::memory_order_relaxed);
+    if (cumulatedCount >= rank)
+      return BucketUpperBound(i);
+  }
+  // Concurrent records may make the total count exceed the buckets count
+  return this->Max.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+//   Profiler
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void Profiler::Reset()
+{
+  for (auto& histogram : this->Histograms)
+    histogram.Reset();
+}
+
+//------------------------------------------------------------------------------
+std::map<std::string, Statistics> Profiler::GetStatistics() const
+{
+  std::map<std::string, Statistics> statistics;
+  for (const auto& stageName : StageNames)
+  {
+    Statistics stats = this->Histograms[stageName.first].GetStatistics();
+    if (stats.Count)
+      statistics[stageName.second] = stats;
+  }
+  return statistics;
+}
+
+} // end of Profiling namespace
+} // end of LidarSlam namespace
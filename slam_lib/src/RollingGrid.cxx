@@ -22,9 +22,120 @@
 
 #include <pcl/common/common.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
 namespace LidarSlam
 {
 
+namespace
+{
+// Pack/unpack global outer voxel coordinates in 64 bits (21 bits per axis)
+constexpr int CoordsBits = 21;
+constexpr int CoordsOffset = 1 << (CoordsBits - 1);
+constexpr uint64_t CoordsMask = (uint64_t(1) << CoordsBits) - 1;
+
+inline uint64_t PackCoords(const Eigen::Array3i& coords)
+{
+  return  (uint64_t(coords.x() + CoordsOffset) & CoordsMask) |
+         ((uint64_t(coords.y() + CoordsOffset) & CoordsMask) << CoordsBits) |
+         ((uint64_t(coords.z() + CoordsOffset) & CoordsMask) << (2 * CoordsBits));
+}
+
+inline Eigen::Array3i UnpackCoords(uint64_t key)
+{
+  return Eigen::Array3i(int( key                     & CoordsMask) - CoordsOffset,
+                        int((key >> CoordsBits)      & CoordsMask) - CoordsOffset,
+                        int((key >> (2 * CoordsBits)) & CoordsMask) - CoordsOffset);
+}
+}
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Paging state of a RollingGrid : the mapped file, the loaded tiles and
+ *        the background thread loading the requested tiles.
+ *
+ * Tiles are the outer voxels of the map file, identified by their index entry.
+ * Reading a tile from the mapping is what pages it in from disk : this is done
+ * by the background thread for the prefetched tiles, which are then added to
+ * the grid by UpdatePaging.
+ */
+struct RollingGrid::Pager
+{
+  using Tile = const MapFile::VoxelRecord*;
+
+  Pager(bool fixed) : Fixed(fixed), Thread(&Pager::Run, this) {}
+
+  ~Pager()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+    }
+    this->TileRequested.notify_one();
+    this->Thread.join();
+  }
+
+  //! Replace the pending requests by the given tiles (skipping the ready ones)
+  void Request(const std::vector<Tile>& tiles)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Requests.clear();
+      for (Tile tile : tiles)
+      {
+        if (!this->Ready.count(tile))
+          this->Requests.push_back(tile);
+      }
+    }
+    this->TileRequested.notify_one();
+  }
+
+  //! Get the tiles loaded by the background thread since last call
+  std::unordered_map<Tile, SamplingVG> TakeReady()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    std::unordered_map<Tile, SamplingVG> ready;
+    ready.swap(this->Ready);
+    return ready;
+  }
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (true)
+    {
+      this->TileRequested.wait(lock, [this]{ return this->Stop || !this->Requests.empty(); });
+      if (this->Stop)
+        return;
+      Tile tile = this->Requests.front();
+      this->Requests.pop_front();
+      lock.unlock();
+      SamplingVG innerVoxels = RollingGrid::ReadVoxel(this->File, *tile, this->Fixed);
+      lock.lock();
+      this->Ready[tile] = std::move(innerVoxels);
+    }
+  }
+
+  MapFile File;                                   ///< Mapped map file, opened before any request
+  const bool Fixed;                               ///< Whether the paged points are fixed
+  std::unordered_set<Tile> Loaded;                ///< Tiles currently in grid (main thread only)
+  std::unordered_set<Tile> Indexed;               ///< Tiles needed around the current position, on which the KD-tree is built (main thread only)
+  bool BudgetWarned = false;                      ///< True if the memory budget has already been exceeded
+
+  std::deque<Tile> Requests;                      ///< Tiles to load in background
+  std::unordered_map<Tile, SamplingVG> Ready;     ///< Tiles loaded in background, not yet added to grid
+  std::mutex Mutex;                               ///< Protects Requests, Ready and Stop
+  std::condition_variable TileRequested;          ///< Notified when tiles are requested or when stopping
+  bool Stop = false;                              ///< True if the background thread must stop
+  std::thread Thread;                             ///< Background thread. Must be the last member, as it starts on construction.
+};
+
 //==============================================================================
 //   Initialization and parameters setters
 //==============================================================================
@@ -43,6 +154,7 @@ void RollingGrid::Reset(const Eigen::Vector3f& position)
 {
   // Clear/reset empty voxel grid
   this->Clear();
+  this->Paging.reset();
 
   // Initialize VoxelGrid center position
   // Position is rounded down to be a multiple of resolution
@@ -55,6 +167,60 @@ void RollingGrid::Clear()
   this->NbPoints = 0;
   this->Voxels.clear();
   this->KdTree.Reset();
+  // The whole grid will be needed to describe the changes
+  this->ModifiedVoxels.clear();
+  this->ChangesReset = true;
+  // Paged tiles will be loaded back at next update
+  if (this->Paging)
+  {
+    this->Paging->Loaded.clear();
+    this->Paging->Indexed.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::CopyParameters(const RollingGrid& other)
+{
+  this->Clear();
+  this->GridSize = other.GridSize;
+  this->GridInSize = other.GridInSize;
+  this->VoxelResolution = other.VoxelResolution;
+  this->VoxelWidth = other.VoxelWidth;
+  this->LeafSize = other.LeafSize;
+  this->MinFramesPerVoxel = other.MinFramesPerVoxel;
+  this->Sampling = other.Sampling;
+  this->DecayingThreshold = other.DecayingThreshold;
+  this->VoxelGridPosition = (this->VoxelGridPosition / this->VoxelWidth).floor() * this->VoxelWidth;
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::CopyPoints(const RollingGrid& other)
+{
+  this->Clear();
+  this->Voxels = other.Voxels;
+  this->VoxelGridPosition = other.VoxelGridPosition;
+  this->NbPoints = other.NbPoints;
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::SwapPoints(RollingGrid& other)
+{
+  std::swap(this->Voxels, other.Voxels);
+  std::swap(this->VoxelGridPosition, other.VoxelGridPosition);
+  std::swap(this->NbPoints, other.NbPoints);
+  for (RollingGrid* grid : {this, &other})
+  {
+    grid->KdTree.Reset();
+    // The whole grid will be needed to describe the changes
+    grid->ModifiedVoxels.clear();
+    grid->ChangesReset = true;
+    // Paged tiles will be loaded back at next update
+    if (grid->Paging)
+    {
+      grid->Paging->Loaded.clear();
+      grid->Paging->Indexed.clear();
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -166,6 +332,12 @@ void RollingGrid::Roll(const Eigen::Array3f& minPoint, const Eigen::Array3f& max
       newNbPoints += kvOut.second.size();
       newVoxels[newIdx1d] = std::move(kvOut.second);
     }
+    else
+    {
+      this->SetModified(kvOut.first);
+      if (this->RollOutCallback && !kvOut.second.empty())
+        this->RollOutCallback(this->To3d(kvOut.first, this->GridSize) + this->GetVoxelGridOriginCoords(), kvOut.second);
+    }
   }
 
   // Update the voxel grid
@@ -175,7 +347,7 @@ void RollingGrid::Roll(const Eigen::Array3f& minPoint, const Eigen::Array3f& max
 }
 
 //------------------------------------------------------------------------------
-void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
+void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll, PointCloud* validatedPoints)
 {
   if (pointcloud->empty())
   {
@@ -191,6 +363,176 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
     this->Roll(minPoint.head<3>().cast<float>().array(), maxPoint.head<3>().cast<float>().array());
   }
 
+  // Clear the deprecated KD-tree if the map has been updated
+  std::unordered_set<int> updatedVoxels;
+  std::vector<std::pair<int, int>> validatedVoxels;
+  if (this->AddPoints(*pointcloud, fixed, this->Voxels, this->NbPoints, nullptr, this->TrackChanges ? &updatedVoxels : nullptr,
+                      validatedPoints ? &validatedVoxels : nullptr))
+    this->KdTree.Reset();
+  for (int idxOut : updatedVoxels)
+    this->SetModified(idxOut);
+
+  // Extract the newly validated points, once all points have been added
+  if (validatedPoints)
+  {
+    validatedPoints->reserve(validatedPoints->size() + validatedVoxels.size());
+    for (const auto& idx : validatedVoxels)
+      validatedPoints->push_back(this->Voxels[idx.first][idx.second].point);
+  }
+}
+
+//------------------------------------------------------------------------------
+bool RollingGrid::IsOccupied(const Eigen::Array3f& position) const
+{
+  // Find the outer voxel containing this point, as when adding points
+  Eigen::Array3f voxelGridOrigin = this->VoxelGridPosition - int(this->GridSize / 2) * this->VoxelWidth;
+  Eigen::Array3i voxelCoordOut = Utils::PositionToVoxel<Eigen::Array3f>(position, voxelGridOrigin, this->VoxelWidth);
+  if (((voxelCoordOut < 0) || (voxelCoordOut >= this->GridSize)).any())
+    return false;
+  auto itOut = this->Voxels.find(this->To1d(voxelCoordOut, this->GridSize));
+  if (itOut == this->Voxels.end())
+    return false;
+
+  // Find the inner voxel containing this point
+  Eigen::Array3f voxelGridCenterIn = voxelCoordOut.cast<float>() * this->VoxelWidth + voxelGridOrigin;
+  Eigen::Array3i voxelCoordIn = Utils::PositionToVoxel<Eigen::Array3f>(position, voxelGridCenterIn, this->LeafSize);
+  return itOut->second.count(this->To1d(voxelCoordIn, this->GridInSize));
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::Add(const std::vector<PointCloud::ConstPtr>& pointclouds, bool fixed, int nbThreads, bool roll)
+{
+  if (!roll)
+  {
+    this->AddInParallel(pointclouds.begin(), pointclouds.end(), fixed, nbThreads);
+    return;
+  }
+
+  // Compute the bounding box of each pointcloud
+  int nbClouds = pointclouds.size();
+  std::vector<Eigen::Array3f> minPoints(nbClouds), maxPoints(nbClouds);
+  #pragma omp parallel for num_threads(std::max(nbThreads, 1))
+  for (int i = 0; i < nbClouds; ++i)
+  {
+    minPoints[i] = Eigen::Array3f::Constant(std::numeric_limits<float>::max());
+    maxPoints[i] = Eigen::Array3f::Constant(std::numeric_limits<float>::lowest());
+    for (const Point& point : *pointclouds[i])
+    {
+      minPoints[i] = minPoints[i].min(point.getArray3fMap());
+      maxPoints[i] = maxPoints[i].max(point.getArray3fMap());
+    }
+  }
+
+  // Split the pointclouds in consecutive groups whose bounding box fits in the
+  // grid. The grid is rolled onto each group before adding it, so that it
+  // follows the pointclouds and ends up around the last ones.
+  float gridWidth = (this->GridSize - 1) * this->VoxelWidth;
+  auto groupBegin = pointclouds.begin();
+  Eigen::Array3f groupMin = Eigen::Array3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Array3f groupMax = Eigen::Array3f::Constant(std::numeric_limits<float>::lowest());
+  for (int i = 0; i < nbClouds; ++i)
+  {
+    if (pointclouds[i]->empty())
+      continue;
+    Eigen::Array3f newMin = groupMin.min(minPoints[i]);
+    Eigen::Array3f newMax = groupMax.max(maxPoints[i]);
+    auto it = pointclouds.begin() + i;
+    if (((newMax - newMin) > gridWidth).any() && it != groupBegin && (groupMin <= groupMax).all())
+    {
+      this->Roll(groupMin, groupMax);
+      this->AddInParallel(groupBegin, it, fixed, nbThreads);
+      groupBegin = it;
+      newMin = minPoints[i];
+      newMax = maxPoints[i];
+    }
+    groupMin = newMin;
+    groupMax = newMax;
+  }
+  if ((groupMin <= groupMax).all())
+  {
+    this->Roll(groupMin, groupMax);
+    this->AddInParallel(groupBegin, pointclouds.end(), fixed, nbThreads);
+  }
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::AddInParallel(CloudsIterator begin, CloudsIterator end, bool fixed, int nbThreads)
+{
+  // With CENTROID sampling, the update of a voxel point depends on all points
+  // added to the grid, not only on the ones lying in this voxel :
+  // voxels can not be split between threads.
+  if (this->Sampling == SamplingMode::CENTROID)
+    nbThreads = 1;
+  nbThreads = std::max(nbThreads, 1);
+
+  // Split current voxels between threads
+  std::vector<RollingVG> partVoxels(nbThreads);
+  std::vector<unsigned int> partNbPoints(nbThreads, 0);
+  std::vector<std::unordered_set<int>> partUpdatedVoxels(nbThreads);
+  for (auto& kvOut : this->Voxels)
+  {
+    int part = kvOut.first % nbThreads;
+    partNbPoints[part] += kvOut.second.size();
+    partVoxels[part][kvOut.first] = std::move(kvOut.second);
+  }
+  this->Voxels.clear();
+
+  // Split the points of each pointcloud between threads, according to the
+  // owner of the outer voxel they lie in. The points out of the grid are dropped.
+  const int nbClouds = std::distance(begin, end);
+  std::vector<std::vector<std::vector<int>>> partIndices(nbThreads, std::vector<std::vector<int>>(nbClouds));
+  if (nbThreads > 1)
+  {
+    Eigen::Array3f voxelGridOrigin = this->VoxelGridPosition - int(this->GridSize / 2) * this->VoxelWidth;
+    #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+    for (int i = 0; i < nbClouds; ++i)
+    {
+      const PointCloud& cloud = **(begin + i);
+      for (int j = 0; j < static_cast<int>(cloud.size()); ++j)
+      {
+        Eigen::Array3i voxelCoordOut = Utils::PositionToVoxel<Eigen::Array3f>(cloud[j].getArray3fMap(), voxelGridOrigin, this->VoxelWidth);
+        if (((0 <= voxelCoordOut) && (voxelCoordOut < this->GridSize)).all())
+          partIndices[this->To1d(voxelCoordOut, this->GridSize) % nbThreads][i].push_back(j);
+      }
+    }
+  }
+
+  // Each thread adds its own points of all pointclouds in order, to its own voxels
+  int updated = 0;
+  #pragma omp parallel for num_threads(nbThreads) schedule(static, 1) reduction(||:updated)
+  for (int part = 0; part < nbThreads; ++part)
+  {
+    for (int i = 0; i < nbClouds; ++i)
+    {
+      const PointCloud& cloud = **(begin + i);
+      const std::vector<int>* indices = nbThreads > 1 ? &partIndices[part][i] : nullptr;
+      if (!cloud.empty() && (!indices || !indices->empty()))
+        updated = this->AddPoints(cloud, fixed, partVoxels[part], partNbPoints[part], indices,
+                                  this->TrackChanges ? &partUpdatedVoxels[part] : nullptr) || updated;
+    }
+  }
+
+  // Merge disjoint voxels back
+  this->NbPoints = 0;
+  for (int part = 0; part < nbThreads; ++part)
+  {
+    this->NbPoints += partNbPoints[part];
+    for (auto& kvOut : partVoxels[part])
+      this->Voxels[kvOut.first] = std::move(kvOut.second);
+    for (int idxOut : partUpdatedVoxels[part])
+      this->SetModified(idxOut);
+  }
+
+  // Clear the deprecated KD-tree if the map has been updated
+  if (updated)
+    this->KdTree.Reset();
+}
+
+//------------------------------------------------------------------------------
+bool RollingGrid::AddPoints(const PointCloud& pointcloud, bool fixed, RollingVG& voxels, unsigned int& nbPoints,
+                            const std::vector<int>* indices, std::unordered_set<int>* updatedVoxels,
+                            std::vector<std::pair<int, int>>* validatedVoxels) const
+{
   // Compute the 3D position of the center of the first voxel
   Eigen::Array3f voxelGridOrigin = this->VoxelGridPosition - int(this->GridSize / 2) * this->VoxelWidth;
 
@@ -203,8 +545,11 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
   // Boolean to check if the tree will need update
   bool updated = false;
   // Add points in the rolling grid
-  for (const Point& point : *pointcloud)
+  const int nbInputPoints = indices ? indices->size() : pointcloud.size();
+  for (int i = 0; i < nbInputPoints; ++i)
   {
+    const Point& point = pointcloud[indices ? (*indices)[i] : i];
+
     // Find the outer voxel containing this point
     Eigen::Array3i voxelCoordOut = Utils::PositionToVoxel<Eigen::Array3f>(point.getArray3fMap(), voxelGridOrigin, this->VoxelWidth);
 
@@ -218,19 +563,20 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
       Eigen::Array3i voxelCoordIn = Utils::PositionToVoxel<Eigen::Array3f>(point.getArray3fMap(), voxelGridCenterIn, this->LeafSize);
       unsigned int idxOut = this->To1d(voxelCoordOut, this->GridSize);
       unsigned int idxIn = this->To1d(voxelCoordIn, this->GridInSize);
+      bool pointUpdated = false;
       // If the outer voxel or the inner voxel are empty, add new point
-      if (!this->Voxels.count(idxOut) ||
-          !this->Voxels[idxOut].count(idxIn))
+      if (!voxels.count(idxOut) ||
+          !voxels[idxOut].count(idxIn))
       {
-        this->Voxels[idxOut][idxIn].point = point;
-        ++this->NbPoints;
+        voxels[idxOut][idxIn].point = point;
+        ++nbPoints;
         // Notify that the voxel point has been updated
-        updated = true;
+        pointUpdated = true;
       }
       else
       {
         // Shortcut to voxel
-        auto& voxel = this->Voxels[idxOut][idxIn];
+        auto& voxel = voxels[idxOut][idxIn];
 
         // Check if the voxel contains a fixed point
         if (voxel.point.label == 1)
@@ -252,7 +598,7 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
             // Update the point
             voxel.point = point;
             // Notify that the voxel point has been updated
-            updated = true;
+            pointUpdated = true;
             break;
           }
           // If max_intensity mode enabled,
@@ -263,7 +609,7 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
             {
               voxel.point = point;
               // Notify that the voxel point has been updated
-              updated = true;
+              pointUpdated = true;
             }
             break;
           }
@@ -277,7 +623,7 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
             {
               voxel.point = point;
               // Notify that the voxel point has been updated
-              updated = true;
+              pointUpdated = true;
             }
             break;
           }
@@ -293,12 +639,19 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
             ++v.count;
 
             // Notify that the voxel point has been updated
-            updated = true;
+            pointUpdated = true;
             break;
           }
         }
       }
 
+      if (pointUpdated)
+      {
+        updated = true;
+        if (updatedVoxels)
+          updatedVoxels->insert(idxOut);
+      }
+
       // For centroid mode, compute average point
       if (this->Sampling == SamplingMode::CENTROID)
       {
@@ -310,7 +663,7 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
           {
             unsigned int idxIn = vIn.first;
             // Get voxel using its coordinates
-            auto& voxel = this->Voxels[idxOut][idxIn];
+            auto& voxel = voxels[idxOut][idxIn];
             // Update the voxel point computing the centroid of all mean points laying in it
             voxel.point.getVector3fMap() = (voxel.point.getVector3fMap() * voxel.count + vIn.second.point.getVector3fMap()) / (voxel.count + 1);
           }
@@ -318,8 +671,8 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
       }
 
       // Shortcut to voxel
-      auto& voxel = this->Voxels[idxOut][idxIn];
-      voxel.point.time = Utils::PclStampToSec(pointcloud->header.stamp) + point.time;
+      auto& voxel = voxels[idxOut][idxIn];
+      voxel.point.time = Utils::PclStampToSec(pointcloud.header.stamp) + point.time;
       // Point added is not fixed
       if (fixed)
         voxel.point.label = 1;
@@ -330,13 +683,384 @@ void RollingGrid::Add(const PointCloud::Ptr& pointcloud, bool fixed, bool roll)
       {
         ++voxel.count;
         seen[idxOut][idxIn] = true;
+        // The voxel is now extracted by Get(true)
+        if (validatedVoxels && voxel.count == this->MinFramesPerVoxel + 1)
+          validatedVoxels->emplace_back(idxOut, idxIn);
       }
     }
   }
 
-  // Clear the deprecated KD-tree if the map has been updated
-  if (updated)
+  return updated;
+}
+
+//==============================================================================
+//   Native map file
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool RollingGrid::Save(const std::string& path) const
+{
+  Eigen::Array3i originCoords = this->GetVoxelGridOriginCoords();
+  std::vector<std::pair<Eigen::Array3i, const SamplingVG*>> voxels;
+  voxels.reserve(this->Voxels.size());
+  for (const auto& kvOut : this->Voxels)
+    voxels.emplace_back(this->To3d(kvOut.first, this->GridSize) + originCoords, &kvOut.second);
+  return this->SaveVoxels(path, voxels);
+}
+
+//------------------------------------------------------------------------------
+bool RollingGrid::SaveVoxels(const std::string& path, const std::vector<std::pair<Eigen::Array3i, const SamplingVG*>>& voxelsToSave) const
+{
+  // Build the outer voxels index, sorted by global coordinates.
+  // The position of each voxel in input is temporarily stored as its first point.
+  std::vector<MapFile::VoxelRecord> voxels;
+  voxels.reserve(voxelsToSave.size());
+  unsigned int nbPoints = 0;
+  for (unsigned int i = 0; i < voxelsToSave.size(); ++i)
+  {
+    const Eigen::Array3i& coords = voxelsToSave[i].first;
+    const SamplingVG& innerVoxels = *voxelsToSave[i].second;
+    if (innerVoxels.empty())
+      continue;
+    voxels.push_back({coords.x(), coords.y(), coords.z(),
+                      static_cast<uint32_t>(innerVoxels.size()), static_cast<uint64_t>(i)});
+    nbPoints += innerVoxels.size();
+  }
+  std::sort(voxels.begin(), voxels.end());
+
+  // Store the points of each outer voxel contiguously
+  std::vector<MapFile::PointRecord> points;
+  points.reserve(nbPoints);
+  Eigen::Array3f minPoint = Eigen::Array3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Array3f maxPoint = Eigen::Array3f::Constant(std::numeric_limits<float>::lowest());
+  for (auto& voxel : voxels)
+  {
+    const SamplingVG& innerVoxels = *voxelsToSave[voxel.FirstPoint].second;
+    voxel.FirstPoint = points.size();
+    for (const auto& kvIn : innerVoxels)
+    {
+      const Point& p = kvIn.second.point;
+      points.push_back({p.x, p.y, p.z, p.intensity, p.time,
+                        static_cast<uint32_t>(kvIn.first), kvIn.second.count,
+                        p.laser_id, p.device_id, p.label});
+      minPoint = minPoint.min(p.getArray3fMap());
+      maxPoint = maxPoint.max(p.getArray3fMap());
+    }
+  }
+
+  MapFile::Header header{};
+  header.LeafSize = this->LeafSize;
+  header.VoxelWidth = this->VoxelWidth;
+  header.GridInSize = this->GridInSize;
+  Eigen::Map<Eigen::Array3f>(header.MinPoint) = minPoint;
+  Eigen::Map<Eigen::Array3f>(header.MaxPoint) = maxPoint;
+  return MapFile::Write(path, header, voxels, points);
+}
+
+//------------------------------------------------------------------------------
+bool RollingGrid::Load(const std::string& path, bool fixed)
+{
+  // Map the file : only the header and the index are read at this point
+  MapFile mapFile;
+  if (!mapFile.Open(path))
+    return false;
+  const MapFile::Header& header = mapFile.GetHeader();
+  if (!header.NbPoints)
+  {
+    PRINT_WARNING("Map file " << path << " is empty, voxel grid not updated.");
+    return true;
+  }
+
+  // Roll the map so that the saved outer voxels can fit in rolled map.
+  // The grid holds the outer voxels whose centers lie in
+  // [VoxelGridPosition - GridSize / 2, VoxelGridPosition + GridSize / 2 - 1] (in voxels),
+  // so the bounds given to Roll are shifted to avoid dropping border voxels.
+  Eigen::Array3f minVoxel = Utils::PositionToVoxel<Eigen::Array3f>(Eigen::Map<const Eigen::Array3f>(header.MinPoint), Eigen::Array3f::Zero(), this->VoxelWidth).cast<float>();
+  Eigen::Array3f maxVoxel = Utils::PositionToVoxel<Eigen::Array3f>(Eigen::Map<const Eigen::Array3f>(header.MaxPoint), Eigen::Array3f::Zero(), this->VoxelWidth).cast<float>();
+  this->Roll((minVoxel - 0.25) * this->VoxelWidth, (maxVoxel + 0.75) * this->VoxelWidth);
+
+  // Get the saved outer voxels lying in the grid
+  Eigen::Array3i originCoords = this->GetVoxelGridOriginCoords();
+  std::vector<const MapFile::VoxelRecord*> voxels = mapFile.FindVoxels(originCoords, originCoords + this->GridSize - 1);
+
+  unsigned int prevNbPoints = this->NbPoints;
+  bool sameLayout = header.GridInSize == this->GridInSize && std::abs(header.LeafSize - this->LeafSize) < 1e-6;
+  if (sameLayout && this->Voxels.empty())
+  {
+    // Copy the voxels as they were saved : only the loaded outer voxels are read from disk
+    for (const MapFile::VoxelRecord* voxel : voxels)
+    {
+      Eigen::Array3i idx3d = Eigen::Array3i(voxel->X, voxel->Y, voxel->Z) - originCoords;
+      int idxOut = this->To1d(idx3d, this->GridSize);
+      SamplingVG& innerVoxels = this->Voxels[idxOut];
+      innerVoxels = ReadVoxel(mapFile, *voxel, fixed);
+      this->NbPoints += innerVoxels.size();
+      this->SetModified(idxOut);
+    }
+  }
+  else
+  {
+    // Downsample the saved points in the current grid
+    PointCloud cloud;
+    for (const MapFile::VoxelRecord* voxel : voxels)
+    {
+      for (const auto& kvIn : ReadVoxel(mapFile, *voxel, fixed))
+        cloud.push_back(kvIn.second.point);
+    }
+    std::unordered_set<int> updatedVoxels;
+    this->AddPoints(cloud, fixed, this->Voxels, this->NbPoints, nullptr, this->TrackChanges ? &updatedVoxels : nullptr);
+    for (int idxOut : updatedVoxels)
+      this->SetModified(idxOut);
+  }
+
+  if (this->NbPoints != prevNbPoints)
     this->KdTree.Reset();
+  if (voxels.size() < header.NbVoxels)
+    PRINT_WARNING("Only " << voxels.size() << " of the " << header.NbVoxels << " outer voxels of map file "
+                  << path << " fit in the rolling grid.");
+  return true;
+}
+
+//------------------------------------------------------------------------------
+RollingGrid::SamplingVG RollingGrid::ReadVoxel(const MapFile& mapFile, const MapFile::VoxelRecord& voxel, bool fixed)
+{
+  SamplingVG innerVoxels;
+  innerVoxels.reserve(voxel.NbPoints);
+  const MapFile::PointRecord* records = mapFile.GetPoints(voxel);
+  for (unsigned int i = 0; i < voxel.NbPoints; ++i)
+  {
+    const MapFile::PointRecord& record = records[i];
+    Voxel& innerVoxel = innerVoxels[record.InnerIndex];
+    innerVoxel.point.x = record.X;
+    innerVoxel.point.y = record.Y;
+    innerVoxel.point.z = record.Z;
+    innerVoxel.point.intensity = record.Intensity;
+    innerVoxel.point.time = record.Time;
+    innerVoxel.point.laser_id = record.LaserId;
+    innerVoxel.point.device_id = record.DeviceId;
+    innerVoxel.point.label = fixed ? 1 : 0;
+    innerVoxel.count = record.Count;
+  }
+  return innerVoxels;
+}
+
+//==============================================================================
+//   Out-of-core map paging
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool RollingGrid::EnablePaging(const std::string& path, bool fixed)
+{
+  std::shared_ptr<Pager> pager = std::make_shared<Pager>(fixed);
+  if (!pager->File.Open(path))
+    return false;
+  const MapFile::Header& header = pager->File.GetHeader();
+  if (header.GridInSize != this->GridInSize || std::abs(header.LeafSize - this->LeafSize) > 1e-6)
+  {
+    PRINT_WARNING("Map file " << path << " has a different voxel layout (leaf size " << header.LeafSize
+                  << ", voxel width " << header.VoxelWidth << ") than the rolling grid : it can not be paged.");
+    return false;
+  }
+  if (2. * this->PagingRadius + this->VoxelWidth > this->GridSize * this->VoxelWidth)
+    PRINT_WARNING("Paging radius (" << this->PagingRadius << " m) is too large for the rolling grid size : "
+                  "some tiles around the current position may not be loaded.");
+
+  // Tiles will be loaded around the position given at the first update
+  this->Clear();
+  this->Paging = pager;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::DisablePaging()
+{
+  this->Paging.reset();
+}
+
+//------------------------------------------------------------------------------
+bool RollingGrid::UpdatePaging(const Eigen::Vector3f& position, const Eigen::Vector3f& velocity)
+{
+  if (!this->Paging)
+    return false;
+  Pager& pager = *this->Paging;
+  using Tile = Pager::Tile;
+
+  // Roll the grid to cover the areas around the current and predicted positions.
+  // The tiles leaving the grid are evicted.
+  Eigen::Array3f current = position.array();
+  Eigen::Array3f predicted = current + velocity.array() * this->PagingLookAhead;
+  unsigned int prevNbPoints = this->NbPoints;
+  this->Roll(current.min(predicted) - this->PagingRadius, current.max(predicted) + this->PagingRadius);
+  bool updated = this->NbPoints != prevNbPoints;
+
+  Eigen::Array3i gridMin = this->GetVoxelGridOriginCoords();
+  Eigen::Array3i gridMax = gridMin + this->GridSize - 1;
+  auto inGrid = [&](Tile tile)
+  {
+    Eigen::Array3i coords(tile->X, tile->Y, tile->Z);
+    return ((gridMin <= coords) && (coords <= gridMax)).all();
+  };
+  for (auto it = pager.Loaded.begin(); it != pager.Loaded.end();)
+    it = inGrid(*it) ? std::next(it) : pager.Loaded.erase(it);
+
+  // Get the tiles intersecting the area around a position, and lying in grid
+  auto tilesAround = [&](const Eigen::Array3f& center)
+  {
+    Eigen::Array3i minCoords = Utils::PositionToVoxel<Eigen::Array3f>(center - this->PagingRadius, Eigen::Array3f::Zero(), this->VoxelWidth);
+    Eigen::Array3i maxCoords = Utils::PositionToVoxel<Eigen::Array3f>(center + this->PagingRadius, Eigen::Array3f::Zero(), this->VoxelWidth);
+    return pager.File.FindVoxels(minCoords.max(gridMin), maxCoords.min(gridMax));
+  };
+
+  // Add a tile to the grid
+  Eigen::Array3i originCoords = gridMin;
+  auto addTile = [&](Tile tile, SamplingVG&& innerVoxels)
+  {
+    Eigen::Array3i idx3d = Eigen::Array3i(tile->X, tile->Y, tile->Z) - originCoords;
+    int idxOut = this->To1d(idx3d, this->GridSize);
+    SamplingVG& voxel = this->Voxels[idxOut];
+    this->NbPoints -= voxel.size();
+    voxel = std::move(innerVoxels);
+    this->NbPoints += voxel.size();
+    this->SetModified(idxOut);
+    pager.Loaded.insert(tile);
+    updated = true;
+  };
+
+  // Add the tiles loaded in background, if they are still in grid
+  for (auto& tileVoxels : pager.TakeReady())
+  {
+    if (!pager.Loaded.count(tileVoxels.first) && inGrid(tileVoxels.first))
+      addTile(tileVoxels.first, std::move(tileVoxels.second));
+  }
+
+  // Load the missing tiles around the current position : they are needed now
+  std::vector<Tile> neededTiles = tilesAround(current);
+  std::unordered_set<Tile> needed(neededTiles.begin(), neededTiles.end());
+  for (Tile tile : neededTiles)
+  {
+    if (!pager.Loaded.count(tile))
+      addTile(tile, ReadVoxel(pager.File, *tile, pager.Fixed));
+  }
+
+  // Prefetch the tiles around the predicted position
+  std::vector<Tile> prefetch;
+  for (Tile tile : tilesAround(predicted))
+  {
+    if (!pager.Loaded.count(tile))
+      prefetch.push_back(tile);
+  }
+  pager.Request(prefetch);
+
+  // Evict the farthest tiles which are not needed now to respect the memory budget
+  if (this->NbPoints > this->PagingMaxPoints)
+  {
+    std::vector<std::pair<float, Tile>> evictable;
+    for (Tile tile : pager.Loaded)
+    {
+      if (!needed.count(tile))
+      {
+        Eigen::Array3f center = Eigen::Array3f(tile->X, tile->Y, tile->Z) * this->VoxelWidth;
+        evictable.emplace_back((center - current).matrix().squaredNorm(), tile);
+      }
+    }
+    std::sort(evictable.begin(), evictable.end(), [](const std::pair<float, Tile>& a, const std::pair<float, Tile>& b) { return a.first > b.first; });
+    for (const auto& distTile : evictable)
+    {
+      if (this->NbPoints <= this->PagingMaxPoints)
+        break;
+      Tile tile = distTile.second;
+      Eigen::Array3i idx3d = Eigen::Array3i(tile->X, tile->Y, tile->Z) - originCoords;
+      auto itVoxel = this->Voxels.find(this->To1d(idx3d, this->GridSize));
+      this->NbPoints -= itVoxel->second.size();
+      this->SetModified(itVoxel->first);
+      this->Voxels.erase(itVoxel);
+      pager.Loaded.erase(tile);
+      updated = true;
+    }
+    if (this->NbPoints > this->PagingMaxPoints && !pager.BudgetWarned)
+    {
+      pager.BudgetWarned = true;
+      PRINT_WARNING("The map tiles around the current position hold " << this->NbPoints
+                    << " points, more than the paging memory budget (" << this->PagingMaxPoints << " points).");
+    }
+  }
+
+  // Clear the deprecated KD-tree only if the tiles needed around the current
+  // position have changed : the prefetched and evicted tiles are not indexed.
+  if (needed != pager.Indexed)
+  {
+    pager.Indexed.swap(needed);
+    this->KdTree.Reset();
+  }
+  return updated;
+}
+
+//==============================================================================
+//   Changes tracking
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void RollingGrid::SetTrackChanges(bool track)
+{
+  // Changes are only known from now on
+  this->TrackChanges = track;
+  this->ModifiedVoxels.clear();
+  this->ChangesReset = true;
+}
+
+//------------------------------------------------------------------------------
+RollingGrid::Changes RollingGrid::TakeChanges(bool all)
+{
+  Changes changes;
+  changes.VoxelWidth = this->VoxelWidth;
+  changes.Full = all || !this->TrackChanges || this->ChangesReset;
+
+  auto getPoints = [](const SamplingVG& innerVoxels)
+  {
+    PointCloud::Ptr points(new PointCloud);
+    points->reserve(innerVoxels.size());
+    for (const auto& kvIn : innerVoxels)
+      points->push_back(kvIn.second.point);
+    return points;
+  };
+
+  Eigen::Array3i originCoords = this->GetVoxelGridOriginCoords();
+  if (changes.Full)
+  {
+    // Get all non empty outer voxels
+    changes.Voxels.reserve(this->Voxels.size());
+    for (const auto& kvOut : this->Voxels)
+    {
+      if (!kvOut.second.empty())
+        changes.Voxels.emplace_back(this->To3d(kvOut.first, this->GridSize) + originCoords, getPoints(kvOut.second));
+    }
+  }
+  else
+  {
+    // Get the current points of the modified outer voxels,
+    // which may be empty or may have left the grid
+    changes.Voxels.reserve(this->ModifiedVoxels.size());
+    for (uint64_t key : this->ModifiedVoxels)
+    {
+      Eigen::Array3i coords = UnpackCoords(key);
+      Eigen::Array3i idx3d = coords - originCoords;
+      auto itOut = this->Voxels.end();
+      if (((0 <= idx3d) && (idx3d < this->GridSize)).all())
+        itOut = this->Voxels.find(this->To1d(idx3d, this->GridSize));
+      changes.Voxels.emplace_back(coords, itOut != this->Voxels.end() ? getPoints(itOut->second) : PointCloud::Ptr(new PointCloud));
+    }
+  }
+
+  this->ModifiedVoxels.clear();
+  this->ChangesReset = false;
+  return changes;
+}
+
+//------------------------------------------------------------------------------
+void RollingGrid::SetModified(int voxelId1d)
+{
+  if (this->TrackChanges)
+    this->ModifiedVoxels.insert(PackCoords(this->To3d(voxelId1d, this->GridSize) + this->GetVoxelGridOriginCoords()));
 }
 
 //==============================================================================
@@ -352,6 +1076,7 @@ void RollingGrid::ClearPoints(double currentTime, bool clearOldPoints)
   {
     // Loop on the inner voxels (sampling vg)
     auto itVoxelsIn = itVoxelsOut->second.begin();
+    unsigned int prevNbInner = itVoxelsOut->second.size();
     while(itVoxelsIn != itVoxelsOut->second.end())
     {
       // Shortcut to voxel
@@ -363,6 +1088,11 @@ void RollingGrid::ClearPoints(double currentTime, bool clearOldPoints)
       else
         ++itVoxelsIn;
     }
+    if (itVoxelsOut->second.size() != prevNbInner)
+    {
+      this->NbPoints -= prevNbInner - itVoxelsOut->second.size();
+      this->SetModified(itVoxelsOut->first);
+    }
 
     // Remove empty outer voxels
     if (itVoxelsOut->second.empty())
@@ -375,8 +1105,24 @@ void RollingGrid::ClearPoints(double currentTime, bool clearOldPoints)
 //------------------------------------------------------------------------------
 void RollingGrid::BuildSubMapKdTree()
 {
-  // Get all points from all voxels
-  this->SubMap = this->Get();
+  // If the map is paged, only get the points of the tiles around the current position
+  if (this->Paging)
+  {
+    this->SubMap.reset(new PointCloud);
+    Eigen::Array3i originCoords = this->GetVoxelGridOriginCoords();
+    for (Pager::Tile tile : this->Paging->Indexed)
+    {
+      Eigen::Array3i idx3d = Eigen::Array3i(tile->X, tile->Y, tile->Z) - originCoords;
+      auto itVoxel = this->Voxels.find(this->To1d(idx3d, this->GridSize));
+      if (itVoxel == this->Voxels.end())
+        continue;
+      for (const auto& kvIn : itVoxel->second)
+        this->SubMap->push_back(kvIn.second.point);
+    }
+  }
+  // Otherwise, get all points from all voxels
+  else
+    this->SubMap = this->Get();
   // Build the internal KD-Tree for fast NN queries in map
   this->KdTree.Reset(this->SubMap);
 }
@@ -468,6 +1214,13 @@ void RollingGrid::BuildSubMapKdTree(const Eigen::Array3f& minPoint, const Eigen:
 //   Helpers
 //==============================================================================
 
+//------------------------------------------------------------------------------
+Eigen::Array3i RollingGrid::GetVoxelGridOriginCoords() const
+{
+  Eigen::Array3f voxelGridOrigin = this->VoxelGridPosition - int(this->GridSize / 2) * this->VoxelWidth;
+  return (voxelGridOrigin / this->VoxelWidth).round().cast<int>();
+}
+
 //------------------------------------------------------------------------------
 int RollingGrid::To1d(const Eigen::Array3i& voxelId3d, int gridSize) const
 {
@@ -72,7 +72,9 @@
 //   initial position. The output trajectory describes BASE origin in WORLD.
 
 // GENERIC
+#include <algorithm>
 #include <ctime>
+#include <limits>
 
 // LOCAL
 #include "LidarSlam/Slam.h"
@@ -191,9 +193,25 @@ void Slam::InitMap(Keypoint k)
   }
 }
 
+//-----------------------------------------------------------------------------
+Slam::~Slam()
+{
+  // The background graph optimization uses the SLAM members
+  if (this->GraphOptimizationResult.valid())
+    this->GraphOptimizationResult.wait();
+}
+
 //-----------------------------------------------------------------------------
 void Slam::Reset(bool resetLog)
 {
+  // Discard any background graph optimization
+  if (this->GraphOptimizationResult.valid())
+  {
+    this->GraphOptimizationResult.wait();
+    this->GraphOptimizationResult = std::future<bool>();
+    this->PendingGraphOptimization.reset();
+  }
+
   // Reset keypoints maps
   this->ClearLocalMaps();
 
@@ -213,6 +231,7 @@ void Slam::Reset(bool resetLog)
   this->CurrentFrames.clear();
   this->RegisteredFrame.reset(new PointCloud);
   this->CurrentFrames.emplace_back(new PointCloud);
+  this->CurrentDownsampledFrames = this->CurrentFrames;
   for (auto k : this->UsableKeypoints)
   {
     this->CurrentRawKeypoints[k].reset(new PointCloud);
@@ -239,9 +258,12 @@ void Slam::Reset(bool resetLog)
     // Reset logged keypoints
     this->NbrFrameProcessed = 0;
     this->LogStates.clear();
+    this->LoopDetector.Clear();
+    this->ResetIncrementalGraph();
 
-    // Reset processing duration timers
+    // Reset processing duration timers and latency statistics
     Utils::Timer::Reset();
+    this->Timings.Reset();
   }
 }
 
@@ -250,6 +272,7 @@ void Slam::SetNbThreads(int n)
 {
   // Set number of threads for main processes
   this->NbThreads = n;
+  this->LoggingCodecParams.NbThreads = n;
   // Set number of threads for keypoints extraction
   for (const auto& kv : this->KeyPointsExtractors)
     kv.second->SetNbThreads(n);
@@ -290,7 +313,6 @@ void Slam::EnableKeypointType(Keypoint k, bool enabled)
       this->CurrentWorldKeypoints[k].reset(new PointCloud);
     this->EgoMotionMatchingResults[k] = KeypointsMatcher::MatchingResults();
     this->LocalizationMatchingResults[k] = KeypointsMatcher::MatchingResults();
-    this->LoopClosureMatchingResults[k] = KeypointsMatcher::MatchingResults();
   }
 }
 
@@ -321,8 +343,46 @@ void Slam::AddFrames(const std::vector<PointCloud::Ptr>& frames)
   // Check that input frames are correct and can be processed
   if (!this->CheckFrames(frames))
     return;
+  Profiling::ScopedTimer frameTimer(this->Timings, Profiling::FRAME);
   this->CurrentFrames = frames;
   this->CurrentTime = Utils::PclStampToSec(this->CurrentFrames[0]->header.stamp);
+  // Registered frame will be lazily computed with the new pose
+  this->RegisteredFrame.reset();
+
+  // Downsample input frames once, for the consumers not needing full resolution
+  if (this->InputDownsamplingLeafSize > 0.)
+  {
+    this->CurrentDownsampledFrames.clear();
+    for (const auto& frame : frames)
+      this->CurrentDownsampledFrames.push_back(Utils::VoxelDownsample(*frame, this->InputDownsamplingLeafSize, this->NbThreads));
+  }
+  else
+    this->CurrentDownsampledFrames = frames;
+
+  // Create UsableKeypointTypes for new frame
+  // The keypoints cannot be chosen while processing a frame
+  // because it impacts all the maps structure along the process
+  std::vector<Keypoint> usableKeypoints;
+  for (auto k : KeypointTypes)
+  {
+    if (this->UseKeypoints[k])
+      usableKeypoints.push_back(k);
+  }
+  if (usableKeypoints != this->UsableKeypoints)
+  {
+    // The keypoints types are used by the background graph optimization
+    if (this->IsGraphOptimizationPending())
+    {
+      PRINT_WARNING("Keypoints types changed : waiting for the background pose graph optimization to end");
+      this->WaitGraphOptimization();
+    }
+    this->UsableKeypoints = usableKeypoints;
+  }
+
+  // Apply the background pose graph optimization results if available
+  if (this->IsGraphOptimizationPending() &&
+      this->GraphOptimizationResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    this->WaitGraphOptimization();
 
   // Set init pose (can have been modified by global optimization / reset)
   // 1) To ensure a smooth local SLAM, the global optimization must refine
@@ -335,16 +395,6 @@ void Slam::AddFrames(const std::vector<PointCloud::Ptr>& frames)
   else
     this->Tworld = this->TworldInit;
 
-  // Create UsableKeypointTypes for new frame
-  // The keypoints cannot be chosen while processing a frame
-  // because it impacts all the maps structure along the process
-  this->UsableKeypoints.clear();
-  for (auto k : KeypointTypes)
-  {
-    if (this->UseKeypoints[k])
-      this->UsableKeypoints.push_back(k);
-  }
-
   PRINT_VERBOSE(2, "\n#########################################################");
   PRINT_VERBOSE(1, "Processing frame " << this->NbrFrameProcessed << std::fixed << std::setprecision(9) <<
                    " (at time " << this->CurrentTime << ")" << std::scientific);
@@ -380,6 +430,7 @@ void Slam::AddFrames(const std::vector<PointCloud::Ptr>& frames)
   if (this->OverlapSamplingRatio > 0 || this->TimeWindowDuration > 0)
   {
     IF_VERBOSE(3, Utils::Timer::Init("Confidence estimators computation"));
+    Profiling::ScopedTimer confidenceTimer(this->Timings, Profiling::CONFIDENCE);
     if (this->OverlapSamplingRatio > 0)
       this->EstimateOverlap();
     if (this->TimeWindowDuration > 0)
@@ -532,7 +583,7 @@ void Slam::ComputeSensorConstraints()
         PRINT_VERBOSE(3, "Camera constraint added")
     }
     // Store the current frame for next iteration
-    PointCloud::Ptr aggregatedFrames = this->AggregateFrames(this->CurrentFrames);
+    PointCloud::Ptr aggregatedFrames = this->AggregateFrames(this->CurrentDownsampledFrames);
     this->CameraManager->SetPrevLidarFrame(aggregatedFrames);
   }
 }
@@ -549,7 +600,7 @@ void Slam::UpdateMaps(bool resetMaps)
       this->LocalMaps[k]->ClearPoints(this->LogStates.front().Time, false);
   }
   // Update LocalMaps with the keypoints stored in the LogStates
-  this->BuildMaps(this->LocalMaps);
+  this->BuildMaps(this->LocalMaps, this->LogStates, this->GetParametersSnapshot());
 }
 
 //-----------------------------------------------------------------------------
@@ -577,13 +628,15 @@ bool Slam::UpdateTrajectoryAndMapsWithIMU()
       for (auto k : this->UsableKeypoints)
       {
         // Get keypoints
-        PointCloud::Ptr rawKeypoints = state.RawKeypoints[k]->GetCloud();
+        PointCloud::ConstPtr rawKeypoints = state.RawKeypoints[k]->GetCloud();
         PointCloud::Ptr undistortedKeypoints(new PointCloud);
         *undistortedKeypoints = *rawKeypoints;
 
         // Update undistorted keypoints
+        // A new storage is created as raw and undistorted keypoints may share the same one
         this->UndistortWithPoseMeasurement(undistortedKeypoints, state.Time);
-        state.Keypoints[k]->SetCloud(undistortedKeypoints, this->LoggingStorage);
+        state.Keypoints[k] = std::make_shared<PCStorage>(undistortedKeypoints, this->LoggingStorage,
+                                                         this->LoggingAsync, this->LoggingCodecParams);
         // Update maps
         PointCloud::Ptr keypoints(new PointCloud);
         keypoints->header = Utils::BuildPclHeader(state.Time, this->BaseFrameId, state.Index);
@@ -592,6 +645,8 @@ bool Slam::UpdateTrajectoryAndMapsWithIMU()
       }
     }
     this->Tworld = this->LogStates.back().Isometry;
+    // Registered frame must be updated with the new pose
+    this->RegisteredFrame.reset();
 
     IF_VERBOSE(1, Utils::Timer::StopAndDisplay("Pose graph optimization"));
     return true;
@@ -607,7 +662,131 @@ bool Slam::UpdateTrajectoryAndMapsWithIMU()
 //-----------------------------------------------------------------------------
 bool Slam::OptimizeGraph()
 {
+  if (this->IncrementalGraph)
+  {
+    #ifdef USE_GTSAM
+    return this->OptimizeGraphIncremental();
+    #else
+    PRINT_ERROR("Incremental graph optimization requires GTSAM, but it was not found.");
+    return false;
+    #endif  // USE_GTSAM
+  }
+
+  #ifdef USE_G2O
+  if (this->IsGraphOptimizationPending())
+  {
+    PRINT_ERROR("A pose graph optimization is already running in background, graph cannot be optimized");
+    return false;
+  }
+
+  IF_VERBOSE(1, Utils::Timer::Init("Pose graph optimization"));
+
+  // Build and optimize the graph directly from the logged states
+  GraphOptimizationJob job;
+  job.Params = this->GetParametersSnapshot();
+  if (!this->InitGraphOptimization(job) || !this->ProcessGraphOptimization(job))
+    return false;
+  this->UpdateStatesFromOptimized(this->LogStates, job.States);
+
+  // Update the maps with the keyframes which moved
+  IF_VERBOSE(3, Utils::Timer::Init("PGO : maps update"));
+  this->UpdateMapsFromOptimized(this->LocalMaps, job.Params, job.InitialStates, job.States);
+  IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : maps update"));
+
+  // The last pose has to be updated with new optimized pose
+  this->SetWorldTransformFromGuess(this->LogStates.back().Isometry);
+
+  IF_VERBOSE(1, Utils::Timer::StopAndDisplay("Pose graph optimization"));
+
+  return true;
+
+  #else
+  PRINT_ERROR("SLAM graph optimization requires G2O, but it was not found.");
+  return false;
+  #endif  // USE_G2O
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::OptimizeGraphAsync()
+{
+  // The incremental graph update cost does not depend on the trajectory length :
+  // it is processed directly
+  if (this->IncrementalGraph)
+  {
+    this->LastGraphOptimizationSuccess = this->OptimizeGraph();
+    return this->LastGraphOptimizationSuccess;
+  }
+
   #ifdef USE_G2O
+  if (this->IsGraphOptimizationPending())
+  {
+    PRINT_ERROR("A pose graph optimization is already running in background, graph cannot be optimized");
+    return false;
+  }
+  this->LastGraphOptimizationSuccess = false;
+
+  // External constraints are gathered and the logged states are copied now,
+  // frames processing modifying them afterwards.
+  // The parameters are copied too, as they may be modified meanwhile.
+  auto job = std::make_shared<GraphOptimizationJob>();
+  job->Params = this->GetParametersSnapshot(true);
+  if (!this->InitGraphOptimization(*job))
+    return false;
+
+  // The maps are copied too, to be updated in background : copying their
+  // voxels is much cheaper than adding all keyframes points again
+  this->InitSubMaps(job->RebuiltMaps, job->Params);
+  for (auto k : job->Params.UsableKeypoints)
+    job->RebuiltMaps[k]->CopyPoints(*this->LocalMaps[k]);
+
+  // Loop closure registration, graph optimization and maps update are run
+  // in background, on the snapshots of the logged states, maps and parameters
+  this->PendingGraphOptimization = job;
+  this->GraphOptimizationResult = std::async(std::launch::async, [this, job]()
+  {
+    if (!this->ProcessGraphOptimization(*job))
+      return false;
+    this->UpdateMapsFromOptimized(job->RebuiltMaps, job->Params, job->InitialStates, job->States);
+    return true;
+  });
+  PRINT_VERBOSE(1, "Pose graph optimization started in background on " << job->States.size() << " states");
+  return true;
+
+  #else
+  PRINT_ERROR("SLAM graph optimization requires G2O, but it was not found.");
+  return false;
+  #endif  // USE_G2O
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::IsGraphOptimizationPending() const
+{
+  return this->GraphOptimizationResult.valid();
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::WaitGraphOptimization()
+{
+  if (!this->GraphOptimizationResult.valid())
+    return false;
+
+  bool success = this->GraphOptimizationResult.get();
+  std::shared_ptr<GraphOptimizationJob> job = std::move(this->PendingGraphOptimization);
+  this->LastGraphOptimizationSuccess = success;
+  if (!success)
+  {
+    PRINT_ERROR("Background pose graph optimization failed, the trajectory is not optimized");
+    return false;
+  }
+
+  this->ApplyGraphOptimization(*job);
+  return true;
+}
+
+#ifdef USE_G2O
+//-----------------------------------------------------------------------------
+bool Slam::InitGraphOptimization(GraphOptimizationJob& job)
+{
   // Check if graph can be optimized
   if (!this->LmHasData() && !this->GpsHasData() && !UsePGOConstraints[LOOP_CLOSURE])
   {
@@ -615,7 +794,7 @@ bool Slam::OptimizeGraph()
     return false;
   }
 
-  PoseGraphOptimizer graphManager;
+  PoseGraphOptimizer& graphManager = job.Graph;
   graphManager.SetFixFirst(this->FixFirstVertex);
   graphManager.SetFixLast(this->FixLastVertex);
   // Clear the graph
@@ -625,35 +804,23 @@ bool Slam::OptimizeGraph()
   graphManager.SetVerbose(this->Verbosity >= 2);
   graphManager.SetSaveG2OFile(!this->G2oFileName.empty());
   graphManager.SetG2OFileName(this->G2oFileName);
-  // Add new SLAM states to graph
-  graphManager.AddLidarStates(this->LogStates);
+  // Add SLAM states to graph
+  // They are copied, so that the optimization can run in background
+  job.States = this->GetGraphStates();
+  graphManager.AddLidarStates(job.States);
 
-  IF_VERBOSE(1, Utils::Timer::Init("Pose graph optimization"));
   IF_VERBOSE(3, Utils::Timer::Init("PGO : optimization"));
 
-  // Boolean to store the info "there is at least one external constraint in the graph"
-  bool externalConstraint = false;
-
   // Look for loop closure constraints
+  // The loop closure is detected now, its registration is done during processing
   if (UsePGOConstraints[LOOP_CLOSURE])
   {
     // Detect loop closure
-    auto itRevisitedState = this->LogStates.begin();
-    auto itQueryState = itRevisitedState;
-    if (DetectLoopClosureIndices(itQueryState, itRevisitedState))
+    auto itQueryState = this->LogStates.begin();
+    if (DetectLoopClosureIndices(itQueryState, job.LoopClosureCandidates))
     {
-      // Compute a loopClosureTransform from the revisited frame to the query frame
-      // by registering the keypoints of the query frame onto the keypoints of the revisited frame
-      Eigen::Isometry3d loopClosureTransform;
-      Eigen::Matrix6d loopClosureCovariance;
-      if (this->LoopClosureRegistration(itQueryState, itRevisitedState,
-                                        loopClosureTransform, loopClosureCovariance))
-      {
-        // Add loop closure constraint into pose graph
-        graphManager.AddLoopClosureConstraint(this->LoopClosureQueryIdx, this->LoopClosureRevisitedIdx,
-                                              loopClosureTransform, loopClosureCovariance);
-        externalConstraint = true;
-      }
+      job.LoopClosureDetected = true;
+      job.LoopClosureQueryIdx = itQueryState->Index;
     }
     else
       PRINT_WARNING("No loop closure is detected for pose graph optimization.")
@@ -679,14 +846,14 @@ bool Slam::OptimizeGraph()
 
       // Add landmarks constraint to the graph
       lm.SetVerbose(false);
-      for (auto& s : this->LogStates)
+      for (auto& s : job.States)
       {
         ExternalSensors::LandmarkMeasurement lmSynchMeasure; // Virtual landmark measure with synchronized timestamp and no calibration applied
         if (!lm.ComputeSynchronizedMeasure(s.Time, lmSynchMeasure))
           continue;
         // Add synchronized landmark observations to the graph
         graphManager.AddLandmarkConstraint(s.Index, idLm.first, lmSynchMeasure, lm.GetPositionOnly());
-        externalConstraint = true;
+        job.ExternalConstraint = true;
       }
       lm.SetVerbose(this->Verbosity >= 3);
     }
@@ -699,7 +866,7 @@ bool Slam::OptimizeGraph()
   if (UsePGOConstraints[PGO_GPS] && this->GpsHasData())
   {
     graphManager.AddExternalSensor(this->GpsManager->GetCalibration(), int(ExternalSensor::GPS));
-    for (auto& s : this->LogStates)
+    for (auto& s : job.States)
     {
       ExternalSensors::GpsMeasurement gpsSynchMeasure; // Virtual GPS measure in SLAM reference frame with synchronized timestamp
       if (!this->GpsManager->ComputeSynchronizedMeasureOffset(s.Time, gpsSynchMeasure))
@@ -707,20 +874,51 @@ bool Slam::OptimizeGraph()
 
       // Add synchronized gps measurement to the graph
       graphManager.AddGpsConstraint(s.Index, gpsSynchMeasure);
-      externalConstraint = true;
+      job.ExternalConstraint = true;
+    }
+  }
+
+  if (!job.ExternalConstraint && !job.LoopClosureDetected)
+  {
+    PRINT_ERROR("No external constraints nor loop closure constraint exist. Pose graph can not be optimized");
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::ProcessGraphOptimization(GraphOptimizationJob& job)
+{
+  PoseGraphOptimizer& graphManager = job.Graph;
+
+  // Register the detected loop closure
+  if (job.LoopClosureDetected)
+  {
+    // Compute a loopClosureTransform from the revisited frame to the query frame
+    // by registering the keypoints of the query frame onto the keypoints of the revisited frame
+    unsigned int revisitedIdx;
+    Eigen::Isometry3d loopClosureTransform;
+    Eigen::Matrix6d loopClosureCovariance;
+    if (this->RegisterLoopClosureCandidates(job.Params, job.States, job.LoopClosureQueryIdx, job.LoopClosureCandidates,
+                                            revisitedIdx, loopClosureTransform, loopClosureCovariance))
+    {
+      // Add loop closure constraint into pose graph
+      graphManager.AddLoopClosureConstraint(job.LoopClosureQueryIdx, revisitedIdx,
+                                            loopClosureTransform, loopClosureCovariance);
+      job.ExternalConstraint = true;
     }
   }
 
-  if (!externalConstraint)
+  if (!job.ExternalConstraint)
   {
     PRINT_ERROR("No external constraints nor loop closure constraint exist. Pose graph can not be optimized");
     return false;
   }
 
-  auto statesInit = this->LogStates;
+  job.InitialStates = job.States;
 
   // Run pose graph optimization
-  if (!graphManager.Process(this->LogStates))
+  if (!graphManager.Process(job.States))
   {
     PRINT_ERROR("Pose graph optimization failed.");
     return false;
@@ -729,9 +927,9 @@ bool Slam::OptimizeGraph()
   // WARNING : covariances are not updated at each graph optimization
   // because g2o does not allow to reach them.
   // Covariances rotation is mandatory if covariances are to be used again afterwards
-  auto itStates = this->LogStates.begin();
-  auto itInit = statesInit.begin();
-  while (itInit != statesInit.end())
+  auto itStates = job.States.begin();
+  auto itInit = job.InitialStates.begin();
+  while (itInit != job.InitialStates.end())
   {
     // Compute relative transform
     Eigen::Isometry3d Trel = itInit->Isometry.inverse() * itStates->Isometry;
@@ -742,24 +940,387 @@ bool Slam::OptimizeGraph()
   }
 
   IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : optimization"));
+  return true;
+}
+#endif  // USE_G2O
+
+//-----------------------------------------------------------------------------
+void Slam::ApplyGraphOptimization(GraphOptimizationJob& job)
+{
+  IF_VERBOSE(3, Utils::Timer::Init("PGO : results application"));
+
+  // Update the logged states with the optimized ones.
+  // The states logged since the snapshot are corrected with the correction
+  // of the last optimized state, to keep the trajectory continuous.
+  unsigned int nbNewStates = std::count_if(this->LogStates.begin(), this->LogStates.end(),
+                                           [&job](const LidarState& s) { return s.Index > job.States.back().Index; });
+  this->UpdateStatesFromOptimized(this->LogStates, job.States);
+
+  // If the keypoints types or the maps geometry changed during the optimization,
+  // the snapshot maps can not be used : the maps are built again from the logged states.
+  bool sameMaps = job.Params.UsableKeypoints == this->UsableKeypoints;
+  for (auto k : this->UsableKeypoints)
+  {
+    if (!sameMaps)
+      break;
+    const RollingGrid& snapshotGrid = *job.Params.Grids.at(k);
+    const RollingGrid& grid = *this->LocalMaps[k];
+    sameMaps = snapshotGrid.GetGridSize() == grid.GetGridSize() &&
+               snapshotGrid.GetVoxelResolution() == grid.GetVoxelResolution() &&
+               snapshotGrid.GetLeafSize() == grid.GetLeafSize() &&
+               snapshotGrid.GetSampling() == grid.GetSampling();
+  }
+  if (!sameMaps)
+  {
+    PRINT_WARNING("Maps parameters changed during background pose graph optimization : maps are rebuilt");
+    this->UpdateMaps(false);
+  }
+  else
+  {
+    // Update the maps : replace their points by the updated snapshot ones,
+    // then add the keyframes logged since the snapshot.
+    // Only the latter have to be transformed here.
+    for (auto k : this->UsableKeypoints)
+      this->LocalMaps[k]->SwapPoints(*job.RebuiltMaps[k]);
+    if (this->LogStates.back().Index > job.States.back().Index)
+      this->BuildMaps(this->LocalMaps, this->LogStates, this->GetParametersSnapshot(), job.States.back().Index + 1);
+  }
+
+  // The last pose has to be updated with new optimized pose
+  this->SetWorldTransformFromGuess(this->LogStates.back().Isometry);
+
+  IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : results application"));
+  PRINT_VERBOSE(1, "Background pose graph optimization results applied ("
+                   << nbNewStates << " states logged meanwhile)");
+}
+
+//-----------------------------------------------------------------------------
+void Slam::UpdateMapsFromOptimized(Maps& maps, const ParametersSnapshot& params,
+                                   const std::list<LidarState>& initialStates,
+                                   const std::list<LidarState>& optimizedStates)
+{
+  // Look for the first keyframe which moved
+  double angleThreshold = Utils::Deg2Rad(params.MapUpdateAngleThreshold);
+  const LidarState* lastUnchanged = nullptr;
+  auto itInit = initialStates.begin();
+  auto itOptimized = optimizedStates.begin();
+  for (; itOptimized != optimizedStates.end(); ++itInit, ++itOptimized)
+  {
+    if (!itOptimized->IsKeyFrame)
+      continue;
+    Eigen::Isometry3d motion = itInit->Isometry.inverse() * itOptimized->Isometry;
+    if (motion.translation().norm() > params.MapUpdateDistanceThreshold ||
+        Eigen::AngleAxisd(motion.linear()).angle() > angleThreshold)
+      break;
+    lastUnchanged = &(*itOptimized);
+  }
+  if (itOptimized == optimizedStates.end())
+  {
+    PRINT_VERBOSE(3, "No keyframe moved, maps are not updated");
+    return;
+  }
+
+  // Remove the points acquired after the last unchanged keyframe, and add back
+  // the keyframes from this one, as some of its points may have been removed.
+  // If the first keyframe moved, all states are added back, but only the points
+  // more recent than the first state are removed : the older points come from
+  // the keyframes which are not logged anymore, and could not be restored.
+  double startTime = lastUnchanged ? lastUnchanged->Time : optimizedStates.front().Time;
+  int startIdx = lastUnchanged ? lastUnchanged->Index : -1;
+  for (auto k : params.UsableKeypoints)
+    maps[k]->ClearPoints(startTime, false);
+  this->BuildMaps(maps, optimizedStates, params, startIdx);
+  PRINT_VERBOSE(3, "Maps updated from keyframe #" << itOptimized->Index);
+}
+
+//-----------------------------------------------------------------------------
+std::list<LidarState> Slam::GetGraphStates() const
+{
+  if (!this->GraphKeyframesOnly)
+    return this->LogStates;
+  std::list<LidarState> graphStates;
+  std::copy_if(this->LogStates.begin(), this->LogStates.end(), std::back_inserter(graphStates),
+               [](const LidarState& s) { return s.IsKeyFrame; });
+  return graphStates;
+}
+
+//-----------------------------------------------------------------------------
+std::list<LidarState>::iterator Slam::GetGraphState(std::list<LidarState>::iterator itState)
+{
+  if (!this->GraphKeyframesOnly || itState->IsKeyFrame)
+    return itState;
+  auto itKeyframe = std::find_if(itState, this->LogStates.end(), [](const LidarState& s) { return s.IsKeyFrame; });
+  if (itKeyframe == this->LogStates.end())
+  {
+    itKeyframe = itState;
+    while (itKeyframe != this->LogStates.begin() && !itKeyframe->IsKeyFrame)
+      --itKeyframe;
+  }
+  PRINT_VERBOSE(3, "Frame #" << itState->Index << " is not a keyframe, it is replaced by keyframe #"
+                   << itKeyframe->Index << " in pose graph");
+  return itKeyframe;
+}
+
+//-----------------------------------------------------------------------------
+void Slam::UpdateStatesFromOptimized(std::list<LidarState>& states, const std::list<LidarState>& optimizedStates) const
+{
+  // Initial and optimized poses of the optimized states
+  struct Anchor
+  {
+    double Time;
+    Eigen::Isometry3d Init;
+    Eigen::Isometry3d Optimized;
+  };
+  std::vector<Anchor> anchors;
+  auto itOptim = optimizedStates.cbegin();
+  for (const auto& state : states)
+  {
+    while (itOptim != optimizedStates.cend() && itOptim->Index < state.Index)
+      ++itOptim;
+    if (itOptim != optimizedStates.cend() && itOptim->Index == state.Index)
+      anchors.push_back({state.Time, state.Isometry, itOptim->Isometry});
+  }
+  if (anchors.empty())
+    return;
+
+  itOptim = optimizedStates.cbegin();
+  unsigned int nextAnchor = 0;
+  for (auto& state : states)
+  {
+    while (itOptim != optimizedStates.cend() && itOptim->Index < state.Index)
+      ++itOptim;
+    if (itOptim != optimizedStates.cend() && itOptim->Index == state.Index)
+    {
+      state.Isometry = itOptim->Isometry;
+      state.Covariance = itOptim->Covariance;
+      ++nextAnchor;
+      continue;
+    }
+
+    // Recompose the pose from the bracketing optimized states,
+    // keeping the relative pose to each of them
+    auto recompose = [&state](const Anchor& a) -> Eigen::Isometry3d
+                     { return a.Optimized * a.Init.inverse() * state.Isometry; };
+    Eigen::Isometry3d newPose;
+    if (nextAnchor == 0)
+      newPose = recompose(anchors.front());
+    else if (nextAnchor == anchors.size())
+      newPose = recompose(anchors.back());
+    else
+    {
+      const Anchor& prev = anchors[nextAnchor - 1];
+      const Anchor& next = anchors[nextAnchor];
+      newPose = Interpolation::LinearInterpo(PoseStamped(recompose(prev), prev.Time),
+                                             PoseStamped(recompose(next), next.Time),
+                                             state.Time);
+    }
+
+    Eigen::Vector6d pose = Utils::IsometryToXYZRPY(state.Isometry);
+    CeresTools::RotateCovariance(pose, state.Covariance, newPose * state.Isometry.inverse(), true); // new = correction * init
+    state.Isometry = newPose;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void Slam::SetIncrementalGraph(bool incremental)
+{
+  if (incremental == this->IncrementalGraph)
+    return;
+  this->IncrementalGraph = incremental;
+  this->ResetIncrementalGraph();
+}
+
+//-----------------------------------------------------------------------------
+void Slam::ResetIncrementalGraph()
+{
+  #ifdef USE_GTSAM
+  this->IncrementalGraphOptimizer.Reset();
+  this->IncrementalGraphGpsTime = -1.;
+  this->IncrementalGraphLmTimes.clear();
+  #endif  // USE_GTSAM
+}
 
-  // Update the maps from the beginning using the new trajectory
+#ifdef USE_GTSAM
+//-----------------------------------------------------------------------------
+bool Slam::OptimizeGraphIncremental()
+{
+  if (this->IsGraphOptimizationPending())
+  {
+    PRINT_ERROR("A pose graph optimization is already running in background, graph cannot be optimized");
+    return false;
+  }
+  if (this->LogStates.empty())
+  {
+    PRINT_ERROR("No logged state, graph cannot be optimized");
+    return false;
+  }
+
+  IF_VERBOSE(1, Utils::Timer::Init("Pose graph optimization"));
+  IF_VERBOSE(3, Utils::Timer::Init("PGO : optimization"));
+
+  IncrementalPoseGraph& graphManager = this->IncrementalGraphOptimizer;
+  graphManager.SetFixFirst(this->FixFirstVertex);
+  graphManager.SetVerbose(this->Verbosity >= 2);
+
+  // Returns true if a logged state is a graph vertex
+  auto isGraphState = [this](const LidarState& s) { return !this->GraphKeyframesOnly || s.IsKeyFrame; };
+
+  // Add the states logged since last update : only these are copied.
+  // The states which are not logged anymore are marginalized, as they can not
+  // be constrained anymore.
+  auto itNewStates = this->LogStates.end();
+  while (itNewStates != this->LogStates.begin() &&
+         (!graphManager.GetNbStates() || std::prev(itNewStates)->Index > graphManager.GetLastIndex()))
+    --itNewStates;
+  std::list<LidarState> newStates;
+  std::copy_if(itNewStates, this->LogStates.end(), std::back_inserter(newStates), isGraphState);
+  graphManager.AddLidarStates(newStates);
+  graphManager.MarginalizeStatesBefore(this->LogStates.front().Index);
+
+  // Returns an iterator to the first logged state more recent than time
+  auto firstStateAfter = [this](double time)
+  {
+    auto itRevState = std::find_if(this->LogStates.rbegin(), this->LogStates.rend(),
+                                   [time](const LidarState& s) { return s.Time <= time; });
+    return itRevState.base();
+  };
+
+  // Look for loop closure constraints
+  if (UsePGOConstraints[LOOP_CLOSURE])
+  {
+    auto itQueryState = this->LogStates.begin();
+    std::vector<LoopClosureDetector::Candidate> candidates;
+    if (this->DetectLoopClosureIndices(itQueryState, candidates))
+    {
+      // Skip the loop closures already in graph
+      unsigned int queryIdx = itQueryState->Index;
+      candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                      [&](const LoopClosureDetector::Candidate& c) { return graphManager.HasLoopClosure(queryIdx, c.Index); }),
+                       candidates.end());
+      unsigned int revisitedIdx;
+      Eigen::Isometry3d loopClosureTransform;
+      Eigen::Matrix6d loopClosureCovariance;
+      if (this->RegisterLoopClosureCandidates(this->GetParametersSnapshot(), this->LogStates, queryIdx, candidates,
+                                              revisitedIdx, loopClosureTransform, loopClosureCovariance))
+        graphManager.AddLoopClosureConstraint(queryIdx, revisitedIdx, loopClosureTransform, loopClosureCovariance);
+    }
+  }
+
+  // Look for landmark constraints of the states not checked yet.
+  // The states more recent than the last measurement are checked on next update,
+  // when the measurements can be interpolated.
+  if (UsePGOConstraints[LANDMARK] && this->LmHasData())
+  {
+    // Allow the rotation of the covariances when interpolating the measurements
+    this->SetLandmarkCovarianceRotation(true);
+    for (auto& idLm : this->LandmarksManagers)
+    {
+      auto& lm = idLm.second;
+      if (!lm.HasData())
+        continue;
+      auto itLmTime = this->IncrementalGraphLmTimes.emplace(idLm.first, -1.).first;
+      double lastMeasureTime = lm.GetLastMeasureTime();
+      Eigen::Isometry3d lmTransfo = Utils::XYZRPYtoIsometry(lm.GetAbsolutePose());
+      lm.SetVerbose(false);
+      for (auto itState = firstStateAfter(itLmTime->second);
+           itState != this->LogStates.end() && itState->Time <= lastMeasureTime; ++itState)
+      {
+        itLmTime->second = itState->Time;
+        ExternalSensors::LandmarkMeasurement lmSynchMeasure; // Virtual landmark measure with synchronized timestamp and no calibration applied
+        if (graphManager.HasState(itState->Index) && lm.ComputeSynchronizedMeasure(itState->Time, lmSynchMeasure))
+          graphManager.AddLandmarkConstraint(itState->Index, this->LmDetectorCalibration, lmTransfo,
+                                             lmSynchMeasure, lm.GetPositionOnly());
+      }
+      lm.SetVerbose(this->Verbosity >= 3);
+    }
+    // Reset the rotate covariance member to not rotate covariances
+    // in future local constraints building
+    this->SetLandmarkCovarianceRotation(false);
+  }
+
+  // Look for GPS constraints of the states not checked yet
+  if (UsePGOConstraints[PGO_GPS] && this->GpsHasData())
+  {
+    double lastMeasureTime = this->GpsManager->GetLastMeasureTime();
+    for (auto itState = firstStateAfter(this->IncrementalGraphGpsTime);
+         itState != this->LogStates.end() && itState->Time <= lastMeasureTime; ++itState)
+    {
+      this->IncrementalGraphGpsTime = itState->Time;
+      ExternalSensors::GpsMeasurement gpsSynchMeasure; // Virtual GPS measure in SLAM reference frame with synchronized timestamp
+      if (graphManager.HasState(itState->Index) && this->GpsManager->ComputeSynchronizedMeasureOffset(itState->Time, gpsSynchMeasure))
+        graphManager.AddGpsConstraint(itState->Index, this->GpsManager->GetCalibration(), gpsSynchMeasure);
+    }
+  }
+
+  // Update the graph solution
+  std::vector<unsigned int> updatedIndices;
+  if (!graphManager.Process(updatedIndices))
+  {
+    PRINT_ERROR("Pose graph optimization failed.");
+    // The graph has been restarted
+    this->IncrementalGraphGpsTime = -1.;
+    this->IncrementalGraphLmTimes.clear();
+    return false;
+  }
+  if (updatedIndices.empty())
+  {
+    IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : optimization"));
+    IF_VERBOSE(1, Utils::Timer::StopAndDisplay("Pose graph optimization"));
+    return true;
+  }
+
+  // Only the logged states from the last keyframe preceding the first updated
+  // state are updated : the previous ones keep their pose.
+  // This anchor keyframe has not been updated : it keeps its logged pose.
+  // If there is none, all logged states are updated.
+  auto isAnchor = [&](const LidarState& s)
+  {
+    return s.Index < updatedIndices.front() && s.IsKeyFrame && graphManager.HasState(s.Index);
+  };
+  auto itUpdated = this->LogStates.end();
+  do
+    --itUpdated;
+  while (itUpdated != this->LogStates.begin() && !isAnchor(*itUpdated));
+  const bool anchored = isAnchor(*itUpdated);
+  std::list<LidarState> updatedStates;
+  updatedStates.splice(updatedStates.end(), this->LogStates, itUpdated, this->LogStates.end());
+
+  // Get the graph states to update, with their initial and optimized poses.
+  // Covariances are not updated by the graph optimization :
+  // they are rotated to be consistent with the new poses
+  std::list<LidarState> initialGraphStates, optimizedGraphStates;
+  for (const auto& state : updatedStates)
+  {
+    Eigen::Isometry3d optimizedPose;
+    if (anchored && &state == &updatedStates.front())
+      optimizedPose = state.Isometry;
+    else if (!isGraphState(state) || !graphManager.GetPose(state.Index, optimizedPose))
+      continue;
+    initialGraphStates.push_back(state);
+    optimizedGraphStates.push_back(state);
+    Eigen::Isometry3d Trel = state.Isometry.inverse() * optimizedPose;
+    Eigen::Vector6d pose = Utils::IsometryToXYZRPY(state.Isometry);
+    CeresTools::RotateCovariance(pose, optimizedGraphStates.back().Covariance, Trel); // new = init * Trel
+    optimizedGraphStates.back().Isometry = optimizedPose;
+  }
+  this->UpdateStatesFromOptimized(updatedStates, optimizedGraphStates);
+  this->LogStates.splice(this->LogStates.end(), updatedStates);
+  IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : optimization"));
+  PRINT_VERBOSE(3, updatedIndices.size() << " graph states updated, "
+                   << initialGraphStates.size() << " graph states checked to update the maps");
+
+  // Update the maps with the keyframes which moved
   IF_VERBOSE(3, Utils::Timer::Init("PGO : maps update"));
-  this->UpdateMaps();
+  this->UpdateMapsFromOptimized(this->LocalMaps, this->GetParametersSnapshot(), initialGraphStates, optimizedGraphStates);
   IF_VERBOSE(3, Utils::Timer::StopAndDisplay("PGO : maps update"));
 
   // The last pose has to be updated with new optimized pose
   this->SetWorldTransformFromGuess(this->LogStates.back().Isometry);
 
   IF_VERBOSE(1, Utils::Timer::StopAndDisplay("Pose graph optimization"));
-
   return true;
-
-  #else
-  PRINT_ERROR("SLAM graph optimization requires G2O, but it was not found.");
-  return false;
-  #endif  // USE_G2O
 }
+#endif  // USE_GTSAM
 
 //-----------------------------------------------------------------------------
 void Slam::SetWorldTransformFromGuess(const Eigen::Isometry3d& poseGuess)
@@ -768,6 +1329,8 @@ void Slam::SetWorldTransformFromGuess(const Eigen::Isometry3d& poseGuess)
   this->TworldInit = poseGuess;
   // Set current pose
   this->Tworld = poseGuess;
+  // Registered frame must be updated with the new pose
+  this->RegisteredFrame.reset();
 
   // Ego-Motion estimation is not valid anymore since we imposed a discontinuity.
   // We reset previous pose so that previous ego-motion extrapolation results in Identity matrix.
@@ -825,6 +1388,51 @@ void Slam::LoadMapsFromPCD(const std::string& filePrefix, bool resetMaps)
   IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Keypoints maps loading from PCD"));
 }
 
+//-----------------------------------------------------------------------------
+void Slam::SaveMapsToMapFile(const std::string& filePrefix)
+{
+  IF_VERBOSE(3, Utils::Timer::Init("Keypoints maps saving to map file"));
+
+  // Rebuild LocalMaps to recover the removed points (see SaveMapsToPCD)
+  if ( this->LoggingTimeout > this->GetVoxelGridDecayingThreshold() && this->GetVoxelGridDecayingThreshold() > 0)
+    this->UpdateMaps(true);
+
+  // Save keypoint maps
+  for (auto k : this->UsableKeypoints)
+  {
+    std::string path = filePrefix + Utils::Plural(KeypointTypeNames.at(k)) + ".map";
+    if (this->LocalMaps[k]->Save(path))
+      std::cout << "SLAM keypoints map successfully saved to " << path << std::endl;
+  }
+
+  IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Keypoints maps saving to map file"));
+}
+
+//-----------------------------------------------------------------------------
+void Slam::LoadMapsFromMapFile(const std::string& filePrefix, bool resetMaps)
+{
+  IF_VERBOSE(3, Utils::Timer::Init("Keypoints maps loading from map file"));
+
+  // Reset SLAM internal maps before loading new maps to avoid conflicts.
+  if (resetMaps)
+    this->ClearLocalMaps();
+
+  // If mapping mode is NONE or ADD_DECAYING_KPTS, the first map points are fixed,
+  // else, the initial map points can be updated
+  bool fixedMap = this->MapUpdate == MappingMode::NONE || this->MapUpdate == MappingMode::ADD_KPTS_TO_FIXED_MAP;
+  for (auto k : this->UsableKeypoints)
+  {
+    std::string path = filePrefix + Utils::Plural(KeypointTypeNames.at(k)) + ".map";
+    // Fixed maps can be paged : the tiles are loaded later, around the current pose
+    if (this->MapPaging && this->MapUpdate == MappingMode::NONE && this->LocalMaps[k]->EnablePaging(path, fixedMap))
+      std::cout << "SLAM keypoints map successfully opened for paging from " << path << std::endl;
+    else if (this->LocalMaps[k]->Load(path, fixedMap))
+      std::cout << "SLAM keypoints map successfully loaded from " << path << std::endl;
+  }
+
+  IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Keypoints maps loading from map file"));
+}
+
 //-----------------------------------------------------------------------------
 void Slam::ResetStatePoses(ExternalSensors::PoseManager& newTrajectoryManager)
 {
@@ -876,6 +1484,13 @@ void Slam::ResetStatePoses(ExternalSensors::PoseManager& newTrajectoryManager)
     }
   }
 
+  // The poses have been replaced : the incremental graph is not consistent anymore
+  this->ResetIncrementalGraph();
+
+  // Update current pose, and the registered frame with it
+  this->Tworld = this->LogStates.back().Isometry;
+  this->RegisteredFrame.reset();
+
   // Update LocalMaps with new poses
   this->UpdateMaps();
 }
@@ -937,9 +1552,11 @@ std::unordered_map<std::string, std::vector<double>> Slam::GetDebugArray() const
 Slam::PointCloud::Ptr Slam::GetRegisteredFrame()
 {
   // If the input points have not been aggregated to WORLD coordinates yet,
-  // transform and aggregate them
-  if (this->RegisteredFrame->header.stamp != this->CurrentFrames[0]->header.stamp)
-    this->RegisteredFrame = this->AggregateFrames(this->CurrentFrames, true, true);
+  // transform and aggregate them. The result is cached until the next frame
+  // or pose change, and a new cloud is built each time as the previous one
+  // may still be shared with the caller.
+  if (!this->RegisteredFrame)
+    this->RegisteredFrame = this->AggregateFrames(this->CurrentDownsampledFrames, true, true);
   return this->RegisteredFrame;
 }
 
@@ -1023,6 +1640,7 @@ bool Slam::CheckFrames(const std::vector<PointCloud::Ptr>& frames)
 void Slam::ExtractKeypoints()
 {
   PRINT_VERBOSE(2, "========== Keypoints extraction ==========");
+  Profiling::ScopedTimer timer(this->Timings, Profiling::KEYPOINTS_EXTRACTION);
 
   // Current keypoints become previous ones
   this->PreviousRawKeypoints = this->CurrentRawKeypoints;
@@ -1103,6 +1721,8 @@ bool Slam::InitTworldWithPoseMeasurement(double time)
     }
     this->TworldInit = synchMeas.Pose;
     this->Tworld = synchMeas.Pose;
+    // Registered frame must be updated with the new pose
+    this->RegisteredFrame.reset();
   }
   else
   {
@@ -1132,6 +1752,8 @@ bool Slam::InitTworldWithPoseMeasurement(double time)
     // Update Tworld and TworldInit
     this->Tworld = this->LogStates.back().Isometry;
     this->TworldInit = this->LogStates.front().Isometry;
+    // Registered frame must be updated with the new pose
+    this->RegisteredFrame.reset();
 
     // Update maps from the beginning using the new trajectory
     this->UpdateMaps(true);
@@ -1145,6 +1767,7 @@ bool Slam::InitTworldWithPoseMeasurement(double time)
 void Slam::ComputeEgoMotion()
 {
   PRINT_VERBOSE(2, "========== Ego-Motion ==========");
+  Profiling::ScopedTimer timer(this->Timings, Profiling::EGO_MOTION);
 
   if (this->LogStates.empty())
   {
@@ -1211,8 +1834,9 @@ void Slam::ComputeEgoMotion()
     IF_VERBOSE(3, Utils::Timer::Init("EgoMotion : build KD tree"));
 
     // Build a new submap for PreviousRawKeypoints
+    ParametersSnapshot snapshot = this->GetParametersSnapshot();
     Maps previousKeypoints;
-    this->InitSubMaps(previousKeypoints);
+    this->InitSubMaps(previousKeypoints, snapshot);
     // Reduce the leaf size to get all the keypoints from the previous frame
     for (auto k : this->UsableKeypoints)
       previousKeypoints[k]->SetLeafSize(0.05);
@@ -1246,9 +1870,13 @@ void Slam::ComputeEgoMotion()
     this->EgoMotionParams.MatchingParams.NbThreads = static_cast<unsigned int>(this->NbThreads);
     this->EgoMotionParams.MatchingParams.SingleEdgePerRing = true;
     // ICP - Levenberg-Marquardt loop to update Trelative
-    this->EstimatePose(this->CurrentRawKeypoints, previousKeypoints,
-                       this->EgoMotionParams, this->Trelative,
-                       this->EgoMotionMatchingResults);
+    {
+      Profiling::ScopedTimer icpTimer(this->Timings, Profiling::EGO_MOTION_ICP_LM);
+      this->EstimatePose(this->CurrentRawKeypoints, previousKeypoints, snapshot,
+                         this->EgoMotionParams, this->Trelative,
+                         this->EgoMotionMatchingResults,
+                         this->TotalMatchedKeypoints);
+    }
 
     IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Ego-Motion : whole ICP-LM loop"));
     if (this->Verbosity >= 2)
@@ -1274,6 +1902,7 @@ void Slam::Localization()
   this->LocalizationUncertainty = LocalOptimizer::RegistrationError();
   this->Valid = true;
   PRINT_VERBOSE(2, "========== Localization ==========");
+  Profiling::ScopedTimer timer(this->Timings, Profiling::LOCALIZATION);
 
   // Integrate the relative motion to the world transformation
   // Store previous tworld for next iteration
@@ -1327,6 +1956,16 @@ void Slam::Localization()
   // Get keypoints from maps and build kd-trees for fast nearest neighbors search
   IF_VERBOSE(3, Utils::Timer::Init("Localization : map keypoints extraction"));
 
+  // Estimate the current velocity from the last poses, to prefetch the paged maps tiles ahead
+  Eigen::Vector3f velocity = Eigen::Vector3f::Zero();
+  if (this->MapUpdate == MappingMode::NONE && this->LogStates.size() >= 2)
+  {
+    const LidarState& last = this->LogStates.back();
+    const LidarState& previous = *std::prev(this->LogStates.end(), 2);
+    if (last.Time > previous.Time)
+      velocity = ((last.Isometry.translation() - previous.Isometry.translation()) / (last.Time - previous.Time)).cast<float>();
+  }
+
   // The iteration is not directly on Keypoint types
   // because of openMP behaviour which needs int iteration on MSVC
   int nbKeypointTypes = static_cast<int>(this->UsableKeypoints.size());
@@ -1334,6 +1973,10 @@ void Slam::Localization()
   for (int i = 0; i < nbKeypointTypes; ++i)
   {
     Keypoint k = static_cast<Keypoint>(this->UsableKeypoints[i]);
+    // Load the paged map tiles around the current pose, and prefetch the next ones.
+    // The KD-tree is cleared if the tiles around the current pose have changed.
+    if (this->MapUpdate == MappingMode::NONE && this->LocalMaps[k]->IsPaging())
+      this->LocalMaps[k]->UpdatePaging(this->Tworld.translation().cast<float>(), velocity);
     // Check the current frame contains not null number of k type keypoints
     if (this->CurrentUndistortedKeypoints[k] && this->CurrentUndistortedKeypoints[k]->empty())
       continue;
@@ -1342,6 +1985,8 @@ void Slam::Localization()
     {
       // If maps are fixed, we can build a single KD-tree
       // of the entire map to avoid rebuilding it again
+      // If maps are paged, it is only built on the tiles around the current pose,
+      // and rebuilt when these tiles change
       if (this->MapUpdate == MappingMode::NONE)
         this->LocalMaps[k]->BuildSubMapKdTree();
 
@@ -1387,11 +2032,16 @@ void Slam::Localization()
   this->LocalizationParams.MatchingParams.NbThreads = static_cast<unsigned int>(this->NbThreads);
   this->LocalizationParams.MatchingParams.SingleEdgePerRing = false;
   // ICP - Levenberg-Marquardt loop to update Tworld
-  this->LocalizationUncertainty = this->EstimatePose(this->CurrentUndistortedKeypoints,
-                                                     this->LocalMaps,
-                                                     this->LocalizationParams,
-                                                     this->Tworld,
-                                                     this->LocalizationMatchingResults);
+  {
+    Profiling::ScopedTimer icpTimer(this->Timings, Profiling::LOCALIZATION_ICP_LM);
+    this->LocalizationUncertainty = this->EstimatePose(this->CurrentUndistortedKeypoints,
+                                                       this->LocalMaps,
+                                                       this->GetParametersSnapshot(),
+                                                       this->LocalizationParams,
+                                                       this->Tworld,
+                                                       this->LocalizationMatchingResults,
+                                                       this->TotalMatchedKeypoints);
+  }
   this->Valid = this->LocalizationUncertainty.Valid;
 
   // Reset state to previous one to avoid instability
@@ -1459,6 +2109,7 @@ bool Slam::CheckKeyFrame()
 void Slam::UpdateMapsUsingTworld()
 {
   PRINT_VERBOSE(3, "Adding new keyframe #" << this->KfCounter);
+  Profiling::ScopedTimer timer(this->Timings, Profiling::MAPS_UPDATE);
 
   // Transform keypoints to WORLD coordinates
   for (auto k : this->UsableKeypoints)
@@ -1480,6 +2131,8 @@ void Slam::UpdateMapsUsingTworld()
 //-----------------------------------------------------------------------------
 void Slam::LogCurrentFrameState()
 {
+  Profiling::ScopedTimer timer(this->Timings, Profiling::LOGGING);
+
   // Required number of data to perform interpolation
   size_t requiredNbData = Interpolation::ModelRequiredNbData.at(this->Interpolation);
   // Last poses are logged in any case for motion extrapolation and undistortion
@@ -1515,10 +2168,31 @@ void Slam::LogCurrentFrameState()
   state.Time = this->CurrentTime;
   state.Index = this->NbrFrameProcessed;
   state.IsKeyFrame = this->IsKeyFrame;
+  // The current keypoints clouds are handed over to the logged state without
+  // any copy : they are never modified in place afterwards, as the next frame
+  // processing allocates new clouds.
   for (auto k : this->UsableKeypoints)
   {
-    state.Keypoints[k] = std::make_shared<PCStorage>(this->CurrentUndistortedKeypoints[k], this->LoggingStorage);
-    state.RawKeypoints[k] = std::make_shared<PCStorage>(this->CurrentRawKeypoints[k], this->LoggingStorage);
+    state.Keypoints[k] = std::make_shared<PCStorage>(this->CurrentUndistortedKeypoints[k], this->LoggingStorage,
+                                                     this->LoggingAsync, this->LoggingCodecParams);
+    // If undistortion is disabled, raw and undistorted keypoints are the same
+    // cloud : share the storage to avoid logging (and compressing) it twice.
+    if (this->CurrentRawKeypoints[k] == this->CurrentUndistortedKeypoints[k])
+      state.RawKeypoints[k] = state.Keypoints[k];
+    else
+      state.RawKeypoints[k] = std::make_shared<PCStorage>(this->CurrentRawKeypoints[k], this->LoggingStorage,
+                                                          this->LoggingAsync, this->LoggingCodecParams);
+  }
+
+  // Index the keyframes to be able to detect loop closures automatically
+  if (state.IsKeyFrame && !this->ExtDetectLoopClosure && this->UsePGOConstraints[LOOP_CLOSURE])
+  {
+    IF_VERBOSE(3, Utils::Timer::Init("Loop closure descriptor"));
+    std::vector<PointCloud::ConstPtr> keypoints;
+    for (auto k : this->UsableKeypoints)
+      keypoints.push_back(this->CurrentUndistortedKeypoints[k]);
+    this->LoopDetector.AddFrame(state.Index, keypoints);
+    IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Loop closure descriptor"));
   }
 
   this->LogStates.emplace_back(state);
@@ -1530,6 +2204,7 @@ void Slam::LogCurrentFrameState()
     ++itSt;
     this->LogStates.pop_front();
   }
+  this->LoopDetector.RemoveBefore(this->LogStates.front().Index);
 }
 
 //-----------------------------------------------------------------------------
@@ -1596,9 +2271,10 @@ std::vector<LidarState> Slam::GetLastStates(double freq)
 //   Loop Closure usage
 //==============================================================================
 
-bool Slam::DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryState, std::list<LidarState>::iterator& itRevisitedState)
+bool Slam::DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryState, std::vector<LoopClosureDetector::Candidate>& candidates)
 {
   PRINT_VERBOSE(2, "========== Loop closure : Detection ==========");
+  candidates.clear();
 
   if (this->ExtDetectLoopClosure)
   {
@@ -1607,7 +2283,7 @@ bool Slam::DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryStat
     // It is possible that the inputs frame indices are not keyframes.
     // In this case, replace the input frame index by its neighbor keyframes
     itQueryState = this->LogStates.begin();
-    itRevisitedState = itQueryState;
+    auto itRevisitedState = itQueryState;
     while (itQueryState->Index < this->LoopClosureQueryIdx && itQueryState->Index != this->LogStates.back().Index)
       ++itQueryState;
     if (itQueryState->Index != this->LoopClosureQueryIdx)
@@ -1627,21 +2303,101 @@ bool Slam::DetectLoopClosureIndices(std::list<LidarState>::iterator& itQueryStat
     }
     PRINT_VERBOSE(3, "Loop closure is detected by external information. The relevant frame indices are:\n"
                   << " Query frame #" << itQueryState->Index << " Revisited frame #" << itRevisitedState->Index);
+    // The relative yaw of the frames is unknown
+    itQueryState = this->GetGraphState(itQueryState);
+    candidates.push_back({this->GetGraphState(itRevisitedState)->Index, 0.f, std::numeric_limits<float>::quiet_NaN()});
     return true;
   }
   else
   {
-    // Automatic detection of loop closure will be implemented here
-    // It detects automatically a revisited frame idx for the current frame
+    // Automatic detection : look for a revisited keyframe similar to the last
+    // indexed keyframe, using their place recognition descriptors.
+    // The candidate is then verified by the loop closure registration.
+    // Candidates and query frames are keyframes, so they are used in the pose graph.
     itQueryState = this->LogStates.end();
-    itRevisitedState = this->LogStates.begin();
+    if (this->LoopDetector.Size() == 0)
+    {
+      PRINT_WARNING("No keyframe is indexed for loop closure detection.");
+      return false;
+    }
+
+    IF_VERBOSE(3, Utils::Timer::Init("Loop closure detection"));
+    unsigned int queryIdx = this->LoopDetector.GetLastIndex();
+    candidates = this->LoopDetector.FindCandidates(queryIdx);
+    IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Loop closure detection"));
+
+    // Get the logged states of the query frame and of the candidates
+    // (the index only contains logged states, but it is safer to check it)
+    auto findState = [this](unsigned int idx)
+    {
+      return std::find_if(this->LogStates.begin(), this->LogStates.end(),
+                          [idx](const LidarState& s) { return s.Index == idx; });
+    };
+    itQueryState = findState(queryIdx);
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [&](const LoopClosureDetector::Candidate& c) { return findState(c.Index) == this->LogStates.end(); }),
+                     candidates.end());
+    if (candidates.empty())
+      return false;
+    if (itQueryState == this->LogStates.end())
+    {
+      PRINT_WARNING("The detected loop closure frames are not found in Logstates.");
+      candidates.clear();
+      return false;
+    }
+    // The user-facing LoopClosureQueryIdx and LoopClosureRevisitedIdx are left untouched,
+    // as they are the inputs of the external detection
+    PRINT_VERBOSE(3, "Loop closure is detected automatically. The relevant frame indices are:\n"
+                  << " Query frame #" << queryIdx << " Revisited frame #" << candidates.front().Index
+                  << " (descriptor distance : " << candidates.front().Distance
+                  << ", yaw : " << Utils::Rad2Deg(candidates.front().Yaw) << "°)"
+                  << ", and " << candidates.size() - 1 << " other candidates");
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::RegisterLoopClosureCandidates(const ParametersSnapshot& params,
+                                         const std::list<LidarState>& states,
+                                         unsigned int queryIdx,
+                                         const std::vector<LoopClosureDetector::Candidate>& candidates,
+                                         unsigned int& revisitedIdx,
+                                         Eigen::Isometry3d& loopClosureTransform,
+                                         Eigen::Matrix6d& loopClosureCovariance)
+{
+  auto findState = [&states](unsigned int idx)
+  {
+    return std::find_if(states.cbegin(), states.cend(),
+                        [idx](const LidarState& s) { return s.Index == idx; });
+  };
+  auto itQueryState = findState(queryIdx);
+  if (itQueryState == states.cend())
     return false;
+
+  // The best candidate may be a false positive of the place recognition :
+  // try the next ones if its registration fails.
+  for (const auto& candidate : candidates)
+  {
+    auto itRevisitedState = findState(candidate.Index);
+    if (itRevisitedState == states.cend())
+      continue;
+    if (this->LoopClosureRegistration(params, states, itQueryState, itRevisitedState, candidate.Yaw,
+                                      loopClosureTransform, loopClosureCovariance))
+    {
+      revisitedIdx = candidate.Index;
+      return true;
+    }
+    PRINT_VERBOSE(2, "Loop closure registration failed onto revisited frame #" << candidate.Index << ".");
   }
+  return false;
 }
 
 //-----------------------------------------------------------------------------
-bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState,
-                                   std::list<LidarState>::iterator& itRevisitedState,
+bool Slam::LoopClosureRegistration(const ParametersSnapshot& params,
+                                   const std::list<LidarState>& states,
+                                   std::list<LidarState>::const_iterator itQueryState,
+                                   std::list<LidarState>::const_iterator itRevisitedState,
+                                   float yaw,
                                    Eigen::Isometry3d& loopClosureTransform,
                                    Eigen::Matrix6d& loopClosureCovariance)
 {
@@ -1651,19 +2407,27 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
 
   // Create a submap around revisited frame where a loop is detected
   Maps loopClosureRevisitedSubMaps;
-  this->InitSubMaps(loopClosureRevisitedSubMaps);
-  this->BuildMaps(loopClosureRevisitedSubMaps,
-                  itRevisitedState->Index + this->LCRevisitedWindowStartRange,
-                  itRevisitedState->Index + this->LCRevisitedWindowEndRange);
+  this->InitSubMaps(loopClosureRevisitedSubMaps, params);
+  this->BuildMaps(loopClosureRevisitedSubMaps, states, params,
+                  itRevisitedState->Index + params.LCRevisitedWindowStartRange,
+                  itRevisitedState->Index + params.LCRevisitedWindowEndRange);
   PRINT_VERBOSE(3, "Sub maps are created around revisited frame #" << itRevisitedState->Index << ".");
 
-  // Pose prior for optimization
+  // Pose prior for optimization.
+  // If the heading of the query frame relatively to the revisited frame is known,
+  // use it : the query frame is placed at the revisited pose, rotated by this yaw.
+  // Otherwise, use the query pose, which may have drifted.
   Eigen::Isometry3d loopClosureTworld = itQueryState->Isometry;
+  if (std::isfinite(yaw))
+  {
+    loopClosureTworld = itRevisitedState->Isometry * Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ());
+    PRINT_VERBOSE(3, "The pose prior is initialized with the detected yaw (" << Utils::Rad2Deg(yaw) << "°).");
+  }
   // Enable to add an offset to the pose prior when two poses are too far from each other.
-  if (this->EnableLoopClosureOffset)
+  if (params.EnableLoopClosureOffset)
   {
     PointCloud::Ptr revisitedPlaneKeypoints(new PointCloud);
-    pcl::transformPointCloud(*(itRevisitedState->Keypoints[PLANE]->GetCloud()),
+    pcl::transformPointCloud(*(itRevisitedState->Keypoints.at(PLANE)->GetCloud()),
                              *revisitedPlaneKeypoints,
                              itRevisitedState->Isometry.matrix().cast<float>());
     Eigen::Vector4f minPoint, maxPoint, midPoint;
@@ -1677,35 +2441,35 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
   // Otherwise, use only keypoints of query frame as query keypoints
   // loopClosureQueryKeypoints are in BASE coordinates of query frame
   std::map<Keypoint, PointCloud::Ptr> loopClosureQueryKeypoints;
-  for (auto k : this->UsableKeypoints)
+  for (auto k : params.UsableKeypoints)
     loopClosureQueryKeypoints[k].reset(new PointCloud);
-  if (this->LoopClosureICPWithSubmap)
+  if (params.LoopClosureICPWithSubmap)
   {
     Maps loopClosureQuerySubMaps;
-    this->InitSubMaps(loopClosureQuerySubMaps);
-    this->BuildMaps(loopClosureQuerySubMaps,
-                    itQueryState->Index + this->LCQueryWindowStartRange,
-                    itQueryState->Index + this->LCQueryWindowEndRange,
+    this->InitSubMaps(loopClosureQuerySubMaps, params);
+    this->BuildMaps(loopClosureQuerySubMaps, states, params,
+                    itQueryState->Index + params.LCQueryWindowStartRange,
+                    itQueryState->Index + params.LCQueryWindowEndRange,
                     itQueryState->Index);
     PRINT_VERBOSE(3, "Sub maps are created around query frame #" << itQueryState->Index << ".");
-    for (auto k : this->UsableKeypoints)
+    for (auto k : params.UsableKeypoints)
       loopClosureQueryKeypoints[k] = loopClosureQuerySubMaps[k]->Get();
   }
   else
   {
-    for (auto k : this->UsableKeypoints)
-      loopClosureQueryKeypoints[k] = itQueryState->Keypoints[k]->GetCloud();
+    for (auto k : params.UsableKeypoints)
+      loopClosureQueryKeypoints[k].reset(new PointCloud(*itQueryState->Keypoints.at(k)->GetCloud()));
   }
 
   IF_VERBOSE(3, Utils::Timer::Init("Loop closure Registration : submap keypoints extraction"));
   // Build kd-trees for fast nearest neighbors search from keypoints of loop closure sub map
   // The iteration is not directly on Keypoint types
   // because of openMP behaviour which needs int iteration on MSVC
-  int nbKeypointTypes = static_cast<int>(this->UsableKeypoints.size());
-  #pragma omp parallel for num_threads(std::min(this->NbThreads, nbKeypointTypes))
+  int nbKeypointTypes = static_cast<int>(params.UsableKeypoints.size());
+  #pragma omp parallel for num_threads(std::min(params.NbThreads, nbKeypointTypes))
   for (int i = 0; i < nbKeypointTypes; ++i)
   {
-    Keypoint k = static_cast<Keypoint>(this->UsableKeypoints[i]);
+    Keypoint k = static_cast<Keypoint>(params.UsableKeypoints[i]);
     if (!loopClosureRevisitedSubMaps[k]->IsSubMapKdTreeValid())
       loopClosureRevisitedSubMaps[k]->BuildSubMapKdTree();
   }
@@ -1713,7 +2477,7 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
   if (this->Verbosity >= 2)
   {
     std::cout << "Keypoints extracted from loop closure sub map : ";
-    for (auto k : this->UsableKeypoints)
+    for (auto k : params.UsableKeypoints)
       std::cout << loopClosureRevisitedSubMaps[k]->GetSubMapKdTree().GetInputCloud()->size()
                 << " " << Utils::Plural(KeypointTypeNames.at(k)) << " ";
     std::cout << std::endl;
@@ -1722,16 +2486,19 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
   IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Loop closure Registration : map keypoints extraction"));
   IF_VERBOSE(3, Utils::Timer::Init("Loop closure Registration : whole ICP-LM loop"));
 
-  // Reset ICP results
-  this->TotalMatchedKeypoints = 0;
+  // Loop closure registration can run in a background thread (see OptimizeGraphAsync) :
+  // use local copies of the parameters and results shared with frames processing.
+  Optimization::Parameters loopClosureParams = params.LoopClosureParams;
+  std::map<Keypoint, KeypointsMatcher::MatchingResults> loopClosureMatchingResults;
+  unsigned int totalMatchedKeypoints = 0;
 
   // Set loop closure parameters which do not have a setter
-  this->LoopClosureParams.MatchingParams.NbThreads = static_cast<unsigned int>(this->NbThreads);
-  this->LoopClosureParams.MatchingParams.SingleEdgePerRing = false;
+  loopClosureParams.MatchingParams.NbThreads = static_cast<unsigned int>(params.NbThreads);
+  loopClosureParams.MatchingParams.SingleEdgePerRing = false;
   // ICP - Levenberg-Marquardt loop to estimate the pose of the current frame relatively to the close loop frame
-  loopClosureUncertainty = this->EstimatePose(loopClosureQueryKeypoints, loopClosureRevisitedSubMaps,
-                                              this->LoopClosureParams, loopClosureTworld,
-                                              this->LoopClosureMatchingResults);
+  loopClosureUncertainty = this->EstimatePose(loopClosureQueryKeypoints, loopClosureRevisitedSubMaps, params,
+                                              loopClosureParams, loopClosureTworld,
+                                              loopClosureMatchingResults, totalMatchedKeypoints);
 
   IF_VERBOSE(3, Utils::Timer::StopAndDisplay("Loop closure Registration : whole ICP-LM loop"));
 
@@ -1742,13 +2509,13 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
   }
 
   // Get covariance
-  Eigen::Matrix6d covariance = std::pow(this->CovarianceScale, 2) * loopClosureUncertainty.Covariance;
+  Eigen::Matrix6d covariance = std::pow(params.CovarianceScale, 2) * loopClosureUncertainty.Covariance;
   float defaultPositionError = 1e-2; // 1cm
   float defaultAngleError = Utils::Deg2Rad(1.f); // 1°
   if (!Utils::isCovarianceValid(covariance))
     covariance = Utils::CreateDefaultCovariance(defaultPositionError, defaultAngleError);
   // If 2D mode enabled, supply constant covariance for unevaluated variables
-  if (this->TwoDMode)
+  if (params.TwoDMode)
   {
     covariance(2, 2) = std::pow(defaultPositionError, 2);
     covariance(3, 3) = std::pow(defaultAngleError,    2);
@@ -1767,9 +2534,9 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
   if (this->Verbosity >= 2)
   {
     SET_COUT_FIXED_PRECISION(3);
-    std::cout << "Loop closure matched keypoints: " << this->TotalMatchedKeypoints << " (";
-    for (auto k : this->UsableKeypoints)
-      std::cout << this->LoopClosureMatchingResults[k].NbMatches() << " " << Utils::Plural(KeypointTypeNames.at(k)) << " ";
+    std::cout << "Loop closure matched keypoints: " << totalMatchedKeypoints << " (";
+    for (auto k : params.UsableKeypoints)
+      std::cout << loopClosureMatchingResults[k].NbMatches() << " " << Utils::Plural(KeypointTypeNames.at(k)) << " ";
 
     std::cout << ")"
               << "\nLoop closure position uncertainty    = " << loopClosureUncertainty.PositionError    << " m"
@@ -1791,34 +2558,64 @@ bool Slam::LoopClosureRegistration(std::list<LidarState>::iterator& itQueryState
 //==============================================================================
 
 //-----------------------------------------------------------------------------
-void Slam::InitSubMaps(Maps& maps)
+Slam::ParametersSnapshot Slam::GetParametersSnapshot(bool copyGrids) const
+{
+  ParametersSnapshot params;
+  params.UsableKeypoints = this->UsableKeypoints;
+  for (auto k : this->UsableKeypoints)
+  {
+    if (!copyGrids)
+      params.Grids[k] = this->LocalMaps.at(k);
+    else
+    {
+      params.Grids[k] = std::make_shared<RollingGrid>();
+      params.Grids[k]->CopyParameters(*this->LocalMaps.at(k));
+    }
+  }
+  params.NbThreads = this->NbThreads;
+  params.TwoDMode = this->TwoDMode;
+  params.MinNbMatchedKeypoints = this->MinNbMatchedKeypoints;
+  params.MapUpdateDistanceThreshold = this->MapUpdateDistanceThreshold;
+  params.MapUpdateAngleThreshold = this->MapUpdateAngleThreshold;
+  params.LoopClosureParams = this->LoopClosureParams;
+  params.LCQueryWindowStartRange = this->LCQueryWindowStartRange;
+  params.LCQueryWindowEndRange = this->LCQueryWindowEndRange;
+  params.LCRevisitedWindowStartRange = this->LCRevisitedWindowStartRange;
+  params.LCRevisitedWindowEndRange = this->LCRevisitedWindowEndRange;
+  params.EnableLoopClosureOffset = this->EnableLoopClosureOffset;
+  params.LoopClosureICPWithSubmap = this->LoopClosureICPWithSubmap;
+  params.CovarianceScale = this->CovarianceScale;
+  return params;
+}
+
+//-----------------------------------------------------------------------------
+void Slam::InitSubMaps(Maps& maps, const ParametersSnapshot& params)
 {
   // Reset previous sub maps
   this->ClearMaps(maps);
 
-  // Init SubMaps for each keypoint type with the same resolution as the one used in LocalMaps
-  for (auto k : this->UsableKeypoints)
+  // Init SubMaps for each keypoint type with the same resolution as the one used in the snapshot grids
+  for (auto k : params.UsableKeypoints)
   {
     maps[k] = std::make_shared<RollingGrid>();
-    maps[k]->SetVoxelResolution(this->LocalMaps[k]->GetVoxelResolution());
-    maps[k]->SetGridSize(this->LocalMaps[k]->GetGridSize());
-    maps[k]->SetLeafSize(this->LocalMaps[k]->GetLeafSize());
+    maps[k]->CopyParameters(*params.Grids.at(k));
   }
 }
 
 //-----------------------------------------------------------------------------
-void Slam::BuildMaps(Maps& maps, int windowStartIdx, int windowEndIdx, int idxFrame)
+void Slam::BuildMaps(Maps& maps, const std::list<LidarState>& states, const ParametersSnapshot& params,
+                     int windowStartIdx, int windowEndIdx, int idxFrame)
 {
-  // If default values of windowStartIdx and windowEndIdx are used, build maps with all frames stored in LogStates.
+  // If default values of windowStartIdx and windowEndIdx are used, build maps with all frames stored in states.
   // Otherwise, create a sub map with frames [windowStartIdx, windowEndIdx].
   unsigned int idxMin = static_cast<unsigned int>(std::max(0, windowStartIdx));
-  unsigned int idxMax = windowEndIdx < 0 ? this->LogStates.back().Index : std::min(this->LogStates.back().Index, static_cast<unsigned int>(windowEndIdx));
+  unsigned int idxMax = windowEndIdx < 0 ? states.back().Index : std::min(states.back().Index, static_cast<unsigned int>(windowEndIdx));
 
   // Keypoints are aggregated in base coordinates of frame #idxFrame
   Eigen::Isometry3d currentBaseInv = Eigen::Isometry3d::Identity();
   if (idxFrame >= 0)
   {
-    for (auto& state : this->LogStates)
+    for (auto& state : states)
     {
       if (state.Index == static_cast<unsigned int>(idxFrame))
       {
@@ -1828,34 +2625,48 @@ void Slam::BuildMaps(Maps& maps, int windowStartIdx, int windowEndIdx, int idxFr
     }
   }
 
-  // The iteration is not directly on Keypoint types
-  // because of openMP behaviour which needs int iteration on MSVC
-  int nbKeypointTypes = static_cast<int>(this->UsableKeypoints.size());
-  #pragma omp parallel for num_threads(std::min(this->NbThreads, nbKeypointTypes))
-  for (int i = 0; i < nbKeypointTypes; ++i)
+  // Select the keyframes to aggregate
+  std::vector<const LidarState*> keyFrames;
+  for (auto& state : states)
   {
-    Keypoint k = static_cast<Keypoint>(this->UsableKeypoints[i]);
-    PointCloud::Ptr keypoints(new PointCloud);
+    if (!state.IsKeyFrame || state.Index < idxMin)
+      continue;
+    if (state.Index > idxMax)
+      break;
+    keyFrames.push_back(&state);
+  }
+  int nbKeyFrames = keyFrames.size();
 
-    // Roll to center onto last pose to make sure slam can follow the trajectory after the maps have been updated
-    Eigen::Vector4f minPoint, maxPoint;
-    pcl::getMinMax3D(*this->LogStates.back().Keypoints[k]->GetCloud(), minPoint, maxPoint);
-    maps[k]->Roll(minPoint.head<3>().array(), maxPoint.head<3>().array());
+  // Keyframes are processed by batches to limit memory usage
+  const int batchSize = 64 * params.NbThreads;
 
-    for (auto& state : this->LogStates)
+  for (auto k : params.UsableKeypoints)
+  {
+    for (int batchStart = 0; batchStart < nbKeyFrames; batchStart += batchSize)
     {
-      if (!state.IsKeyFrame || state.Index < idxMin)
-        continue;
-      if (state.Index > idxMax)
-        break;
+      int batchEnd = std::min(batchStart + batchSize, nbKeyFrames);
+
+      // Decompress and transform keyframes keypoints concurrently
       // Keypoints are stored undistorted : because of the keyframes mechanism,
       // undistortion cannot be refined during pose graph
       // We rely on a good first estimation of the in-frame motion
-      keypoints.reset(new PointCloud);
-      PointCloud::Ptr undistortedKeypoints = state.Keypoints[k]->GetCloud();
-      auto transform = idxFrame >= 0 ? currentBaseInv.matrix() * state.Isometry.matrix() : state.Isometry.matrix();
-      pcl::transformPointCloud(*undistortedKeypoints, *keypoints, transform.cast<float>());
-      maps[k]->Add(keypoints, false);
+      std::vector<PointCloud::ConstPtr> keypoints(batchEnd - batchStart);
+      #pragma omp parallel for num_threads(params.NbThreads) schedule(dynamic)
+      for (int i = batchStart; i < batchEnd; ++i)
+      {
+        const LidarState& state = *keyFrames[i];
+        PointCloud::ConstPtr undistortedKeypoints = state.Keypoints.at(k)->GetCloud();
+        PointCloud::Ptr transformedKeypoints(new PointCloud);
+        auto transform = idxFrame >= 0 ? currentBaseInv.matrix() * state.Isometry.matrix() : state.Isometry.matrix();
+        pcl::transformPointCloud(*undistortedKeypoints, *transformedKeypoints, transform.cast<float>());
+        keypoints[i - batchStart] = transformedKeypoints;
+      }
+
+      // Add them to the map in keyframes order, the map voxels being split between threads.
+      // The map is rolled onto the transformed keypoints, following the trajectory
+      // if it is larger than the map, to end up centered around the last keyframes :
+      // this makes sure slam can follow the trajectory after the maps have been updated
+      maps[k]->Add(keypoints, false, params.NbThreads);
     }
   }
 }
@@ -1863,14 +2674,16 @@ void Slam::BuildMaps(Maps& maps, int windowStartIdx, int windowEndIdx, int idxFr
 //-----------------------------------------------------------------------------
 LocalOptimizer::RegistrationError Slam::EstimatePose(const std::map<Keypoint, PointCloud::Ptr>& sourceKeypoints,
                                                      const Maps& targetKeypoints,
+                                                     const ParametersSnapshot& snapshot,
                                                      Optimization::Parameters& params,
                                                      Eigen::Isometry3d& posePrior,
-                                                     std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults)
+                                                     std::map<Keypoint, KeypointsMatcher::MatchingResults>& matchingResults,
+                                                     unsigned int& totalMatchedKeypoints)
 {
   LocalOptimizer::RegistrationError optimizationUncertainty = LocalOptimizer::RegistrationError();
 
   // Reset ICP results
-  this->TotalMatchedKeypoints = 0;
+  totalMatchedKeypoints = 0;
 
   // ICP - Levenberg-Marquardt loop
   // At each step of this loop an ICP matching is performed. Once the keypoints
@@ -1894,15 +2707,15 @@ LocalOptimizer::RegistrationError Slam::EstimatePose(const std::map<Keypoint, Po
     KeypointsMatcher matcher(params.MatchingParams, posePrior);
 
     // Loop over keypoints to build the point to line residuals
-    this->TotalMatchedKeypoints = 0;
-    for (auto k : this->UsableKeypoints)
+    totalMatchedKeypoints = 0;
+    for (auto k : snapshot.UsableKeypoints)
     {
       matchingResults[k] = matcher.BuildMatchResiduals(sourceKeypoints.at(k), targetKeypoints.at(k)->GetSubMapKdTree(), k);
-      this->TotalMatchedKeypoints += matchingResults[k].NbMatches();
+      totalMatchedKeypoints += matchingResults[k].NbMatches();
     }
 
     // Skip frame if not enough keypoints are extracted
-    if (this->TotalMatchedKeypoints < this->MinNbMatchedKeypoints)
+    if (totalMatchedKeypoints < snapshot.MinNbMatchedKeypoints)
     {
       PRINT_ERROR("Not enough keypoints matched, Pose estimation skipped for this frame.");
       optimizationUncertainty.Valid = false;
@@ -1914,13 +2727,13 @@ LocalOptimizer::RegistrationError Slam::EstimatePose(const std::map<Keypoint, Po
 
     // Init the optimizer with initial pose and parameters
     LocalOptimizer optimizer;
-    optimizer.SetTwoDMode(this->TwoDMode);
+    optimizer.SetTwoDMode(snapshot.TwoDMode);
     optimizer.SetPosePrior(posePrior);
     optimizer.SetLMMaxIter(params.LMMaxIter);
-    optimizer.SetNbThreads(this->NbThreads);
+    optimizer.SetNbThreads(snapshot.NbThreads);
 
     // Add LiDAR ICP matches
-    for (auto k : this->UsableKeypoints)
+    for (auto k : snapshot.UsableKeypoints)
       optimizer.AddResiduals(matchingResults[k].Residuals);
 
     if (params.EnableExternalConstraints)
@@ -1968,7 +2781,7 @@ LocalOptimizer::RegistrationError Slam::EstimatePose(const std::map<Keypoint, Po
     // Optionally refine undistortion
     if (params.Undistortion == UndistortionMode::REFINED)
     {
-      for (auto k : this->UsableKeypoints)
+      for (auto k : snapshot.UsableKeypoints)
         this->UndistortWithLogStates(this->CurrentRawKeypoints[k],
                                      this->CurrentUndistortedKeypoints[k],
                                      true); // true -> current Tworld is used to undistort with LogStates
@@ -2171,11 +2984,11 @@ void Slam::UndistortWithPoseMeasurement(PointCloud::Ptr pc, double refTime,
     endIdx = pc->size();
 
   // Compute synchronized measures (not parallelizable)
-  std::vector<ExternalSensors::PoseMeasurement> synchMeas(pc->size()); // Virtual measures with synchronized timestamp and calibration applied
+  std::vector<ExternalSensors::PoseMeasurement> synchMeas(endIdx - startIdx); // Virtual measures with synchronized timestamp and calibration applied
 
   // Compute the synchronized pose for each point
   for (int idxPt = startIdx; idxPt < endIdx; ++idxPt)
-    this->PoseManager->ComputeSynchronizedMeasureBase(refTime + pc->at(idxPt).time + timeOffset, synchMeas[idxPt]);
+    this->PoseManager->ComputeSynchronizedMeasureBase(refTime + pc->at(idxPt).time + timeOffset, synchMeas[idxPt - startIdx]);
 
   // Compute synchronized poses for each point
   Eigen::Isometry3d invSynchPoseMeasCurrent = synchPoseMeasCurrent.Pose.inverse();
@@ -2185,7 +2998,7 @@ void Slam::UndistortWithPoseMeasurement(PointCloud::Ptr pc, double refTime,
   for (int idxPt = startIdx; idxPt < endIdx; ++idxPt)
   {
     // Get transform from base at current time to base at point time
-    Eigen::Isometry3d update = invSynchPoseMeasCurrent * synchMeas[idxPt].Pose * baseToPointsRef;
+    Eigen::Isometry3d update = invSynchPoseMeasCurrent * synchMeas[idxPt - startIdx].Pose * baseToPointsRef;
     Utils::TransformPoint(pc->at(idxPt), update);
   }
 
@@ -2210,6 +3023,28 @@ void Slam::SetOverlapSamplingRatio (float _arg)
 //-----------------------------------------------------------------------------
 void Slam::EstimateOverlap()
 {
+  // Ratio of the keypoints matched during Localization :
+  // no new computation is needed
+  if (this->OverlapEstimator == OverlapMode::MATCHING)
+  {
+    this->OverlapEstimation = Confidence::MatchingEstimator(this->LocalizationMatchingResults);
+    PRINT_VERBOSE(3, "Overlap : " << this->OverlapEstimation << ", estimated from localization matches.");
+    return;
+  }
+
+  // Occupancy of the map voxels by the keypoints : the maps hash grids are
+  // used directly, and the keypoints do not need to be aggregated
+  if (this->OverlapEstimator == OverlapMode::VOXEL_OCCUPANCY)
+  {
+    Maps mapsToUse;
+    for (auto k : this->UsableKeypoints)
+      mapsToUse[k] = this->LocalMaps[k];
+    this->OverlapEstimation = Confidence::VoxelOccupancyEstimator(this->CurrentUndistortedKeypoints, this->Tworld, mapsToUse,
+                                                                  this->OverlapSamplingRatio, this->NbThreads);
+    PRINT_VERBOSE(3, "Overlap : " << this->OverlapEstimation << ", estimated from keypoints voxels occupancy.");
+    return;
+  }
+
   // Aggregate all input points into WORLD coordinates
   PointCloud::Ptr aggregatedPoints = this->GetRegisteredFrame();
 
@@ -2359,17 +3194,23 @@ Slam::PointCloud::Ptr Slam::AggregateFrames(const std::vector<PointCloud::Ptr>&
                                                    worldCoordinates ? this->WorldFrameId : this->BaseFrameId,
                                                    this->NbrFrameProcessed);
 
+  // Allocate output once : each frame is then processed in place in its own slice
+  std::size_t nbPoints = 0;
+  for (const auto& frame: frames)
+    nbPoints += frame->size();
+  aggregatedFrames->resize(nbPoints);
+
   // Loop over frames of input
+  int startIdx = 0;
   for (const auto& frame: frames)
   {
     // If the frame is empty, ignore it
     if (frame->empty())
       continue;
 
-    // Add frame to aggregated output
-    int startIdx = aggregatedFrames->size();
+    // Slice of the aggregated output filled by this frame
     int endIdx = startIdx + frame->size();
-    *aggregatedFrames += *frame;
+    aggregatedFrames->is_dense = aggregatedFrames->is_dense && frame->is_dense;
 
     // Modify point-wise time offsets to match header.stamp
     // And transform points from LIDAR to BASE or WORLD coordinate system
@@ -2380,25 +3221,28 @@ Slam::PointCloud::Ptr Slam::AggregateFrames(const std::vector<PointCloud::Ptr>&
     // Rigid transform from LIDAR to BASE then undistortion from BASE to WORLD
     if (undistort)
     {
+      // Copy raw points to their slice, they are then undistorted in place
+      std::copy(frame->begin(), frame->end(), aggregatedFrames->begin() + startIdx);
+
       if (this->Undistortion != UndistortionMode::EXTERNAL || !this->PoseHasData())
       {
         // Undistort using interpolation between logged states
         this->UndistortWithLogStates(aggregatedFrames, aggregatedFrames,
                                      false, // false -> Tworld is not used for the undistortion
-                                     startIdx, aggregatedFrames->size(),
+                                     startIdx, endIdx,
                                      baseToLidar, timeOffset);
       }
       else
       {
         // Undistort using interpolation between logged measurements
         this->UndistortWithPoseMeasurement(aggregatedFrames, this->CurrentTime,
-                                           startIdx, aggregatedFrames->size(),
+                                           startIdx, endIdx,
                                            baseToLidar, timeOffset);
       }
 
       // Update times
       #pragma omp parallel for num_threads(this->NbThreads)
-      for (int idxPt = startIdx; idxPt < int(aggregatedFrames->size()); ++idxPt)
+      for (int idxPt = startIdx; idxPt < endIdx; ++idxPt)
       {
         aggregatedFrames->at(idxPt).time += timeOffset;
         // Transform point to world frame if requested
@@ -2408,28 +3252,25 @@ Slam::PointCloud::Ptr Slam::AggregateFrames(const std::vector<PointCloud::Ptr>&
     }
 
     // Rigid transform from LIDAR to BASE or WORLD coordinate system
+    // Points are copied and transformed in a single pass
     else
     {
       // Get rigid transform to apply
       Eigen::Isometry3d tf = worldCoordinates ? this->Tworld * baseToLidar : baseToLidar;
       // If transform to apply is identity, avoid much work
-      if (tf.isApprox(Eigen::Isometry3d::Identity()))
-      {
-        #pragma omp parallel for num_threads(this->NbThreads)
-        for (int i = startIdx; i < endIdx; ++i)
-          aggregatedFrames->at(i).time += timeOffset;
-      }
-      // If transform is non trivial, run transformation
-      else
+      bool isIdentity = tf.isApprox(Eigen::Isometry3d::Identity());
+      #pragma omp parallel for num_threads(this->NbThreads)
+      for (int i = startIdx; i < endIdx; ++i)
       {
-        #pragma omp parallel for num_threads(this->NbThreads)
-        for (int i = startIdx; i < endIdx; ++i)
-        {
-          aggregatedFrames->at(i).time += timeOffset;
-          Utils::TransformPoint(aggregatedFrames->at(i), tf);
-        }
+        auto& point = aggregatedFrames->at(i);
+        point = frame->at(i - startIdx);
+        point.time += timeOffset;
+        if (!isIdentity)
+          Utils::TransformPoint(point, tf);
       }
     }
+
+    startIdx = endIdx;
   }
 
   return aggregatedFrames;
@@ -2733,6 +3574,8 @@ bool Slam::CalibrateWithGps()
     // Transform pose
     s.Isometry = firstInverse * s.Isometry;
   }
+  // The world frame changed : the incremental graph is not consistent anymore
+  this->ResetIncrementalGraph();
 
   // Update the maps and the pose with the new trajectory
   this->UpdateMaps();
@@ -3085,6 +3928,7 @@ void Slam::ClearLog()
 
   this->LogStates.clear();
   this->LogStates = storeLog;
+  this->LoopDetector.RemoveBefore(this->LogStates.front().Index);
 }
 
 //-----------------------------------------------------------------------------
@@ -3145,10 +3989,79 @@ void Slam::SetVoxelGridMinFramesPerVoxel(unsigned int minFrames)
     this->LocalMaps[k]->SetMinFramesPerVoxel(minFrames);
 }
 
+//-----------------------------------------------------------------------------
+double Slam::GetMapPagingRadius() const
+{
+  return this->LocalMaps.begin()->second->GetPagingRadius();
+}
+
+//-----------------------------------------------------------------------------
+void Slam::SetMapPagingRadius(double radius)
+{
+  for (auto k : this->UsableKeypoints)
+    this->LocalMaps[k]->SetPagingRadius(radius);
+}
+
+//-----------------------------------------------------------------------------
+double Slam::GetMapPagingLookAhead() const
+{
+  return this->LocalMaps.begin()->second->GetPagingLookAhead();
+}
+
+//-----------------------------------------------------------------------------
+void Slam::SetMapPagingLookAhead(double duration)
+{
+  for (auto k : this->UsableKeypoints)
+    this->LocalMaps[k]->SetPagingLookAhead(duration);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Slam::GetMapPagingMaxPoints() const
+{
+  return this->LocalMaps.begin()->second->GetPagingMaxPoints();
+}
+
+//-----------------------------------------------------------------------------
+void Slam::SetMapPagingMaxPoints(unsigned int maxPoints)
+{
+  for (auto k : this->UsableKeypoints)
+    this->LocalMaps[k]->SetPagingMaxPoints(maxPoints);
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::GetMapChangesTracking() const
+{
+  return this->LocalMaps.begin()->second->GetTrackChanges();
+}
+
+//-----------------------------------------------------------------------------
+void Slam::SetMapChangesTracking(bool track)
+{
+  for (auto k : this->UsableKeypoints)
+    this->LocalMaps[k]->SetTrackChanges(track);
+}
+
+//-----------------------------------------------------------------------------
+RollingGrid::Changes Slam::GetMapChanges(Keypoint k, bool all)
+{
+  return this->LocalMaps.at(k)->TakeChanges(all);
+}
+
 //==============================================================================
 //   Memory parameters setting
 //==============================================================================
 
+//-----------------------------------------------------------------------------
+void Slam::SetLoggingPrecision(double precision)
+{
+  if (!Codec::Parameters::IsPrecisionValid(precision))
+  {
+    PRINT_ERROR("Logging precision must be positive : " << precision << " is ignored.");
+    return;
+  }
+  this->LoggingCodecParams.PositionPrecision = precision;
+}
+
 //-----------------------------------------------------------------------------
 void Slam::SetLoggingTimeout(double lMax)
 {
@@ -20,6 +20,7 @@
 
 #include <unordered_map>
 #include <chrono>
+#include <mutex>
 
 namespace LidarSlam
 {
@@ -119,11 +120,14 @@ namespace Timer
     std::unordered_map<std::string, std::chrono::steady_clock::time_point> startTimestamps;
     std::unordered_map<std::string, double> totalDurations;
     std::unordered_map<std::string, unsigned int> totalCalls;
+    // Timers can be used from several threads (e.g. background graph optimization)
+    std::mutex timersMutex;
   } // end of anonymous namespace
 
   //----------------------------------------------------------------------------
   void Reset()
   {
+    std::lock_guard<std::mutex> lock(timersMutex);
     startTimestamps.clear();
     totalDurations.clear();
     totalCalls.clear();
@@ -132,12 +136,14 @@ namespace Timer
   //----------------------------------------------------------------------------
   void Init(const std::string& timer)
   {
+    std::lock_guard<std::mutex> lock(timersMutex);
     startTimestamps[timer] = std::chrono::steady_clock::now();
   }
 
   //----------------------------------------------------------------------------
   double Stop(const std::string& timer)
   {
+    std::lock_guard<std::mutex> lock(timersMutex);
     std::chrono::duration<double> chrono_s = std::chrono::steady_clock::now() - startTimestamps[timer];
     double duration = chrono_s.count();
     totalDurations[timer] += duration;
@@ -149,7 +155,11 @@ namespace Timer
   void StopAndDisplay(const std::string& timer, int nbDigits)
   {
     const double currentDuration = Stop(timer);
-    double meanDurationMs = totalDurations[timer] * 1000. / totalCalls[timer];
+    double meanDurationMs;
+    {
+      std::lock_guard<std::mutex> lock(timersMutex);
+      meanDurationMs = totalDurations[timer] * 1000. / totalCalls[timer];
+    }
     SET_COUT_FIXED_PRECISION(nbDigits);
     PRINT_COLOR(CYAN, "  -> " << timer << " took : " << currentDuration * 1000. << " ms (average : " << meanDurationMs << " ms)");
     RESET_COUT_FIXED_PRECISION;
@@ -158,7 +168,11 @@ namespace Timer
   //----------------------------------------------------------------------------
   void Display(const std::string& timer, int nbDigits)
   {
-    double meanDurationMs = totalDurations[timer] * 1000. / totalCalls[timer];
+    double meanDurationMs;
+    {
+      std::lock_guard<std::mutex> lock(timersMutex);
+      meanDurationMs = totalDurations[timer] * 1000. / totalCalls[timer];
+    }
     SET_COUT_FIXED_PRECISION(nbDigits);
     PRINT_COLOR(CYAN, "  -> " << timer << " took in average : " << meanDurationMs << " ms");
     RESET_COUT_FIXED_PRECISION;